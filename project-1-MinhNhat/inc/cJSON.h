@@ -120,6 +120,12 @@ typedef struct cJSON
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* Vector of the children for O(1) GetArraySize/GetArrayItem, filled by the parser or
+     * cJSON_BuildIndex. Managed by cJSON; code that relinks next/prev/child by hand must
+     * call cJSON_InvalidateIndex. */
+    struct cJSON **child_index;
+    int child_count;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -143,6 +149,21 @@ typedef int cJSON_bool;
 #define CJSON_CIRCULAR_LIMIT 10000
 #endif
 
+/* Arrays (and objects) with at least this many children are indexed when they
+ * are parsed or passed to cJSON_BuildIndex, smaller ones are simply walked.
+ * The index is built and freed only through non-const calls: the const getters
+ * just read it, so any number of threads may call them on a tree nobody is
+ * modifying.
+ *
+ * A stale index is detected only by comparing its first and last entries with
+ * the list's current first and last child. Inserting, removing or swapping
+ * children in the middle of the list by editing next/prev directly goes
+ * unnoticed, and GetArraySize/GetArrayItem then return the old children:
+ * call cJSON_InvalidateIndex after such edits. */
+#ifndef CJSON_INDEX_MIN
+#define CJSON_INDEX_MIN 16
+#endif
+
 /* returns the version of cJSON as a string */
 CJSON_PUBLIC(const char*) cJSON_Version(void);
 
@@ -174,6 +195,12 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *item);
 CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array);
 /* Retrieve item number "index" from array "array". Returns NULL if unsuccessful. */
 CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index);
+/* Index the children of an array/object so GetArraySize/GetArrayItem on it are O(1)
+ * until it is next changed. Parsed lists already are; this is for lists built or
+ * changed through the API. Returns true if the array is indexed afterwards. */
+CJSON_PUBLIC(cJSON_bool) cJSON_BuildIndex(cJSON *array);
+/* Drop the cached index of an array/object after relinking its children directly. */
+CJSON_PUBLIC(void) cJSON_InvalidateIndex(cJSON *item);
 /* Get item "string" from object. Case insensitive. */
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string);
@@ -0,0 +1,23 @@
+#ifndef MEM_TRACK_H
+#define MEM_TRACK_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* Counting allocator: tracks live and peak heap bytes of everything
+ * allocated through it. Install it into cJSON with mem_track_install(). */
+void  *mem_malloc(size_t size);
+void  *mem_realloc(void *ptr, size_t size);
+void   mem_free(void *ptr);
+void   mem_track_install(void);
+
+size_t mem_live_bytes(void);
+size_t mem_peak_bytes(void);
+size_t mem_peak_rss_bytes(void);
+
+/* Per-stage report: call mem_stage_end() after each stage, then
+ * mem_report() prints live/peak heap and peak RSS of every stage. */
+void   mem_stage_end(const char *stage);
+void   mem_report(FILE *f);
+
+#endif /* MEM_TRACK_H */
@@ -0,0 +1,33 @@
+#ifndef PEOPLE_STREAM_H
+#define PEOPLE_STREAM_H
+
+#include <stdio.h>
+#include "person.h"
+
+#define PEOPLE_STREAM_BUF_SIZE (64 * 1024)
+
+/* Streaming loader for a top-level array of people: reads the file through
+ * one fixed buffer and fills person_t straight from the "Name", "Address"
+ * and "Age" keys (matched case-insensitively, first one wins, as
+ * cJSON_GetObjectItem does), skipping every other key and non-object
+ * elements. No tree is built, so memory stays constant whatever the size
+ * of the file. Missing or mistyped fields get the same defaults as the
+ * cJSON path: "Unknown" and age 0. */
+typedef struct {
+    FILE          *f;
+    unsigned char *buf;
+    size_t         pos;
+    size_t         len;
+    long long      consumed;  /* bytes before buf, for error offsets */
+    int            started;
+    int            done;
+} people_stream_t;
+
+int  people_stream_open(people_stream_t *s, const char *path);
+
+/* 1 = *p filled, 0 = end of array, -1 = malformed JSON (message on stderr) */
+int  people_stream_next(people_stream_t *s, person_t *p);
+
+void people_stream_close(people_stream_t *s);
+
+#endif /* PEOPLE_STREAM_H */
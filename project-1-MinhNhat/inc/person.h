@@ -0,0 +1,20 @@
+#ifndef PERSON_H
+#define PERSON_H
+
+#include <stdint.h>
+
+#define NAME_LEN 33
+#define ADDR_LEN 257
+
+typedef struct {
+    char    name[NAME_LEN];
+    char    address[ADDR_LEN];
+    uint8_t age;
+    int8_t  age_code;
+} person_t;
+
+static inline int8_t age_to_code(int age) {
+    return (age >= 18 && age <= 40) ? (int8_t)(age - 18) : -1;
+}
+
+#endif /* PERSON_H */
@@ -0,0 +1,61 @@
+#ifndef PERSON_TABLE_H
+#define PERSON_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "person.h"
+
+/* Compact record: 32-bit offsets into the table's string arena instead of
+ * the fixed NAME_LEN/ADDR_LEN arrays of person_t (12 bytes vs ~292). */
+typedef struct {
+    uint32_t name;
+    uint32_t address;   /* equal addresses share one offset */
+    uint8_t  age;
+    int8_t   age_code;
+} person_rec_t;
+
+/* Slot of the address interning table: open addressing, at most half full,
+ * offset 0 marks an empty slot (the arena starts with the empty string). */
+typedef struct {
+    uint32_t hash;
+    uint32_t offset;
+} person_intern_t;
+
+/* Growable table of people: records in one array, names and addresses as
+ * NUL-terminated strings in one arena, addresses deduplicated through a
+ * hash table. Strings are truncated to NAME_LEN - 1 / ADDR_LEN - 1 bytes
+ * like person_t, so person_table_get() gives back what was stored there. */
+typedef struct {
+    person_rec_t    *recs;
+    size_t           count;
+    size_t           cap;
+    char            *arena;
+    size_t           arena_len;
+    size_t           arena_cap;
+    person_intern_t *slots;
+    size_t           slot_cap;
+    size_t           addresses;   /* distinct addresses */
+} person_table_t;
+
+void person_table_init(person_table_t *t);
+
+/* 1 = added, 0 = out of memory or arena past 4 GB (message on stderr) */
+int  person_table_add(person_table_t *t, const char *name, const char *address, int age);
+
+/* Expand record i into a person_t */
+void person_table_get(const person_table_t *t, size_t i, person_t *p);
+
+static inline const char *person_table_name(const person_table_t *t, size_t i) {
+    return t->arena + t->recs[i].name;
+}
+
+static inline const char *person_table_address(const person_table_t *t, size_t i) {
+    return t->arena + t->recs[i].address;
+}
+
+/* Heap bytes held by the table (records, arena and interning slots) */
+size_t person_table_bytes(const person_table_t *t);
+
+void person_table_free(person_table_t *t);
+
+#endif /* PERSON_TABLE_H */
@@ -3,19 +3,37 @@
 #include <string.h>
 #include <stdint.h>
 #include "cJSON.h"
+#include "mem_track.h"
+#include "person.h"
+#include "people_stream.h"
+#include "person_table.h"
 
-#define NAME_LEN 33
-#define ADDR_LEN 257
+static person_table_t table;
+static int table_on;
 
-typedef struct {
-    char    name[NAME_LEN];
-    char    address[ADDR_LEN];
-    uint8_t age;
-    int8_t  age_code;
-} person_t;
+static void print_person(const person_t *p) {
+    printf("%s | %s | age=%u | code=%d\n",
+           p->name, p->address, p->age, p->age_code);
+}
+
+/* Print now, or with --table keep the person for print_table() */
+static int emit_person(const person_t *p) {
+    if (!table_on) { print_person(p); return 1; }
+    return person_table_add(&table, p->name, p->address, p->age);
+}
 
-static int8_t age_to_code(int age) {
-    return (age >= 18 && age <= 40) ? (int8_t)(age - 18) : -1;
+/* --table: everyone is loaded first, then printed from the table */
+static void print_table(int mem_report_on) {
+    person_t p;
+    for (size_t i = 0; i < table.count; ++i) {
+        person_table_get(&table, i, &p);
+        print_person(&p);
+    }
+    if (mem_report_on)
+        fprintf(stderr, "table: %zu people, %zu distinct addresses, %zu bytes\n",
+                table.count, table.addresses, person_table_bytes(&table));
+    person_table_free(&table);
+    mem_stage_end("print");
 }
 
 static char* read_all(const char *path) {
@@ -25,33 +43,66 @@ static char* read_all(const char *path) {
     long sz = ftell(f);
     if (sz < 0) { fclose(f); return NULL; }
     rewind(f);
-    char *buf = (char*)malloc((size_t)sz + 1);
+    char *buf = (char*)mem_malloc((size_t)sz + 1);
     if (!buf) { fclose(f); return NULL; }
     size_t n = fread(buf, 1, (size_t)sz, f);
     fclose(f);
-    if (n != (size_t)sz) { free(buf); return NULL; }
+    if (n != (size_t)sz) { mem_free(buf); return NULL; }
     buf[sz] = '\0';
     return buf;
 }
 
-int main(void) {
+/* --stream: one person at a time through a fixed buffer, no cJSON tree */
+static int run_stream(const char *path) {
+    people_stream_t s;
+    if (!people_stream_open(&s, path)) {
+        fprintf(stderr, "ERROR: data.json not found\n");
+        return 1;
+    }
+    person_t p;
+    int r;
+    while ((r = people_stream_next(&s, &p)) == 1)
+        if (!emit_person(&p)) { r = -1; break; }
+    people_stream_close(&s);
+    mem_stage_end("stream");
+    return r < 0;
+}
+
+int main(int argc, char **argv) {
+    int mem_report_on = 0, stream_on = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--mem") == 0) mem_report_on = 1;
+        else if (strcmp(argv[i], "--stream") == 0) stream_on = 1;
+        else if (strcmp(argv[i], "--table") == 0) table_on = 1;
+    }
+    mem_track_install();
+
+    if (stream_on) {
+        int rc = run_stream("data/data.json");
+        if (table_on) print_table(mem_report_on);
+        if (mem_report_on) mem_report(stderr);
+        return rc;
+    }
 
     char *json_text = read_all("data/data.json");
     if (!json_text) {
         fprintf(stderr, "ERROR: data.json not found\n");
         return 1;
     }
+    mem_stage_end("read");
 
 
     cJSON *root = cJSON_Parse(json_text);
     if (!root || !cJSON_IsArray(root)) {
         fprintf(stderr, "ERROR: invalid JSON (expected array)\n");
         cJSON_Delete(root);
-        free(json_text);
+        mem_free(json_text);
         return 1;
     }
+    mem_stage_end("parse");
 
 
+    int rc = 0;
     int total = cJSON_GetArraySize(root);
     for (int i = 0; i < total; ++i) {
         cJSON *obj = cJSON_GetArrayItem(root, i);
@@ -72,11 +123,17 @@ int main(void) {
         p.age = (uint8_t)age;
         p.age_code = age_to_code(age);
 
-        printf("%s | %s | age=%u | code=%d\n",
-               p.name, p.address, p.age, p.age_code);
+        if (!emit_person(&p)) { rc = 1; break; }
     }
 
+    mem_stage_end("process");
+
     cJSON_Delete(root);
-    free(json_text);
-    return 0;
+    mem_free(json_text);
+    mem_stage_end("cleanup");
+
+    if (table_on) print_table(mem_report_on);
+
+    if (mem_report_on) mem_report(stderr);
+    return rc;
 }
@@ -270,6 +270,10 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
             global_hooks.deallocate(item->string);
             item->string = NULL;
         }
+        if (item->child_index != NULL)
+        {
+            global_hooks.deallocate(item->child_index);
+        }
         global_hooks.deallocate(item);
         item = next;
     }
@@ -1488,11 +1492,14 @@ static cJSON_bool print_value(const cJSON * const item, printbuffer * const outp
     }
 }
 
+static void build_index(cJSON * const array, size_t size);
+
 /* Build an array from input text. */
 static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer)
 {
     cJSON *head = NULL; /* head of the linked list */
     cJSON *current_item = NULL;
+    size_t count = 0;
 
     if (input_buffer->depth >= CJSON_NESTING_LIMIT)
     {
@@ -1546,6 +1553,7 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
             new_item->prev = current_item;
             current_item = new_item;
         }
+        count++;
 
         /* parse next value */
         input_buffer->offset++;
@@ -1573,6 +1581,12 @@ success:
     item->type = cJSON_Array;
     item->child = head;
 
+    /* the parser owns the new list, so indexing it here races with nobody */
+    if (count >= CJSON_INDEX_MIN)
+    {
+        build_index(item, count);
+    }
+
     input_buffer->offset++;
 
     return true;
@@ -1653,6 +1667,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
 {
     cJSON *head = NULL; /* linked list head */
     cJSON *current_item = NULL;
+    size_t count = 0;
 
     if (input_buffer->depth >= CJSON_NESTING_LIMIT)
     {
@@ -1704,6 +1719,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
             new_item->prev = current_item;
             current_item = new_item;
         }
+        count++;
 
         if (cannot_access_at_index(input_buffer, 1))
         {
@@ -1754,6 +1770,11 @@ success:
     item->type = cJSON_Object;
     item->child = head;
 
+    if (count >= CJSON_INDEX_MIN)
+    {
+        build_index(item, count);
+    }
+
     input_buffer->offset++;
     return true;
 
@@ -1880,6 +1901,89 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
     return true;
 }
 
+CJSON_PUBLIC(void) cJSON_InvalidateIndex(cJSON *item)
+{
+    if (item == NULL)
+    {
+        return;
+    }
+
+    if (item->child_index != NULL)
+    {
+        global_hooks.deallocate(item->child_index);
+    }
+    item->child_index = NULL;
+    item->child_count = 0;
+}
+
+/* The index is only trusted while the chain still starts and ends where it did.
+ * Mutations through the API drop it; of the changes made by hand this only
+ * catches those that move the first or last child (see cJSON_InvalidateIndex). */
+static cJSON_bool index_is_valid(const cJSON * const array)
+{
+    return (array->child_index != NULL) && (array->child != NULL)
+        && (array->child_index[0] == array->child)
+        && (array->child_index[array->child_count - 1] == array->child->prev);
+}
+
+/* Cache the children of a list of known length. References share the list of
+ * another item that can change under them, so they are always walked. */
+static void build_index(cJSON * const array, size_t size)
+{
+    cJSON **index = NULL;
+    cJSON *child = NULL;
+    size_t i = 0;
+
+    if ((array->type & cJSON_IsReference) || (size == 0) || (size > INT_MAX))
+    {
+        return;
+    }
+
+    cJSON_InvalidateIndex(array);
+    index = (cJSON**)global_hooks.allocate(size * sizeof(cJSON*));
+    if (index == NULL)
+    {
+        /* out of memory, keep walking */
+        return;
+    }
+
+    for (child = array->child; (child != NULL) && (i < size); child = child->next)
+    {
+        index[i++] = child;
+    }
+
+    array->child_index = index;
+    array->child_count = (int)i;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_BuildIndex(cJSON *array)
+{
+    cJSON *child = NULL;
+    size_t size = 0;
+
+    if (array == NULL)
+    {
+        return false;
+    }
+
+    if (index_is_valid(array))
+    {
+        return true;
+    }
+
+    for (child = array->child; child != NULL; child = child->next)
+    {
+        size++;
+    }
+
+    if (size >= CJSON_INDEX_MIN)
+    {
+        build_index(array, size);
+    }
+
+    return index_is_valid(array);
+}
+
 /* Get Array size/item / object item. */
 CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
 {
@@ -1891,6 +1995,11 @@ CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
         return 0;
     }
 
+    if (index_is_valid(array))
+    {
+        return array->child_count;
+    }
+
     child = array->child;
 
     while(child != NULL)
@@ -1913,6 +2022,11 @@ static cJSON* get_array_item(const cJSON *array, size_t index)
         return NULL;
     }
 
+    if (index_is_valid(array))
+    {
+        return (index < (size_t)array->child_count) ? array->child_index[index] : NULL;
+    }
+
     current_child = array->child;
     while ((current_child != NULL) && (index > 0))
     {
@@ -2004,6 +2118,8 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
 
     memcpy(reference, item, sizeof(cJSON));
     reference->string = NULL;
+    reference->child_index = NULL;
+    reference->child_count = 0;
     reference->type |= cJSON_IsReference;
     reference->next = reference->prev = NULL;
     return reference;
@@ -2038,6 +2154,7 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
             array->child->prev = item;
         }
     }
+    cJSON_InvalidateIndex(array);
 
     return true;
 }
@@ -2268,6 +2385,7 @@ CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const it
         /* last element */
         parent->child->prev = item->prev;
     }
+    cJSON_InvalidateIndex(parent);
 
     /* make sure the detached item doesn't point anywhere anymore */
     item->prev = NULL;
@@ -2347,6 +2465,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON
     {
         newitem->prev->next = newitem;
     }
+    cJSON_InvalidateIndex(array);
     return true;
 }
 
@@ -2392,6 +2511,8 @@ CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON
         }
     }
 
+    cJSON_InvalidateIndex(parent);
+
     item->next = NULL;
     item->prev = NULL;
     cJSON_Delete(item);
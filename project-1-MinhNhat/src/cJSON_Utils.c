@@ -262,6 +262,11 @@ CJSON_PUBLIC(char *) cJSONUtils_FindPointerFromObjectTo(const cJSON * const obje
 static cJSON *get_array_item(const cJSON *array, size_t item)
 {
     cJSON *child = array ? array->child : NULL;
+    if (item <= INT_MAX)
+    {
+        /* indexed lookup for long arrays */
+        return cJSON_GetArrayItem(array, (int)item);
+    }
     while ((child != NULL) && (item > 0))
     {
         item--;
@@ -420,6 +425,7 @@ static cJSON *detach_item_from_array(cJSON *array, size_t which)
     {
         array->child->prev = c->prev;
     }
+    cJSON_InvalidateIndex(array);
     /* make sure the detached item doesn't point anywhere anymore */
     c->prev = c->next = NULL;
 
@@ -599,6 +605,7 @@ static void sort_object(cJSON * const object, const cJSON_bool case_sensitive)
         return;
     }
     object->child = sort_list(object->child, case_sensitive);
+    cJSON_InvalidateIndex(object);
 }
 
 static cJSON_bool compare_json(cJSON *a, cJSON *b, const cJSON_bool case_sensitive)
@@ -723,6 +730,7 @@ static cJSON_bool insert_item_in_array(cJSON *array, size_t which, cJSON *newite
     {
         newitem->prev->next = newitem;
     }
+    cJSON_InvalidateIndex(array);
 
     return 1;
 }
@@ -800,8 +808,12 @@ static void overwrite_item(cJSON * const root, const cJSON replacement)
     {
         cJSON_Delete(root->child);
     }
+    cJSON_InvalidateIndex(root);
 
     memcpy(root, &replacement, sizeof(cJSON));
+    /* never share the replacement's index, the replacement itself is freed */
+    root->child_index = NULL;
+    root->child_count = 0;
 }
 
 static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_sensitive)
@@ -840,7 +852,7 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
     {
         if (opcode == REMOVE)
         {
-            static const cJSON invalid = { NULL, NULL, NULL, cJSON_Invalid, NULL, 0, 0, NULL};
+            static const cJSON invalid = { NULL, NULL, NULL, cJSON_Invalid, NULL, 0, 0, NULL, NULL, 0};
 
             overwrite_item(object, invalid);
 
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "mem_track.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define MEM_PREFIX     16   /* size header in front of each block, keeps alignment */
+#define MEM_MAX_STAGES 16
+
+typedef struct {
+    const char *name;
+    size_t      live;
+    size_t      peak;
+    size_t      rss;
+} mem_stage_t;
+
+static size_t      live_bytes;
+static size_t      peak_bytes;
+static size_t      stage_peak;
+static mem_stage_t stages[MEM_MAX_STAGES];
+static int         stage_count;
+
+void *mem_malloc(size_t size) {
+    unsigned char *p = (unsigned char*)malloc(size + MEM_PREFIX);
+    if (!p) return NULL;
+    memcpy(p, &size, sizeof(size));
+    live_bytes += size;
+    if (live_bytes > peak_bytes) peak_bytes = live_bytes;
+    if (live_bytes > stage_peak) stage_peak = live_bytes;
+    return p + MEM_PREFIX;
+}
+
+void *mem_realloc(void *ptr, size_t size) {
+    if (!ptr) return mem_malloc(size);
+    unsigned char *base = (unsigned char*)ptr - MEM_PREFIX;
+    size_t old;
+    memcpy(&old, base, sizeof(old));
+    unsigned char *p = (unsigned char*)realloc(base, size + MEM_PREFIX);
+    if (!p) return NULL;
+    memcpy(p, &size, sizeof(size));
+    live_bytes = live_bytes - old + size;
+    if (live_bytes > peak_bytes) peak_bytes = live_bytes;
+    if (live_bytes > stage_peak) stage_peak = live_bytes;
+    return p + MEM_PREFIX;
+}
+
+void mem_free(void *ptr) {
+    if (!ptr) return;
+    unsigned char *base = (unsigned char*)ptr - MEM_PREFIX;
+    size_t size;
+    memcpy(&size, base, sizeof(size));
+    live_bytes -= size;
+    free(base);
+}
+
+void mem_track_install(void) {
+    cJSON_Hooks hooks = { mem_malloc, mem_free };
+    cJSON_InitHooks(&hooks);
+}
+
+size_t mem_live_bytes(void) { return live_bytes; }
+size_t mem_peak_bytes(void) { return peak_bytes; }
+
+size_t mem_peak_rss_bytes(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return (size_t)pmc.PeakWorkingSetSize;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return (size_t)ru.ru_maxrss;
+#else
+    return (size_t)ru.ru_maxrss * 1024u;
+#endif
+#endif
+}
+
+void mem_stage_end(const char *stage) {
+    if (stage_count < MEM_MAX_STAGES) {
+        mem_stage_t *s = &stages[stage_count++];
+        s->name = stage;
+        s->live = live_bytes;
+        s->peak = stage_peak;
+        s->rss  = mem_peak_rss_bytes();
+    }
+    stage_peak = live_bytes;
+}
+
+void mem_report(FILE *f) {
+    fprintf(f, "Memory (bytes):\n");
+    fprintf(f, "  %-10s %12s %12s %12s\n", "stage", "live", "heap peak", "rss peak");
+    for (int i = 0; i < stage_count; ++i)
+        fprintf(f, "  %-10s %12zu %12zu %12zu\n",
+                stages[i].name, stages[i].live, stages[i].peak, stages[i].rss);
+    fprintf(f, "  %-10s %12zu %12zu %12zu\n",
+            "total", live_bytes, peak_bytes, mem_peak_rss_bytes());
+}
@@ -0,0 +1,245 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mem_track.h"
+#include "people_stream.h"
+
+#define KEY_LEN 16   /* longer keys cannot match any field */
+#define NUM_LEN 64
+
+enum { FIELD_NONE, FIELD_NAME, FIELD_ADDRESS, FIELD_AGE };
+
+static int fill(people_stream_t *s) {
+    s->consumed += (long long)s->len;
+    s->pos = 0;
+    s->len = fread(s->buf, 1, PEOPLE_STREAM_BUF_SIZE, s->f);
+    return s->len > 0;
+}
+
+static int peek(people_stream_t *s) {
+    if (s->pos == s->len && !fill(s)) return EOF;
+    return s->buf[s->pos];
+}
+
+static int next(people_stream_t *s) {
+    int c = peek(s);
+    if (c != EOF) s->pos++;
+    return c;
+}
+
+static int skip_ws(people_stream_t *s) {
+    int c;
+    while ((c = peek(s)) == ' ' || c == '\t' || c == '\n' || c == '\r') s->pos++;
+    return c;
+}
+
+static int fail(people_stream_t *s, const char *what) {
+    fprintf(stderr, "ERROR: invalid JSON at byte %lld: %s\n",
+            s->consumed + (long long)s->pos, what);
+    return -1;
+}
+
+/* Store one byte if it fits; out == NULL discards the string */
+static void put(char *out, size_t cap, size_t *n, unsigned char c) {
+    if (out && *n + 1 < cap) out[(*n)++] = (char)c;
+}
+
+static int hex4(people_stream_t *s, unsigned *v) {
+    *v = 0;
+    for (int i = 0; i < 4; ++i) {
+        int c = next(s);
+        if (!isxdigit(c)) return 0;
+        *v = (*v << 4) | (unsigned)(isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
+    }
+    return 1;
+}
+
+/* Body of a string after its opening quote, unescaped into out (truncated
+ * to cap - 1 bytes like the strncpy of the cJSON path) */
+static int read_string(people_stream_t *s, char *out, size_t cap) {
+    size_t n = 0;
+    for (;;) {
+        int c = next(s);
+        if (c == EOF) return fail(s, "unterminated string");
+        if (c == '"') break;
+        if (c != '\\') { put(out, cap, &n, (unsigned char)c); continue; }
+
+        c = next(s);
+        switch (c) {
+        case '"': case '\\': case '/': put(out, cap, &n, (unsigned char)c); break;
+        case 'b': put(out, cap, &n, '\b'); break;
+        case 'f': put(out, cap, &n, '\f'); break;
+        case 'n': put(out, cap, &n, '\n'); break;
+        case 'r': put(out, cap, &n, '\r'); break;
+        case 't': put(out, cap, &n, '\t'); break;
+        case 'u': {
+            unsigned cp, lo;
+            if (!hex4(s, &cp) || (cp >= 0xDC00 && cp <= 0xDFFF)) return fail(s, "bad \\u escape");
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                if (next(s) != '\\' || next(s) != 'u' || !hex4(s, &lo) || lo < 0xDC00 || lo > 0xDFFF)
+                    return fail(s, "bad surrogate pair");
+                cp = 0x10000 + (((cp & 0x3FF) << 10) | (lo & 0x3FF));
+            }
+            if (cp < 0x80) {
+                put(out, cap, &n, (unsigned char)cp);
+            } else if (cp < 0x800) {
+                put(out, cap, &n, (unsigned char)(0xC0 | (cp >> 6)));
+                put(out, cap, &n, (unsigned char)(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                put(out, cap, &n, (unsigned char)(0xE0 | (cp >> 12)));
+                put(out, cap, &n, (unsigned char)(0x80 | ((cp >> 6) & 0x3F)));
+                put(out, cap, &n, (unsigned char)(0x80 | (cp & 0x3F)));
+            } else {
+                put(out, cap, &n, (unsigned char)(0xF0 | (cp >> 18)));
+                put(out, cap, &n, (unsigned char)(0x80 | ((cp >> 12) & 0x3F)));
+                put(out, cap, &n, (unsigned char)(0x80 | ((cp >> 6) & 0x3F)));
+                put(out, cap, &n, (unsigned char)(0x80 | (cp & 0x3F)));
+            }
+            break;
+        }
+        default:
+            return fail(s, "bad escape");
+        }
+    }
+    if (out) out[n] = '\0';
+    return 1;
+}
+
+static int read_number(people_stream_t *s, double *v) {
+    char num[NUM_LEN];
+    size_t n = 0;
+    int c;
+    while ((c = peek(s)) != EOF && (isdigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')) {
+        if (n + 1 >= sizeof(num)) return fail(s, "number too long");
+        num[n++] = (char)c;
+        s->pos++;
+    }
+    num[n] = '\0';
+    char *end;
+    *v = strtod(num, &end);
+    return (n > 0 && *end == '\0') ? 1 : fail(s, "bad number");
+}
+
+/* Skip any value: strings, nested containers (tracking depth) and literals */
+static int skip_value(people_stream_t *s) {
+    int c = skip_ws(s);
+    if (c == '"') { s->pos++; return read_string(s, NULL, 0); }
+    if (c != '{' && c != '[') {
+        int n = 0;
+        while ((c = peek(s)) != EOF && !strchr(",]} \t\r\n", c)) { s->pos++; n++; }
+        return n > 0 ? 1 : fail(s, "expected a value");
+    }
+    int depth = 0;
+    do {
+        c = next(s);
+        if (c == EOF) return fail(s, "unterminated container");
+        if (c == '"' && read_string(s, NULL, 0) < 0) return -1;
+        if (c == '{' || c == '[') depth++;
+        if (c == '}' || c == ']') depth--;
+    } while (depth > 0);
+    return 1;
+}
+
+static int field_of(const char *key) {
+    static const char *const names[] = { "name", "address", "age" };
+    for (int f = 0; f < 3; ++f) {
+        const char *a = key, *b = names[f];
+        while (*a && tolower((unsigned char)*a) == *b) { a++; b++; }
+        if (!*a && !*b) return FIELD_NAME + f;
+    }
+    return FIELD_NONE;
+}
+
+static int read_person(people_stream_t *s, person_t *p) {
+    int seen_name = 0, seen_addr = 0, seen_age = 0;
+    int age = 0;
+    strcpy(p->name, "Unknown");
+    strcpy(p->address, "Unknown");
+
+    s->pos++;  /* '{' */
+    int c = skip_ws(s);
+    if (c == '}') {
+        s->pos++;
+    } else {
+        for (;;) {
+            char key[KEY_LEN];
+            if (next(s) != '"') return fail(s, "expected a key");
+            if (read_string(s, key, sizeof(key)) < 0) return -1;
+            if (skip_ws(s) != ':') return fail(s, "expected ':'");
+            s->pos++;
+            c = skip_ws(s);
+
+            int field = field_of(key);
+            int r = 1;
+            if (field == FIELD_NAME && !seen_name) {
+                seen_name = 1;
+                if (c == '"') { s->pos++; r = read_string(s, p->name, NAME_LEN); }
+                else r = skip_value(s);
+            } else if (field == FIELD_ADDRESS && !seen_addr) {
+                seen_addr = 1;
+                if (c == '"') { s->pos++; r = read_string(s, p->address, ADDR_LEN); }
+                else r = skip_value(s);
+            } else if (field == FIELD_AGE && !seen_age) {
+                seen_age = 1;
+                if (c == '-' || isdigit(c)) {
+                    double v;
+                    r = read_number(s, &v);
+                    age = v < 0 ? 0 : v > 255 ? 255 : (int)v;
+                } else {
+                    r = skip_value(s);
+                }
+            } else {
+                r = skip_value(s);
+            }
+            if (r < 0) return -1;
+
+            c = skip_ws(s);
+            s->pos += (c != EOF);
+            if (c == '}') break;
+            if (c != ',') return fail(s, "expected ',' or '}'");
+            skip_ws(s);
+        }
+    }
+    p->age = (uint8_t)age;
+    p->age_code = age_to_code(age);
+    return 1;
+}
+
+int people_stream_open(people_stream_t *s, const char *path) {
+    memset(s, 0, sizeof(*s));
+    s->f = fopen(path, "rb");
+    if (!s->f) return 0;
+    s->buf = (unsigned char*)mem_malloc(PEOPLE_STREAM_BUF_SIZE);
+    if (!s->buf) { fclose(s->f); s->f = NULL; return 0; }
+    return 1;
+}
+
+int people_stream_next(people_stream_t *s, person_t *p) {
+    while (!s->done) {
+        int c = skip_ws(s);
+        if (!s->started) {
+            if (c != '[') return fail(s, "expected array");
+            s->pos++;
+            s->started = 1;
+            if (skip_ws(s) == ']') { s->pos++; s->done = 1; }
+            continue;
+        }
+
+        /* One element and its separator; non-objects are skipped */
+        int is_person = (c == '{');
+        if ((is_person ? read_person(s, p) : skip_value(s)) < 0) return -1;
+        c = skip_ws(s);
+        s->pos += (c != EOF);
+        if (c == ']') s->done = 1;
+        else if (c != ',') return fail(s, "expected ',' or ']'");
+        if (is_person) return 1;
+    }
+    return 0;
+}
+
+void people_stream_close(people_stream_t *s) {
+    if (s->f) fclose(s->f);
+    mem_free(s->buf);
+    s->f = NULL;
+    s->buf = NULL;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <string.h>
+#include "mem_track.h"
+#include "person_table.h"
+
+#define TABLE_MIN_RECS   1024
+#define TABLE_MIN_ARENA  (64 * 1024)
+#define TABLE_MIN_SLOTS  1024           /* power of two */
+#define TABLE_MAX_ARENA  0xFFFFFFFFu    /* offsets are 32-bit */
+
+void person_table_init(person_table_t *t) {
+    memset(t, 0, sizeof(*t));
+}
+
+static uint32_t hash_str(const char *s, size_t n) {
+    uint32_t h = 2166136261u;   /* FNV-1a */
+    for (size_t i = 0; i < n; ++i) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+/* Grow an array to hold at least need elements, doubling from min */
+static int grow(void **p, size_t *cap, size_t need, size_t min, size_t elem) {
+    if (need <= *cap) return 1;
+    size_t n = *cap ? *cap : min;
+    while (n < need) n *= 2;
+    void *q = mem_realloc(*p, n * elem);
+    if (!q) return 0;
+    *p = q;
+    *cap = n;
+    return 1;
+}
+
+/* Copy s (at most n bytes) into the arena, NUL-terminated; 0 = no room */
+static int arena_put(person_table_t *t, const char *s, size_t n, uint32_t *off) {
+    if (t->arena_len == 0) {
+        /* offset 0 is the empty string, so 0 can mark free intern slots */
+        if (!grow((void**)&t->arena, &t->arena_cap, 1, TABLE_MIN_ARENA, 1)) return 0;
+        t->arena[t->arena_len++] = '\0';
+    }
+    if (n == 0) { *off = 0; return 1; }
+    if (t->arena_len + n + 1 > TABLE_MAX_ARENA) return 0;
+    if (!grow((void**)&t->arena, &t->arena_cap, t->arena_len + n + 1, TABLE_MIN_ARENA, 1)) return 0;
+    *off = (uint32_t)t->arena_len;
+    memcpy(t->arena + t->arena_len, s, n);
+    t->arena[t->arena_len + n] = '\0';
+    t->arena_len += n + 1;
+    return 1;
+}
+
+static int rehash(person_table_t *t) {
+    size_t cap = t->slot_cap ? t->slot_cap * 2 : TABLE_MIN_SLOTS;
+    person_intern_t *slots = (person_intern_t*)mem_malloc(cap * sizeof(*slots));
+    if (!slots) return 0;
+    memset(slots, 0, cap * sizeof(*slots));
+    for (size_t i = 0; i < t->slot_cap; ++i) {
+        if (!t->slots[i].offset) continue;
+        size_t j = t->slots[i].hash & (cap - 1);
+        while (slots[j].offset) j = (j + 1) & (cap - 1);
+        slots[j] = t->slots[i];
+    }
+    mem_free(t->slots);
+    t->slots = slots;
+    t->slot_cap = cap;
+    return 1;
+}
+
+/* Offset of an address equal to s[0..n), stored on first sight */
+static int intern(person_table_t *t, const char *s, size_t n, uint32_t *off) {
+    if (n == 0) return arena_put(t, s, 0, off);
+    if ((t->addresses + 1) * 2 > t->slot_cap && !rehash(t)) return 0;
+
+    uint32_t h = hash_str(s, n);
+    size_t j = h & (t->slot_cap - 1);
+    while (t->slots[j].offset) {
+        const char *a = t->arena + t->slots[j].offset;
+        if (t->slots[j].hash == h && strncmp(a, s, n) == 0 && a[n] == '\0') {
+            *off = t->slots[j].offset;
+            return 1;
+        }
+        j = (j + 1) & (t->slot_cap - 1);
+    }
+    if (!arena_put(t, s, n, off)) return 0;
+    t->slots[j].hash = h;
+    t->slots[j].offset = *off;
+    t->addresses++;
+    return 1;
+}
+
+static size_t clamp_len(const char *s, size_t max) {
+    const char *end = memchr(s, '\0', max);
+    return end ? (size_t)(end - s) : max;
+}
+
+int person_table_add(person_table_t *t, const char *name, const char *address, int age) {
+    person_rec_t r;
+    if (!grow((void**)&t->recs, &t->cap, t->count + 1, TABLE_MIN_RECS, sizeof(*t->recs))
+        || !arena_put(t, name, clamp_len(name, NAME_LEN - 1), &r.name)
+        || !intern(t, address, clamp_len(address, ADDR_LEN - 1), &r.address)) {
+        fprintf(stderr, "ERROR: person table full (%zu people)\n", t->count);
+        return 0;
+    }
+    if (age < 0) age = 0;
+    if (age > 255) age = 255;
+    r.age = (uint8_t)age;
+    r.age_code = age_to_code(age);
+    t->recs[t->count++] = r;
+    return 1;
+}
+
+void person_table_get(const person_table_t *t, size_t i, person_t *p) {
+    const person_rec_t *r = &t->recs[i];
+    strcpy(p->name, t->arena + r->name);
+    strcpy(p->address, t->arena + r->address);
+    p->age = r->age;
+    p->age_code = r->age_code;
+}
+
+size_t person_table_bytes(const person_table_t *t) {
+    return t->cap * sizeof(*t->recs) + t->arena_cap + t->slot_cap * sizeof(*t->slots);
+}
+
+void person_table_free(person_table_t *t) {
+    mem_free(t->recs);
+    mem_free(t->arena);
+    mem_free(t->slots);
+    person_table_init(t);
+}
@@ -0,0 +1,151 @@
+/**
+ * @file alert_rules.h
+ * @brief Alert rules loaded from JSON, evaluated together in one pass
+ *
+ * A rules file is compiled into a flat table of predicates (field, operator,
+ * threshold, owning rule); a rule fires when all of its predicates hold.
+ * Each record loads only the fields the rules use, runs down the table
+ * once and collects the firing rules in a bitmask, so adding a rule costs
+ * one more compare per record instead of another scan. Fields use the
+ * validation names (see validate_field_name()) plus "sensor_id". Besides
+ * the six comparisons, "change>" holds when the field moved by more than
+ * the threshold since the sensor's previous reading, e.g. temperature
+ * spikes. NaN readings (and a missing CO2 reading, 0xFFFF) never match.
+ *
+ *   {"rules": [
+ *     {"name": "battery_emergency", "field": "battery", "op": "==", "value": "emergency"},
+ *     {"name": "co2_high", "field": "co2", "op": ">", "value": 2000},
+ *     {"name": "temperature_spike", "field": "temperature", "op": "change>", "value": 5},
+ *     {"name": "hot_and_dry", "all": [{"field": "temperature", "op": ">", "value": 35},
+ *                                     {"field": "humidity", "op": "<", "value": 20}]}
+ *   ]}
+ */
+
+#ifndef ALERT_RULES_H
+#define ALERT_RULES_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "weather_types.h"
+#include "record_validate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define ALERT_MAX_RULES   64     // Bits of the per-record firing mask
+#define ALERT_NAME_SIZE   48
+#define ALERT_SENSOR_ID   VALIDATE_FIELD_COUNT   // Field index of sensor_id
+#define ALERT_FIELD_COUNT (VALIDATE_FIELD_COUNT + 1)
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    ALERT_LT = 0,
+    ALERT_LE,
+    ALERT_GT,
+    ALERT_GE,
+    ALERT_EQ,
+    ALERT_NE,
+    ALERT_CHANGE_GT      // |value - previous value of the sensor| > threshold
+} alert_op_t;
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief One compiled comparison
+ */
+typedef struct {
+    double threshold;
+    uint8_t field;       // validate_field_t or ALERT_SENSOR_ID
+    uint8_t op;          // alert_op_t
+    uint8_t rule;        // Index of the owning rule
+} alert_pred_t;
+
+/**
+ * @brief Previous readings of one sensor, for "change>" (one hash table slot)
+ */
+typedef struct {
+    uint32_t sensor_id;
+    uint32_t used;
+    double last[ALERT_FIELD_COUNT];  // NaN until the first reading
+} alert_sensor_t;
+
+/**
+ * @brief Compiled rule set
+ */
+typedef struct {
+    char names[ALERT_MAX_RULES][ALERT_NAME_SIZE];
+    uint64_t fired[ALERT_MAX_RULES];
+    uint8_t first_field[ALERT_MAX_RULES];  // Field reported as "value" in events
+    size_t n_rules;
+    alert_pred_t *preds;
+    size_t n_preds;
+    uint32_t used_fields;        // Bit per field loaded from each record
+    uint32_t change_fields;      // Bit per field tracked per sensor
+    alert_sensor_t *slots;       // Open addressing, at most half full (only with change_fields)
+    size_t capacity;
+    size_t sensors;
+    FILE *events;                // JSON lines of alerts, or NULL
+    uint64_t records;
+    uint64_t alerts;
+} alert_rules_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Load and compile a rules file
+ * 
+ * @param ar Rule set to fill
+ * @param path Rules file (JSON)
+ * @param events Stream for alert events (JSON lines), or NULL to only count
+ * 
+ * @return 1 on success, 0 on error (with error message)
+ */
+int alert_rules_load(alert_rules_t *ar, const char *path, FILE *events);
+
+/**
+ * @brief Evaluate every rule against a decoded batch
+ * 
+ * @param ar Rule set
+ * @param records Decoded records
+ * @param n Number of records
+ * @param first_ordinal Output position of records[0], reported in events
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int alert_rules_eval_batch(alert_rules_t *ar, const weather_record_t *records, size_t n,
+                           uint64_t first_ordinal);
+
+/**
+ * @brief Print the number of alerts per rule
+ * 
+ * @param ar Rule set
+ * @param f Output stream
+ */
+void alert_rules_print_summary(const alert_rules_t *ar, FILE *f);
+
+/**
+ * @brief Release the rule set (the events stream is not closed)
+ * 
+ * @param ar Rule set
+ */
+void alert_rules_free(alert_rules_t *ar);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALERT_RULES_H
\ No newline at end of file
@@ -0,0 +1,115 @@
+/**
+ * @file bin_writer.h
+ * @brief Batched writer for packed binary weather files
+ */
+
+#ifndef BIN_WRITER_H
+#define BIN_WRITER_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdint.h>
+#include "weather_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define WRITE_BATCH_RECORDS 1024
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Output .bin file being written
+ * 
+ * Records are encoded into a batch buffer and written WRITE_BATCH_RECORDS
+ * at a time. The header is written as a placeholder on open and patched
+ * with the final record count on close.
+ */
+typedef struct {
+    FILE *f;
+    file_header_t header;
+    uint8_t *batch;
+    uint32_t batch_count;
+    uint64_t bytes_written;
+    int raw;      // Attached stream without header, see bin_writer_attach()
+    int error;
+} bin_writer_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Create an output file and write a placeholder header
+ * 
+ * @param w Writer to initialize
+ * @param path Output file path
+ * @param header Header to write (count is ignored and filled in on close)
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int bin_writer_open(bin_writer_t *w, const char *path, const file_header_t *header);
+
+/**
+ * @brief Write header-less packed records to an already open stream
+ * 
+ * Used for temp files (e.g. sort runs). bin_writer_close() flushes but
+ * neither patches a header nor closes the stream.
+ * 
+ * @param w Writer to initialize
+ * @param f Open binary stream
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int bin_writer_attach(bin_writer_t *w, FILE *f);
+
+/**
+ * @brief Append one record
+ * 
+ * @param w Writer
+ * @param record Record to append
+ * 
+ * @return 1 on success, 0 on failure (every later write fails too)
+ */
+int bin_writer_write(bin_writer_t *w, const weather_record_t *record);
+
+/**
+ * @brief Append one record that is already in packed form
+ * 
+ * @param w Writer
+ * @param packed RECORD_SIZE bytes of packed record data
+ * 
+ * @return 1 on success, 0 on failure (every later write fails too)
+ */
+int bin_writer_write_packed(bin_writer_t *w, const uint8_t *packed);
+
+/**
+ * @brief Flush pending records, patch the header count and close the file
+ * 
+ * @param w Writer
+ * 
+ * @return 1 on success, 0 if any write failed
+ */
+int bin_writer_close(bin_writer_t *w);
+
+/**
+ * @brief Encode a file header into packed binary form
+ * 
+ * @param buf Pointer to HEADER_SIZE bytes of output
+ * @param header Header to encode
+ */
+void encode_file_header(uint8_t *buf, const file_header_t *header);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BIN_WRITER_H
\ No newline at end of file
@@ -10,6 +10,7 @@
  *    INCLUDES
  *********************/
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -70,6 +71,108 @@ int read_f32_le(float *out, FILE *f);
  */
 int read_f64_le(double *out, FILE *f);
 
+/**
+ * @brief Load 16-bit unsigned integer (little-endian) from a memory buffer
+ * 
+ * @param p Pointer to at least 2 bytes
+ * 
+ * @return Decoded value
+ */
+uint16_t load_u16_le(const uint8_t *p);
+
+/**
+ * @brief Load 32-bit unsigned integer (little-endian) from a memory buffer
+ * 
+ * @param p Pointer to at least 4 bytes
+ * 
+ * @return Decoded value
+ */
+uint32_t load_u32_le(const uint8_t *p);
+
+/**
+ * @brief Load 32-bit float (little-endian, IEEE-754) from a memory buffer
+ * 
+ * @param p Pointer to at least 4 bytes
+ * 
+ * @return Decoded value
+ */
+float load_f32_le(const uint8_t *p);
+
+/**
+ * @brief Load 64-bit double (little-endian, IEEE-754) from a memory buffer
+ * 
+ * @param p Pointer to at least 8 bytes
+ * 
+ * @return Decoded value
+ */
+double load_f64_le(const uint8_t *p);
+
+/**
+ * @brief Store 16-bit unsigned integer (little-endian) into a memory buffer
+ * 
+ * @param p Pointer to at least 2 bytes
+ * @param v Value to store
+ */
+void store_u16_le(uint8_t *p, uint16_t v);
+
+/**
+ * @brief Store 32-bit unsigned integer (little-endian) into a memory buffer
+ * 
+ * @param p Pointer to at least 4 bytes
+ * @param v Value to store
+ */
+void store_u32_le(uint8_t *p, uint32_t v);
+
+/**
+ * @brief Store 32-bit float (little-endian, IEEE-754) into a memory buffer
+ * 
+ * @param p Pointer to at least 4 bytes
+ * @param v Value to store
+ */
+void store_f32_le(uint8_t *p, float v);
+
+/**
+ * @brief Store 64-bit double (little-endian, IEEE-754) into a memory buffer
+ * 
+ * @param p Pointer to at least 8 bytes
+ * @param v Value to store
+ */
+void store_f64_le(uint8_t *p, double v);
+
+/**
+ * @brief Load n 16-bit little-endian values spaced stride bytes apart
+ * 
+ * Bulk loads are dispatched at runtime to a scalar, SSE4.2, AVX2 or
+ * AVX-512 implementation, see cpu_dispatch.h. They gather one field
+ * out of a batch of packed records (stride = RECORD_SIZE).
+ * 
+ * @param dst Destination array of n values
+ * @param src Pointer to the first value
+ * @param stride Distance between consecutive values in bytes (>= 2)
+ * @param n Number of values
+ */
+void load_u16_le_strided(uint16_t *dst, const uint8_t *src, size_t stride, size_t n);
+
+/**
+ * @brief Load n 32-bit little-endian values spaced stride bytes apart
+ * 
+ * @param dst Destination array of n values
+ * @param src Pointer to the first value
+ * @param stride Distance between consecutive values in bytes (>= 4)
+ * @param n Number of values
+ */
+void load_u32_le_strided(uint32_t *dst, const uint8_t *src, size_t stride, size_t n);
+
+/**
+ * @brief Load n 64-bit little-endian values spaced stride bytes apart
+ * 
+ * @param dst Destination array of n values
+ * @param src Pointer to the first value
+ * @param stride Distance between consecutive values in bytes (>= 8)
+ * @param n Number of values
+ */
+void load_u64_le_strided(uint64_t *dst, const uint8_t *src, size_t stride, size_t n);
+
 #ifdef __cplusplus
 }
 #endif
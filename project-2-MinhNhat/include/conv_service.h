@@ -0,0 +1,63 @@
+/**
+ * @file conv_service.h
+ * @brief Long-running conversion service over a Unix domain socket
+ *
+ * Protocol: the client connects, sends one tab-separated request line
+ *
+ *     CONVERT <format> <filters> <input_path> <output_path>\n
+ *
+ * and reads back one response line, then the connection is closed.
+ * format is "json" (binary -> JSON) or "bin" (JSON -> binary); filters is
+ * "-" or a comma-separated list ("dedup", "derived", "iso-time"); the
+ * filters only apply to "json", a "bin" job with filters is rejected. Paths
+ * are resolved by the service, so clients should send absolute paths. The
+ * response is
+ *
+ *     OK queue_ns=<n> {conv_stats JSON}\n    or    ERR <message>\n
+ *
+ * The stats JSON leaves out the heap/RSS fields, which are process-wide.
+ */
+
+#ifndef CONV_SERVICE_H
+#define CONV_SERVICE_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define CONV_SERVICE_DEFAULT_SOCKET "/tmp/weather_parser.sock"
+#define CONV_SERVICE_MAX_LINE       8192
+#define CONV_SERVICE_QUEUE_DEPTH    256
+#define CONV_SERVICE_READ_TIMEOUT_SEC 30   // Wait for the request line before dropping a client
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Listen on a Unix socket and run conversion jobs until SIGINT/SIGTERM
+ * 
+ * Each worker thread keeps its own parse_workspace_t, so batch and output
+ * buffers stay allocated (and cache-warm) across jobs. One line of per-job
+ * stats is logged to stdout as jobs complete.
+ * 
+ * @param socket_path Filesystem path of the socket (a stale file is replaced)
+ * @param n_workers Number of worker threads (0 = one per CPU)
+ * 
+ * @return 0 on clean shutdown, non-zero on error
+ */
+int conv_service_run(const char *socket_path, int n_workers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONV_SERVICE_H
\ No newline at end of file
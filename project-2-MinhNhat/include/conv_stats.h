@@ -0,0 +1,125 @@
+/**
+ * @file conv_stats.h
+ * @brief Per-stage timing and counters for a conversion run
+ */
+
+#ifndef CONV_STATS_H
+#define CONV_STATS_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    STAGE_READ = 0,
+    STAGE_DECODE,
+    STAGE_VALIDATE,
+    STAGE_ANALYZE,
+    STAGE_WRITE,
+    STAGE_COUNT
+} conv_stage_t;
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Counters collected while converting one file
+ * 
+ * Timers and memory are only sampled once per batch, and only when the
+ * caller passes a stats pointer, so disabled stats cost a NULL check per
+ * batch. Heap numbers cover allocations made through mem_track.h.
+ */
+typedef struct {
+    uint64_t stage_ns[STAGE_COUNT];
+    uint64_t stage_heap_peak[STAGE_COUNT];
+    uint64_t stage_rss_peak[STAGE_COUNT];
+    uint64_t heap_peak_bytes;
+    uint64_t rss_peak_bytes;
+    uint64_t total_ns;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t records;
+    uint64_t short_reads;
+    uint64_t duplicates;
+    uint64_t anomalies;
+    uint64_t invalid;
+} conv_stats_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Read the monotonic clock
+ * 
+ * @return Nanoseconds since an arbitrary fixed point
+ */
+uint64_t stats_now_ns(void);
+
+/**
+ * @brief Close the current stage: add elapsed time and sample memory
+ * 
+ * @param stats Stats to update
+ * @param stage Stage that just finished
+ * @param t_mark In: start of the stage, out: start of the next stage
+ */
+void conv_stats_end_stage(conv_stats_t *stats, conv_stage_t stage, uint64_t *t_mark);
+
+/**
+ * @brief Get the display name of a stage
+ * 
+ * @param stage Stage identifier
+ * 
+ * @return Stage name ("read", "decode", ...)
+ */
+const char* conv_stage_name(conv_stage_t stage);
+
+/**
+ * @brief Print stats as a human readable table
+ * 
+ * @param stats Collected stats
+ * @param f Output file pointer
+ */
+void conv_stats_print(const conv_stats_t *stats, FILE *f);
+
+/**
+ * @brief Print stats as a single JSON line (for log collectors)
+ * 
+ * @param stats Collected stats
+ * @param input_file Input path, included in the line
+ * @param output_file Output path, included in the line
+ * @param f Output file pointer
+ */
+void conv_stats_print_json(const conv_stats_t *stats, const char *input_file,
+                           const char *output_file, FILE *f);
+
+/**
+ * @brief Print stats as a single JSON line, optionally without memory fields
+ * 
+ * The heap and RSS counters are process-wide, so they say nothing about one
+ * job when several run concurrently in the same process.
+ * 
+ * @param stats Collected stats
+ * @param input_file Input path, included in the line
+ * @param output_file Output path, included in the line
+ * @param with_memory Include the *_heap_peak, *_rss_peak, heap_peak and rss_peak fields
+ * @param f Output file pointer
+ */
+void conv_stats_print_json_ex(const conv_stats_t *stats, const char *input_file,
+                              const char *output_file, int with_memory, FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONV_STATS_H
\ No newline at end of file
@@ -0,0 +1,92 @@
+/**
+ * @file cpu_dispatch.h
+ * @brief Runtime CPU feature detection for SIMD kernel selection
+ */
+
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+// x86 SIMD kernels are built with per-function target attributes (GCC/Clang)
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #define SIMD_X86 1
+#else
+  #define SIMD_X86 0
+#endif
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    SIMD_SCALAR = 0,
+    SIMD_SSE42,
+    SIMD_AVX2,
+    SIMD_AVX512,
+    SIMD_LEVEL_COUNT
+} simd_level_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Detect the best SIMD level supported by CPU and OS (cpuid/xgetbv)
+ * 
+ * @return Highest usable level
+ */
+simd_level_t cpu_detect_simd_level(void);
+
+/**
+ * @brief Get the level kernels should use
+ * 
+ * Detection runs once; the result is capped by the WEATHER_SIMD_LEVEL
+ * build option and by simd_set_level().
+ * 
+ * @return Active SIMD level
+ */
+simd_level_t simd_level(void);
+
+/**
+ * @brief Lower (or restore) the active SIMD level at runtime
+ * 
+ * @param level Requested level, capped to what the CPU supports
+ * 
+ * @return Level actually selected
+ */
+simd_level_t simd_set_level(simd_level_t level);
+
+/**
+ * @brief Get the display name of a SIMD level
+ * 
+ * @param level SIMD level
+ * 
+ * @return Level name ("scalar", "sse4.2", "avx2", "avx512")
+ */
+const char* simd_level_name(simd_level_t level);
+
+/**
+ * @brief Parse a SIMD level name as printed by simd_level_name()
+ * 
+ * @param name Level name
+ * @param out Pointer to store the level
+ * 
+ * @return 1 on success, 0 if the name is unknown
+ */
+int simd_level_from_name(const char *name, simd_level_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CPU_DISPATCH_H
\ No newline at end of file
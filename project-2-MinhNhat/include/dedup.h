@@ -0,0 +1,108 @@
+/**
+ * @file dedup.h
+ * @brief Duplicate (sensor_id, timestamp) detection for packed records
+ */
+
+#ifndef DEDUP_H
+#define DEDUP_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define DEDUP_DEFAULT_MEM_LIMIT (256u * 1024u * 1024u)
+#define DEDUP_MAX_PARTITIONS 256
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Open-addressing hash set of 64-bit record keys
+ * 
+ * Linear probing over a power-of-two table kept at most half full.
+ * Key 0 marks an empty slot, so the (0, 0) key is tracked by a flag.
+ */
+typedef struct {
+    uint64_t *slots;
+    size_t capacity;
+    size_t size;
+    int has_zero;
+} dedup_set_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Initialize a set sized for an expected number of keys
+ * 
+ * @param set Set to initialize
+ * @param expected Expected number of distinct keys (grows if exceeded)
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int dedup_set_init(dedup_set_t *set, size_t expected);
+
+/**
+ * @brief Insert a key
+ * 
+ * @param set Set
+ * @param key Key to insert
+ * 
+ * @return 1 if the key is new, 0 if it was already present, -1 on out of memory
+ */
+int dedup_set_insert(dedup_set_t *set, uint64_t key);
+
+/**
+ * @brief Release the set
+ * 
+ * @param set Set
+ */
+void dedup_set_free(dedup_set_t *set);
+
+/**
+ * @brief Memory an in-memory set needs for a number of keys
+ * 
+ * @param keys Number of keys
+ * 
+ * @return Table size in bytes
+ */
+size_t dedup_set_bytes(size_t keys);
+
+/**
+ * @brief Mark duplicate records of a file using spilled key partitions
+ * 
+ * Used when the set for the whole file does not fit in memory. Keys
+ * and ordinals are spilled to temp files partitioned by key hash, then
+ * each partition is deduplicated on its own. Bit i of dup_bitmap is set
+ * when record i repeats an earlier record, so the first occurrence
+ * wins and record order is kept.
+ * 
+ * @param fin Input file positioned anywhere (restored on return)
+ * @param data_offset Offset of the first packed record
+ * @param count Number of records
+ * @param partitions Number of partitions (1..DEDUP_MAX_PARTITIONS)
+ * @param dup_bitmap Zeroed bitmap of (count + 7) / 8 bytes
+ * @param dups Pointer to store the number of duplicates found
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int dedup_mark_partitioned(FILE *fin, long data_offset, uint32_t count, unsigned partitions,
+                           uint8_t *dup_bitmap, uint64_t *dups);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEDUP_H
\ No newline at end of file
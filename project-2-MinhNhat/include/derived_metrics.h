@@ -0,0 +1,67 @@
+/**
+ * @file derived_metrics.h
+ * @brief Dew point, heat index and wind components computed per batch
+ *
+ * The stage gathers a chunk of decoded records into per-field float
+ * lanes and runs one dispatched kernel over them (see cpu_dispatch.h).
+ * Logarithms use a short polynomial instead of libm and the wind angle
+ * comes from a per-degree sine table, so every SIMD level performs the
+ * same float operations in the same order and produces identical bits.
+ */
+
+#ifndef DERIVED_METRICS_H
+#define DERIVED_METRICS_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+#include "weather_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define DERIVED_CHUNK_RECORDS 64
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Values derived from one record
+ * 
+ * dew_point uses the Magnus formula (b = 17.62, c = 243.12 degC) and is NaN
+ * when humidity is not positive. heat_index is the NWS Rothfusz regression
+ * with its low/high humidity adjustments, falling back to Steadman's simple
+ * formula below 80 degF. wind_u/wind_v follow the meteorological convention
+ * (direction the wind blows from), so a northerly wind has negative v.
+ */
+typedef struct {
+    float dew_point;   // degC
+    float heat_index;  // degC
+    float wind_u;      // Eastward component, same unit as wind_speed
+    float wind_v;      // Northward component, same unit as wind_speed
+} derived_metrics_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Compute derived metrics for a batch of decoded records
+ * 
+ * @param out Array of at least n results
+ * @param records Decoded records
+ * @param n Number of records
+ */
+void derive_weather_batch(derived_metrics_t *out, const weather_record_t *records, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DERIVED_METRICS_H
\ No newline at end of file
@@ -0,0 +1,103 @@
+/**
+ * @file json_reader.h
+ * @brief Streaming reader for weather JSON (the schema json_writer emits)
+ */
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdint.h>
+#include "weather_types.h"
+#include "conv_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define JSON_READ_BUFFER_SIZE (64 * 1024)
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Pull reader over a weather JSON document
+ * 
+ * The input is scanned through a fixed buffer and records are produced
+ * one at a time, so memory use does not depend on the file size. No
+ * cJSON tree is built.
+ */
+typedef struct {
+    FILE *f;
+    char *buf;
+    size_t pos;
+    size_t len;
+    int eof;
+    uint64_t bytes_consumed;
+    uint64_t line;
+    file_header_t header;     // From "metadata"; defaults if absent
+    int in_records;           // Positioned inside the "records" array
+    int first_record;
+    int error;
+    char error_msg[128];
+} json_reader_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Open a JSON file and advance to the first record
+ * 
+ * Parses "metadata" if it comes before "records".
+ * 
+ * @param r Reader to initialize
+ * @param path Input JSON path
+ * 
+ * @return 1 on success, 0 on failure (see r->error_msg)
+ */
+int json_reader_open(json_reader_t *r, const char *path);
+
+/**
+ * @brief Read the next record of the "records" array
+ * 
+ * Fields are matched by precomputed key IDs; unknown keys are skipped
+ * and missing fields are left zero.
+ * 
+ * @param r Reader
+ * @param record Pointer to store the record
+ * 
+ * @return 1 if a record was read, 0 at the end of the array, -1 on error
+ */
+int json_reader_next(json_reader_t *r, weather_record_t *record);
+
+/**
+ * @brief Close the reader
+ * 
+ * @param r Reader
+ */
+void json_reader_close(json_reader_t *r);
+
+/**
+ * @brief Convert a weather JSON file back to the packed binary format
+ * 
+ * @param input_file Path to input JSON file
+ * @param output_file Path to output binary file
+ * @param stats Stats to fill in, or NULL to disable instrumentation
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int convert_json_to_bin(const char *input_file, const char *output_file, conv_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_READER_H
\ No newline at end of file
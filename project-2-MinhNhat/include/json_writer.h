@@ -11,11 +11,34 @@
  *********************/
 #include <stdio.h>
 #include "weather_types.h"
+#include "derived_metrics.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*********************
+ *      CONSTANTS
+ *********************/
+#define ISO8601_SIZE 21  // "YYYY-MM-DDThh:mm:ssZ" plus terminator
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Date part of the last ISO-8601 timestamp rendered
+ * 
+ * Records of one file are mostly from the same day, so the calendar
+ * conversion runs once per day and the time of day is plain arithmetic.
+ * Zero-initialize before first use; keep one per output stream.
+ */
+typedef struct {
+    uint32_t day;                 // Days since 1970-01-01 of date
+    int valid;
+    char date[11];                // "YYYY-MM-DDT"
+} iso_time_cache_t;
+
 /*********************
  *    FUNCTIONS
  *********************/
@@ -28,6 +51,30 @@ extern "C" {
  */
 void write_json_header(const file_header_t *header, FILE *f);
 
+/**
+ * @brief Write JSON file header whose record_count can be patched later
+ * 
+ * Used when the record count is only known after streaming: the count is
+ * written space-padded to 10 digits so it can be overwritten in place.
+ * 
+ * @param header File header structure
+ * @param f Output file pointer (must be seekable for patching)
+ * 
+ * @return File offset of the record_count digits, -1 if not seekable
+ */
+long write_json_header_patchable(const file_header_t *header, FILE *f);
+
+/**
+ * @brief Overwrite the record_count written by write_json_header_patchable
+ * 
+ * @param f Output file pointer
+ * @param offset Offset returned by write_json_header_patchable
+ * @param count Final record count
+ * 
+ * @return 0 on success, -1 on error
+ */
+int patch_json_record_count(FILE *f, long offset, uint32_t count);
+
 /**
  * @brief Write a single weather record as JSON
  * 
@@ -37,6 +84,45 @@ void write_json_header(const file_header_t *header, FILE *f);
  */
 void write_json_record(const weather_record_t *record, FILE *f, int is_last);
 
+/**
+ * @brief Write a single weather record as JSON with extra members
+ * 
+ * @param record Weather record structure
+ * @param derived Derived metrics rendered as a "derived" object after
+ *                "measurements", or NULL to omit it
+ * @param times Render timestamp as an ISO-8601 UTC string using this cache,
+ *              or NULL for Unix seconds
+ * @param invalid Pre-rendered "invalid" member (see validate_tags_json), or ""
+ * @param extra Pre-rendered members inserted after "measurements",
+ *              starting with ",\n" (e.g. the station object), or ""
+ * @param f Output file pointer
+ * @param is_last Whether this is the last record (affects comma)
+ */
+void write_json_record_extra(const weather_record_t *record, const derived_metrics_t *derived,
+                             iso_time_cache_t *times, const char *invalid, const char *extra,
+                             FILE *f, int is_last);
+
+/**
+ * @brief Render a Unix timestamp as "YYYY-MM-DDThh:mm:ssZ"
+ * 
+ * @param times Cache of the current day
+ * @param timestamp Seconds since 1970-01-01 UTC
+ * @param out Buffer of ISO8601_SIZE bytes
+ * 
+ * @return out
+ */
+const char* format_iso8601(iso_time_cache_t *times, uint32_t timestamp, char *out);
+
+/**
+ * @brief Convert days since 1970-01-01 to a civil date (proleptic Gregorian)
+ * 
+ * @param day Days since the epoch
+ * @param year Year
+ * @param month Month, 1-12
+ * @param mday Day of month, 1-31
+ */
+void civil_from_days(uint32_t day, int *year, unsigned *month, unsigned *mday);
+
 /**
  * @brief Write JSON file footer
  * 
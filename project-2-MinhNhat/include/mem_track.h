@@ -0,0 +1,108 @@
+/**
+ * @file mem_track.h
+ * @brief Counting allocator wrappers and peak RSS sampling
+ */
+
+#ifndef MEM_TRACK_H
+#define MEM_TRACK_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief malloc() that accounts the allocation in the live heap counter
+ * 
+ * Memory from mem_malloc/mem_calloc/mem_realloc must be released with
+ * mem_free, never with free().
+ * 
+ * @param size Number of bytes
+ * 
+ * @return Pointer to the allocation, or NULL on failure
+ */
+void* mem_malloc(size_t size);
+
+/**
+ * @brief calloc() counterpart of mem_malloc
+ * 
+ * @param count Number of elements
+ * @param size Size of one element
+ * 
+ * @return Pointer to zeroed memory, or NULL on failure
+ */
+void* mem_calloc(size_t count, size_t size);
+
+/**
+ * @brief realloc() counterpart of mem_malloc
+ * 
+ * @param ptr Pointer from mem_malloc (or NULL)
+ * @param size New size in bytes
+ * 
+ * @return Pointer to the resized allocation, or NULL on failure (ptr is kept)
+ */
+void* mem_realloc(void *ptr, size_t size);
+
+/**
+ * @brief free() counterpart of mem_malloc
+ * 
+ * @param ptr Pointer from mem_malloc (or NULL)
+ */
+void mem_free(void *ptr);
+
+/**
+ * @brief Get bytes currently allocated through the wrappers
+ * 
+ * @return Live heap bytes
+ */
+size_t mem_live_bytes(void);
+
+/**
+ * @brief Get the highest live heap byte count since start
+ * 
+ * @return Peak heap bytes
+ */
+size_t mem_peak_bytes(void);
+
+/**
+ * @brief Start a new measurement window for mem_window_peak_bytes()
+ */
+void mem_window_reset(void);
+
+/**
+ * @brief Get the highest live heap byte count since mem_window_reset()
+ * 
+ * @return Peak heap bytes in the current window
+ */
+size_t mem_window_peak_bytes(void);
+
+/**
+ * @brief Get the peak resident set size of the process
+ * 
+ * @return Peak RSS in bytes, or 0 if unsupported
+ */
+size_t mem_peak_rss_bytes(void);
+
+/**
+ * @brief Check peak RSS and live heap against a budget
+ * 
+ * @param budget_bytes Budget in bytes, 0 means unlimited
+ * 
+ * @return 1 if within budget, 0 if exceeded
+ */
+int mem_within_budget(size_t budget_bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_TRACK_H
\ No newline at end of file
@@ -0,0 +1,96 @@
+/**
+ * @file perf_counters.h
+ * @brief Hardware performance counters around a code region (Linux perf_event_open)
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_EVENT_COUNT
+} perf_event_id_t;
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Set of counters, one file descriptor per event
+ * 
+ * Events that cannot be opened (no PMU in a VM, perf_event_paranoid,
+ * non-Linux build) are left unavailable and simply not reported.
+ */
+typedef struct {
+    int fd[PERF_EVENT_COUNT];
+    int available[PERF_EVENT_COUNT];
+    uint64_t values[PERF_EVENT_COUNT];
+} perf_counters_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Open all counters for the calling thread (disabled until start)
+ * 
+ * @param pc Counters to initialize
+ * 
+ * @return Number of events that could be opened
+ */
+int perf_counters_open(perf_counters_t *pc);
+
+/**
+ * @brief Reset and enable all open counters
+ * 
+ * @param pc Counters
+ */
+void perf_counters_start(perf_counters_t *pc);
+
+/**
+ * @brief Disable all open counters and read them into pc->values
+ * 
+ * Values are scaled by time_enabled / time_running when the kernel
+ * had to multiplex counters.
+ * 
+ * @param pc Counters
+ */
+void perf_counters_stop(perf_counters_t *pc);
+
+/**
+ * @brief Close all counters
+ * 
+ * @param pc Counters
+ */
+void perf_counters_close(perf_counters_t *pc);
+
+/**
+ * @brief Get the display name of an event
+ * 
+ * @param id Event identifier
+ * 
+ * @return Event name ("cycles", "instructions", ...)
+ */
+const char* perf_event_name(perf_event_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PERF_COUNTERS_H
\ No newline at end of file
@@ -0,0 +1,245 @@
+/**
+ * @file quantile_sketch.h
+ * @brief Mergeable quantile sketches per (sensor, day, metric)
+ *
+ * A sketch is a histogram over logarithmic buckets: a value x > 0 falls in
+ * bucket ceil(log(x) / log(gamma)) with gamma = (1 + a) / (1 - a), so every
+ * quantile is returned within relative error a. Negative values use a
+ * mirrored store. All sketches share the same bucket layout, so merging two
+ * sketches just adds bucket counts and is exact: merging per-file sketches
+ * gives the same answer as sketching all the data in one pass.
+ *
+ * Sketch file layout (little-endian):
+ *   "WQSK", u16 version, u16 reserved, f64 relative accuracy, u32 sketch count,
+ *   then per sketch: u32 sensor_id, u32 day, u8 metric, u64 count, u64 zero count,
+ *   f64 min, f64 max, f64 sum, and for the positive then negative store:
+ *   i32 first bucket, u32 bucket count, u64 counts[]
+ */
+
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "weather_types.h"
+#include "rolling_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define QSKETCH_MAGIC             "WQSK"
+#define QSKETCH_VERSION           1
+#define QSKETCH_RELATIVE_ACCURACY 0.01
+#define QSKETCH_MIN_MAGNITUDE     1e-9      // Smaller |x| is counted as zero
+#define SECONDS_PER_DAY           86400u
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Contiguous run of bucket counts
+ */
+typedef struct {
+    int32_t lo;          // Index of counts[0]
+    uint32_t len;
+    uint64_t *counts;
+} sketch_store_t;
+
+/**
+ * @brief One mergeable quantile sketch
+ */
+typedef struct {
+    sketch_store_t pos;
+    sketch_store_t neg;
+    uint64_t zero;
+    uint64_t count;
+    double min;
+    double max;
+    double sum;
+} quantile_sketch_t;
+
+/**
+ * @brief Sketch for one (sensor, day, metric)
+ */
+typedef struct {
+    uint32_t sensor_id;
+    uint32_t day;         // UTC days since 1970-01-01
+    uint8_t metric;       // rolling_metric_t
+    uint8_t used;
+    quantile_sketch_t sketch;
+} sketch_entry_t;
+
+/**
+ * @brief Hash table of sketches keyed by (sensor, day, metric)
+ */
+typedef struct {
+    sketch_entry_t *slots;
+    size_t capacity;      // Power of two, kept at most half full
+    size_t size;
+    uint32_t metric_mask; // Metrics sketched from records (1 << rolling_metric_t)
+} sketch_table_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Initialize an empty sketch
+ * 
+ * @param q Sketch
+ */
+void qsketch_init(quantile_sketch_t *q);
+
+/**
+ * @brief Add a value (NaN and infinities are ignored)
+ * 
+ * @param q Sketch
+ * @param x Value
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int qsketch_add(quantile_sketch_t *q, double x);
+
+/**
+ * @brief Add all values of src to dst
+ * 
+ * @param dst Destination sketch
+ * @param src Source sketch
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int qsketch_merge(quantile_sketch_t *dst, const quantile_sketch_t *src);
+
+/**
+ * @brief Estimate a quantile
+ * 
+ * @param q Sketch
+ * @param p Quantile in [0, 1]
+ * 
+ * @return Estimate within QSKETCH_RELATIVE_ACCURACY, NaN if the sketch is empty
+ */
+double qsketch_quantile(const quantile_sketch_t *q, double p);
+
+/**
+ * @brief Release a sketch
+ * 
+ * @param q Sketch
+ */
+void qsketch_free(quantile_sketch_t *q);
+
+/**
+ * @brief Initialize a table
+ * 
+ * @param t Table
+ * @param metric_mask Metrics to sketch in sketch_table_add_record (0 = temperature and CO2)
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int sketch_table_init(sketch_table_t *t, uint32_t metric_mask);
+
+/**
+ * @brief Get the sketch of a (sensor, day, metric), creating it if needed
+ * 
+ * @param t Table
+ * @param sensor_id Sensor ID
+ * @param day UTC day number
+ * @param metric Metric
+ * 
+ * @return Sketch, or NULL on out of memory
+ */
+quantile_sketch_t* sketch_table_get(sketch_table_t *t, uint32_t sensor_id, uint32_t day, uint8_t metric);
+
+/**
+ * @brief Add the sketched metrics of one record
+ * 
+ * @param t Table
+ * @param record Decoded record
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int sketch_table_add_record(sketch_table_t *t, const weather_record_t *record);
+
+/**
+ * @brief Merge every sketch of src into t
+ * 
+ * @param t Destination table
+ * @param src Source table
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int sketch_table_merge(sketch_table_t *t, const sketch_table_t *src);
+
+/**
+ * @brief Write a table to a sketch file
+ * 
+ * @param t Table
+ * @param path Output path
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int sketch_table_save(const sketch_table_t *t, const char *path);
+
+/**
+ * @brief Read a sketch file and merge it into a table
+ * 
+ * @param t Table (initialized)
+ * @param path Input path
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int sketch_table_load(sketch_table_t *t, const char *path);
+
+/**
+ * @brief Print p50/p95/p99 per sketch as JSON lines, sorted by sensor, day and metric
+ * 
+ * @param t Table
+ * @param rollup Merge all days of a (sensor, metric) into one line
+ * @param f Output stream
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int sketch_table_print_quantiles(const sketch_table_t *t, int rollup, FILE *f);
+
+/**
+ * @brief Release a table
+ * 
+ * @param t Table
+ */
+void sketch_table_free(sketch_table_t *t);
+
+/**
+ * @brief Merge sketch files into one
+ * 
+ * @param input_files Input sketch files
+ * @param n_inputs Number of inputs
+ * @param output_file Output sketch file
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int merge_sketch_files(const char **input_files, int n_inputs, const char *output_file);
+
+/**
+ * @brief Print quantiles from sketch files (merged) as JSON lines on stdout
+ * 
+ * @param input_files Input sketch files
+ * @param n_inputs Number of inputs
+ * @param rollup Merge all days of a (sensor, metric)
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int query_sketch_files(const char **input_files, int n_inputs, int rollup);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // QUANTILE_SKETCH_H
\ No newline at end of file
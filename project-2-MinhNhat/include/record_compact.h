@@ -0,0 +1,70 @@
+/**
+ * @file record_compact.h
+ * @brief Compaction of many small .bin files into a few large ones
+ *
+ * Records of all inputs are appended, in input order, to outputs named
+ * PREFIX-00000.bin, PREFIX-00001.bin, ... that roll over at a target
+ * size; every output has one header with the combined count. With
+ * sorting each output is sorted by (sensor_id, timestamp) before it is
+ * written; with dedup a record repeating any earlier (sensor_id,
+ * timestamp) of the whole run is dropped. PREFIX.manifest.json lists the
+ * outputs with their record count and sensor/time ranges, plus the
+ * inputs, so a scan can pick the few files covering a time window.
+ */
+
+#ifndef RECORD_COMPACT_H
+#define RECORD_COMPACT_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define COMPACT_DEFAULT_SIZE   (256u * 1024u * 1024u)
+#define COMPACT_MANIFEST_SUFFIX ".manifest.json"
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    size_t target_size;  // Output file size before rolling over (0 = COMPACT_DEFAULT_SIZE)
+    int sort;            // Sort each output by (sensor_id, timestamp)
+    int dedup;           // Drop records repeating an earlier (sensor_id, timestamp)
+} compact_options_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Compact binary weather files
+ * 
+ * Inputs may be files or directories (whose visible *.bin files are
+ * taken in name order). All inputs must share the version of the first
+ * one; the outputs carry the first input's file_id. Sorting holds one
+ * output in memory (about 2.5 times target_size including the sort
+ * buffers); otherwise records are streamed. On error the outputs written
+ * so far and the manifest are removed.
+ * 
+ * @param inputs Input paths
+ * @param n_inputs Number of inputs
+ * @param output_prefix Prefix of the output and manifest paths
+ * @param opts Options
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int compact_weather_files(const char **inputs, int n_inputs, const char *output_prefix,
+                          const compact_options_t *opts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORD_COMPACT_H
\ No newline at end of file
@@ -0,0 +1,87 @@
+/**
+ * @file record_partition.h
+ * @brief Partitioned conversion: one JSON file per sensor, day or hour
+ *
+ * The reading thread runs the usual read, decode, validate and analyze
+ * stages, then routes every record by a hash of its partition key to the
+ * writer that owns the partition. Each writer is a single-threaded worker
+ * pool, so a partition is only ever touched by one thread and its records
+ * keep input order. Writers keep at most their share of
+ * PARTITION_MAX_OPEN_FILES buffered handles open in an LRU list; an
+ * evicted partition is reopened for appending when its next record comes.
+ * Every partition file has the same layout as a full conversion, with its
+ * own record_count:
+ *
+ *   sensor  OUTPUT_DIR/sensors/SENSOR_ID.json
+ *   day     OUTPUT_DIR/YYYY/MM/DD.json
+ *   hour    OUTPUT_DIR/YYYY/MM/DD/HH.json     (UTC)
+ */
+
+#ifndef RECORD_PARTITION_H
+#define RECORD_PARTITION_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "weather_parser.h"
+#include "conv_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define PARTITION_MAX_OPEN_FILES   256          // Open handles over all writers
+#define PARTITION_FILE_BUFFER_SIZE (64 * 1024)  // stdio buffer per open handle
+#define PARTITION_QUEUE_DEPTH      8            // Batches queued per writer
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    PARTITION_SENSOR = 0,
+    PARTITION_DAY,
+    PARTITION_HOUR
+} partition_key_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Parse "sensor", "day" or "hour"
+ * 
+ * @param text Partition key name
+ * @param key Parsed key
+ * 
+ * @return 1 on success, 0 on an unknown name (with error message)
+ */
+int partition_key_parse(const char *text, partition_key_t *key);
+
+/**
+ * @brief Convert a binary file into one JSON file per partition
+ * 
+ * Dedup keeps its key set in memory (dedup_mem_limit is not applied).
+ * Partition files left from an earlier run are overwritten when the
+ * partition occurs again, other files are kept.
+ * 
+ * @param input_file Path to input binary file
+ * @param output_dir Root of the partition tree (created if missing)
+ * @param by Partition key
+ * @param n_writers Writer threads (<= 0 = one per CPU)
+ * @param opts Options (NULL = defaults)
+ * @param stats Filled with per-stage timings when not NULL; the write
+ *              stage is the time spent handing batches to the writers
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int partition_weather_file(const char *input_file, const char *output_dir, partition_key_t by,
+                           int n_writers, const parse_options_t *opts, conv_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORD_PARTITION_H
\ No newline at end of file
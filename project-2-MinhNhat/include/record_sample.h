@@ -0,0 +1,85 @@
+/**
+ * @file record_sample.h
+ * @brief Convert a sample of a binary file instead of all of it
+ *
+ * Records are fixed size, so record i lives at HEADER_SIZE + i * RECORD_SIZE
+ * and a sample can be read with one seek per record. Stride sampling takes
+ * every Nth record; reservoir sampling draws a uniform random set of K
+ * ordinals with Algorithm L (Li, 1994) from the header's record count alone,
+ * then reads them in file order. Either way the work scales with the sample
+ * size, not with the file size.
+ */
+
+#ifndef RECORD_SAMPLE_H
+#define RECORD_SAMPLE_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdint.h>
+#include "weather_parser.h"
+#include "conv_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define SAMPLE_DEFAULT_SEED 0x5EEDull
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    SAMPLE_STRIDE = 0,   // Records 0, N, 2N, ...
+    SAMPLE_RESERVOIR     // K records, uniformly at random
+} sample_mode_t;
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    sample_mode_t mode;
+    uint32_t n;          // Stride N or reservoir size K
+    uint64_t seed;       // Random seed for reservoir sampling
+} sample_spec_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Parse "stride:N" or "reservoir:K[:SEED]"
+ * 
+ * @param text Sample spec
+ * @param spec Parsed spec
+ * 
+ * @return 1 on success, 0 on a malformed spec (with error message)
+ */
+int sample_spec_parse(const char *text, sample_spec_t *spec);
+
+/**
+ * @brief Convert a sample of a binary file to JSON
+ * 
+ * Sampled records go through the same validate, analyze and write stages
+ * as a full conversion; record_count in the output is the sample size.
+ * Dedup is not applied.
+ * 
+ * @param input_file Path to input binary file
+ * @param output_file Path to output JSON file
+ * @param spec Sample spec
+ * @param opts Options (NULL = defaults)
+ * @param stats Filled with per-stage timings when not NULL
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int sample_weather_file(const char *input_file, const char *output_file, const sample_spec_t *spec,
+                        const parse_options_t *opts, conv_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORD_SAMPLE_H
\ No newline at end of file
@@ -0,0 +1,104 @@
+/**
+ * @file record_sort.h
+ * @brief External merge sort of packed weather files by (sensor_id, timestamp)
+ */
+
+#ifndef RECORD_SORT_H
+#define RECORD_SORT_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define SORT_DEFAULT_MEM_LIMIT (256u * 1024u * 1024u)
+#define SORT_MAX_FANIN 512
+
+/*********************
+ *      TYPEDEFS
+ *********************/
+
+/**
+ * @brief Sort key of one packed record
+ * 
+ * @param packed RECORD_SIZE bytes
+ * @param ctx Context passed to sort_weather_file_by()
+ */
+typedef uint64_t (*record_sort_key_fn)(const uint8_t *packed, const void *ctx);
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Sort packed records in memory by record_key_packed() (stable)
+ * 
+ * LSD radix sort on the 64-bit keys; byte positions where all keys agree
+ * are skipped, so small sensor IDs cost only a few passes.
+ * 
+ * @param records n * RECORD_SIZE bytes, sorted in place
+ * @param n Number of records
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int sort_packed_records(uint8_t *records, size_t n);
+
+/**
+ * @brief Sort a binary weather file that may be larger than memory
+ * 
+ * Runs of records that fit in mem_limit are radix sorted and spilled
+ * to temp files, then k-way merged with a loser tree. Runs beyond
+ * SORT_MAX_FANIN are merged in several passes.
+ * 
+ * @param input_file Input .bin path
+ * @param output_file Output .bin path
+ * @param mem_limit Memory for one run in bytes (0 = SORT_DEFAULT_MEM_LIMIT)
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int sort_weather_file(const char *input_file, const char *output_file, size_t mem_limit);
+
+/**
+ * @brief sort_weather_file with a caller-supplied key, without the progress lines
+ * 
+ * Records with equal keys keep their input order.
+ * 
+ * @param input_file Input .bin path
+ * @param output_file Output .bin path
+ * @param mem_limit Memory for one run in bytes (0 = SORT_DEFAULT_MEM_LIMIT)
+ * @param key_fn Sort key (NULL = record_key_packed)
+ * @param key_ctx Passed to key_fn
+ * @param sorted_count Set to the number of records written on success (may be NULL)
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int sort_weather_file_by(const char *input_file, const char *output_file, size_t mem_limit,
+                         record_sort_key_fn key_fn, const void *key_ctx, uint32_t *sorted_count);
+
+/**
+ * @brief Merge already-sorted binary weather files into one sorted file
+ * 
+ * Inputs that turn out not to be sorted are reported; the output is
+ * then only as ordered as the inputs.
+ * 
+ * @param input_files Input .bin paths
+ * @param n_inputs Number of inputs (1..SORT_MAX_FANIN)
+ * @param output_file Output .bin path
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int merge_weather_files(const char **input_files, int n_inputs, const char *output_file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORD_SORT_H
\ No newline at end of file
@@ -0,0 +1,178 @@
+/**
+ * @file record_validate.h
+ * @brief Range validation of decoded records with per-record error bitmasks
+ *
+ * Every field is checked against a [min, max] range over whole batches;
+ * NaN always fails. The result is one bitmask per record (bit f set when
+ * field f failed), computed by dispatched SIMD kernels that gather each
+ * field straight out of the record array. Masks are then used to count,
+ * tag, drop or clamp bad records. Checking is cheap enough to stay on by
+ * default in count-only mode.
+ */
+
+#ifndef RECORD_VALIDATE_H
+#define RECORD_VALIDATE_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "weather_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define VALIDATE_TAGS_JSON_SIZE 256
+
+/*********************
+ *      ENUMS
+ *********************/
+
+/**
+ * @brief Checked fields, also the bit positions of the error mask
+ */
+typedef enum {
+    VALIDATE_BATTERY = 0,
+    VALIDATE_LAT,
+    VALIDATE_LON,
+    VALIDATE_TEMPERATURE,
+    VALIDATE_HUMIDITY,
+    VALIDATE_PRESSURE,
+    VALIDATE_CO2,
+    VALIDATE_WIND_SPEED,
+    VALIDATE_WIND_DIR,
+    VALIDATE_RAIN,
+    VALIDATE_UV,
+    VALIDATE_LIGHT,
+    VALIDATE_FIELD_COUNT
+} validate_field_t;
+
+/**
+ * @brief What happens to records that fail a check
+ */
+typedef enum {
+    VALIDATE_OFF = 0,   // No checks
+    VALIDATE_COUNT,     // Count failures only (default)
+    VALIDATE_TAG,       // Write an "invalid" list of failed fields
+    VALIDATE_DROP,      // Leave bad records out of the output
+    VALIDATE_CLAMP      // Clamp to the range; records with NaN fields are dropped
+} validate_action_t;
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Ranges, action and counters of one validation run
+ */
+typedef struct {
+    validate_action_t action;
+    double min[VALIDATE_FIELD_COUNT];
+    double max[VALIDATE_FIELD_COUNT];
+    float min_f[VALIDATE_FIELD_COUNT];  // Float bounds accepting exactly the same float values
+    float max_f[VALIDATE_FIELD_COUNT];
+    uint64_t checked;                   // Records checked
+    uint64_t invalid;                   // Records with at least one failed field
+    uint64_t dropped;                   // Records left out (drop, or NaN/missing CO2 under clamp)
+    uint64_t clamped;                   // Records changed by clamp
+    uint64_t failures[VALIDATE_FIELD_COUNT];
+} record_validator_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Initialize a validator with the default ranges
+ * 
+ * @param v Validator
+ * @param action Action for bad records
+ */
+void record_validator_init(record_validator_t *v, validate_action_t action);
+
+/**
+ * @brief Override the range of one field
+ * 
+ * @param v Validator
+ * @param spec "field=min:max", e.g. "temperature=-40:55"
+ * 
+ * @return 1 on success, 0 on a malformed spec (with error message)
+ */
+int record_validator_set_range(record_validator_t *v, const char *spec);
+
+/**
+ * @brief Parse an action name ("off", "count", "tag", "drop", "clamp")
+ * 
+ * @param name Action name
+ * @param out Parsed action
+ * 
+ * @return 1 on success, 0 on unknown name
+ */
+int validate_action_from_name(const char *name, validate_action_t *out);
+
+/**
+ * @brief Get the name of a checked field
+ * 
+ * @param field Field
+ * 
+ * @return Field name as used by --range and the "invalid" list
+ */
+const char* validate_field_name(validate_field_t field);
+
+/**
+ * @brief Compute the error bitmask of every record
+ * 
+ * @param masks Array of at least n masks to fill
+ * @param records Decoded records
+ * @param n Number of records
+ * @param v Validator (ranges only, counters are not touched)
+ */
+void validate_weather_masks(uint16_t *masks, const weather_record_t *records, size_t n,
+                            const record_validator_t *v);
+
+/**
+ * @brief Validate a batch, update the counters and apply the action
+ * 
+ * Drop (and clamp, for records with NaN fields or a missing CO2 reading)
+ * compact records and masks
+ * in place.
+ * 
+ * @param v Validator
+ * @param records Decoded records
+ * @param masks Array of at least n masks, left aligned with the kept records
+ * @param n Number of records
+ * 
+ * @return Number of records kept
+ */
+size_t validate_weather_batch(record_validator_t *v, weather_record_t *records, uint16_t *masks, size_t n);
+
+/**
+ * @brief Render the "invalid" member of a tagged record
+ * 
+ * @param mask Error bitmask
+ * @param buf Output buffer
+ * @param size Buffer size (VALIDATE_TAGS_JSON_SIZE always fits)
+ * 
+ * @return buf, holding ",\n      \"invalid\": [...]" or "" when mask is 0
+ */
+const char* validate_tags_json(uint16_t mask, char *buf, size_t size);
+
+/**
+ * @brief Print failure counts per field
+ * 
+ * @param v Validator
+ * @param f Output stream
+ */
+void record_validator_print_summary(const record_validator_t *v, FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORD_VALIDATE_H
\ No newline at end of file
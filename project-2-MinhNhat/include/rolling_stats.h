@@ -0,0 +1,171 @@
+/**
+ * @file rolling_stats.h
+ * @brief Per-sensor rolling mean/variance with z-score anomaly flags
+ *
+ * Each sensor keeps an exponentially weighted mean and variance per
+ * metric in a fixed-size state struct, stored in a flat open-addressing
+ * table keyed by sensor_id. An update is O(1) and needs no history, so
+ * the engine can run on endless streams.
+ */
+
+#ifndef ROLLING_STATS_H
+#define ROLLING_STATS_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "weather_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define ROLLING_DEFAULT_ALPHA   0.05
+#define ROLLING_DEFAULT_ZSCORE  3.0
+#define ROLLING_DEFAULT_WARMUP  20
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    METRIC_TEMPERATURE = 0,
+    METRIC_HUMIDITY,
+    METRIC_PRESSURE,
+    METRIC_CO2,
+    METRIC_COUNT
+} rolling_metric_t;
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief EWMA state of one metric
+ */
+typedef struct {
+    double mean;
+    double var;
+    uint32_t samples;
+} ewma_state_t;
+
+/**
+ * @brief Fixed-size per-sensor state (one hash table slot)
+ */
+typedef struct {
+    uint32_t sensor_id;
+    uint32_t used;
+    ewma_state_t metric[METRIC_COUNT];
+} sensor_state_t;
+
+/**
+ * @brief Rolling stats engine
+ */
+typedef struct {
+    sensor_state_t *slots;
+    size_t capacity;               // Power of two, kept at most half full
+    size_t sensors;
+    double alpha;                  // EWMA weight of the newest sample
+    double z_threshold;            // Flag |z| above this
+    uint32_t warmup;               // Samples per metric before flagging
+    FILE *events;                  // JSON lines of flagged readings, or NULL
+    uint64_t readings;
+    uint64_t anomalies[METRIC_COUNT];
+} rolling_stats_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Initialize the engine
+ * 
+ * @param rs Engine to initialize
+ * @param alpha EWMA weight in (0, 1] (0 = ROLLING_DEFAULT_ALPHA)
+ * @param z_threshold Z-score threshold (0 = ROLLING_DEFAULT_ZSCORE)
+ * @param events Stream for anomaly events (JSON lines), or NULL to only count
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int rolling_stats_init(rolling_stats_t *rs, double alpha, double z_threshold, FILE *events);
+
+/**
+ * @brief Score a record against its sensor's state, then fold it in
+ * 
+ * NaN readings are skipped. Readings are only flagged once the metric
+ * has seen warmup samples.
+ * 
+ * @param rs Engine
+ * @param record Decoded record
+ * @param ordinal Position of the record in the output, reported in events
+ * 
+ * @return Bit mask of flagged metrics (1 << rolling_metric_t), or -1 on out of memory
+ */
+int rolling_stats_update(rolling_stats_t *rs, const weather_record_t *record, uint64_t ordinal);
+
+/**
+ * @brief Run rolling_stats_update over a decoded batch
+ * 
+ * @param rs Engine
+ * @param records Decoded records
+ * @param n Number of records
+ * @param first_ordinal Output position of records[0]
+ * 
+ * @return 1 on success, 0 on out of memory
+ */
+int rolling_stats_update_batch(rolling_stats_t *rs, const weather_record_t *records,
+                               size_t n, uint64_t first_ordinal);
+
+/**
+ * @brief Look up the state of a sensor
+ * 
+ * @param rs Engine
+ * @param sensor_id Sensor ID
+ * 
+ * @return State, or NULL if the sensor has not been seen
+ */
+const sensor_state_t* rolling_stats_find(const rolling_stats_t *rs, uint32_t sensor_id);
+
+/**
+ * @brief Total number of flagged readings across metrics
+ * 
+ * @param rs Engine
+ * 
+ * @return Flagged readings so far
+ */
+uint64_t rolling_stats_flagged(const rolling_stats_t *rs);
+
+/**
+ * @brief Print the number of sensors and flagged readings per metric
+ * 
+ * @param rs Engine
+ * @param f Output stream
+ */
+void rolling_stats_print_summary(const rolling_stats_t *rs, FILE *f);
+
+/**
+ * @brief Release the engine (the events stream is not closed)
+ * 
+ * @param rs Engine
+ */
+void rolling_stats_free(rolling_stats_t *rs);
+
+/**
+ * @brief Get the display name of a metric
+ * 
+ * @param metric Metric identifier
+ * 
+ * @return Metric name ("temperature", ...)
+ */
+const char* rolling_metric_name(rolling_metric_t metric);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROLLING_STATS_H
\ No newline at end of file
@@ -0,0 +1,115 @@
+/**
+ * @file sensor_meta.h
+ * @brief Sensor metadata table for enriching records (hash join on sensor_id)
+ *
+ * Metadata is a JSON array of station objects, or an object whose
+ * "sensors" member is such an array:
+ *
+ *     [ { "sensor_id": 7, "name": "Dist 1 roof", "site": "HCMC",
+ *         "calibration": { "temperature": -0.4, "humidity": 1.5 } }, ... ]
+ *
+ * Every member other than sensor_id and calibration is emitted in a
+ * "station" object of the record's JSON; the fragment is rendered once at
+ * load time, so the join costs one hash lookup per record.
+ */
+
+#ifndef SENSOR_META_H
+#define SENSOR_META_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+#include <stdint.h>
+#include "weather_types.h"
+#include "rolling_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Metadata of one sensor
+ */
+typedef struct {
+    uint32_t sensor_id;
+    uint32_t used;
+    float calibration[METRIC_COUNT];   // Offsets added to the readings
+    char *station_json;                // ",\n      \"station\": {...}" or "" when there are no fields
+} sensor_meta_t;
+
+/**
+ * @brief Metadata table keyed by sensor_id
+ */
+typedef struct {
+    sensor_meta_t *slots;
+    size_t capacity;       // Power of two, kept at most half full
+    size_t sensors;
+    int emit_fields;       // Add the "station" object to JSON records
+    int calibrate;         // Apply calibration offsets to decoded records
+    uint64_t unmatched;    // Records whose sensor_id has no metadata
+} sensor_meta_table_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Load a metadata JSON file
+ * 
+ * @param t Table to fill
+ * @param path Path to the metadata JSON file
+ * @param emit_fields Add station fields to JSON output
+ * @param calibrate Apply calibration offsets in place
+ * 
+ * @return 1 on success, 0 on failure (with error message)
+ */
+int sensor_meta_load(sensor_meta_table_t *t, const char *path, int emit_fields, int calibrate);
+
+/**
+ * @brief Look up the metadata of a sensor
+ * 
+ * @param t Table
+ * @param sensor_id Sensor ID
+ * 
+ * @return Metadata, or NULL if the sensor is not listed
+ */
+const sensor_meta_t* sensor_meta_find(const sensor_meta_table_t *t, uint32_t sensor_id);
+
+/**
+ * @brief Join a batch: count unmatched records and, if enabled, apply calibration offsets
+ * 
+ * NaN readings and missing CO2 (0xFFFF) are left as they are.
+ * 
+ * @param t Table
+ * @param records Decoded records, updated in place
+ * @param n Number of records
+ */
+void sensor_meta_join(sensor_meta_table_t *t, weather_record_t *records, size_t n);
+
+/**
+ * @brief JSON fragment to append to a record of this sensor
+ * 
+ * @param t Table
+ * @param sensor_id Sensor ID
+ * 
+ * @return Fragment starting with ",\n", or "" when there is nothing to add
+ */
+const char* sensor_meta_station_json(const sensor_meta_table_t *t, uint32_t sensor_id);
+
+/**
+ * @brief Release the table
+ * 
+ * @param t Table
+ */
+void sensor_meta_free(sensor_meta_table_t *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_META_H
\ No newline at end of file
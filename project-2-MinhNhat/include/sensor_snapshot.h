@@ -0,0 +1,156 @@
+/**
+ * @file sensor_snapshot.h
+ * @brief Persistent latest-record-per-sensor table in a memory-mapped file
+ *
+ * Layout: a snapshot_header_t followed by capacity snapshot_slot_t slots,
+ * an open-addressing table keyed by sensor_id (util_hash_slot, linear
+ * probing, at most half full). Each slot holds the decoded record with the
+ * newest timestamp seen for its sensor, so the battery status and readings
+ * are available without reconverting any file. Updates are done in place in
+ * the shared mapping while files or streams are converted, and the file
+ * can be mapped read-only by other processes: a slot's seq is odd while it
+ * is being written. One writer at a time holds an exclusive flock() on the
+ * file. The table grows by building a twice larger copy next to it and
+ * renaming it into place, so a mapped file never changes size; readers
+ * call sensor_snapshot_refresh() to pick up the new file. The layout is
+ * host-native (the header records the slot size to catch mismatches).
+ */
+
+#ifndef SENSOR_SNAPSHOT_H
+#define SENSOR_SNAPSHOT_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "weather_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define SNAPSHOT_MAGIC            0x504E5357u  // "WSNP"
+#define SNAPSHOT_VERSION          1
+#define SNAPSHOT_INITIAL_CAPACITY 1024u        // slots, power of two
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief File header
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t slot_size;              // sizeof(snapshot_slot_t)
+    uint32_t capacity;               // Power of two
+    uint32_t sensors;                // Used slots
+    uint64_t updates;                // Records stored over the file's life
+} snapshot_header_t;
+
+/**
+ * @brief Latest state of one sensor (one hash table slot)
+ */
+typedef struct {
+    uint32_t sensor_id;
+    uint32_t used;
+    uint32_t seq;                    // Odd while the record is being rewritten
+    uint32_t reserved;
+    weather_record_t record;         // Record with the newest timestamp
+} snapshot_slot_t;
+
+/**
+ * @brief Process-local handle on a mapped snapshot file
+ */
+typedef struct {
+    int fd;
+    char *path;
+    snapshot_header_t *hdr;
+    snapshot_slot_t *slots;
+    size_t map_size;
+    uint32_t capacity;               // Slots covered by the mapping
+    uint64_t updated;                // Records stored through this handle
+} sensor_snapshot_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Map a snapshot file, creating an empty table if it does not exist
+ * 
+ * @param snap Handle to fill
+ * @param path Snapshot file path
+ * @param writable 1 to update the table (fails while another process
+ *                 holds it for writing), 0 to map it read-only
+ * 
+ * @return 1 on success, 0 on failure (with error message)
+ */
+int sensor_snapshot_open(sensor_snapshot_t *snap, const char *path, int writable);
+
+/**
+ * @brief Remap a read-only snapshot if a writer has replaced the file by growing it
+ * 
+ * @param snap Read-only snapshot
+ * 
+ * @return 1 on success, 0 on failure (the handle is closed, with error message)
+ */
+int sensor_snapshot_refresh(sensor_snapshot_t *snap);
+
+/**
+ * @brief Keep records newer than (or as new as) their sensor's current one
+ * 
+ * @param snap Writable snapshot
+ * @param records Decoded records
+ * @param n Number of records
+ * 
+ * @return 1 on success, 0 if the file could not grow
+ */
+int sensor_snapshot_update_batch(sensor_snapshot_t *snap, const weather_record_t *records, size_t n);
+
+/**
+ * @brief Look up the latest record of a sensor
+ * 
+ * @param snap Snapshot
+ * @param sensor_id Sensor ID
+ * 
+ * @return Slot, or NULL if the sensor has not been seen
+ */
+const snapshot_slot_t* sensor_snapshot_find(const sensor_snapshot_t *snap, uint32_t sensor_id);
+
+/**
+ * @brief Write the table as compact JSON, one sensor per line in slot order
+ * 
+ * @param snap Snapshot
+ * @param f Output stream
+ */
+void sensor_snapshot_export_json(const sensor_snapshot_t *snap, FILE *f);
+
+/**
+ * @brief Unmap and close the snapshot (changes are already in the file)
+ * 
+ * @param snap Snapshot
+ */
+void sensor_snapshot_close(sensor_snapshot_t *snap);
+
+/**
+ * @brief Export a snapshot file to JSON
+ * 
+ * @param snapshot_file Snapshot file path
+ * @param output_file JSON output path, or NULL for stdout
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int export_sensor_snapshot(const char *snapshot_file, const char *output_file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SENSOR_SNAPSHOT_H
\ No newline at end of file
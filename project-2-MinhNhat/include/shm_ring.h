@@ -0,0 +1,199 @@
+/**
+ * @file shm_ring.h
+ * @brief Single-producer/single-consumer ring of packed records in POSIX shared memory
+ *
+ * Layout: a shm_ring_header_t followed by capacity * RECORD_SIZE bytes of
+ * packed records. head counts records published by the producer, tail
+ * counts records released by the consumer; both only grow, and a record
+ * lives in slot (index & (capacity - 1)). The consumer decodes straight
+ * from the shared slots, so records are never copied on the way in. The
+ * producer's pid is recorded at creation; a consumer waiting on an empty,
+ * unclosed ring gives up once that process is gone.
+ */
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+#include <stdint.h>
+#include "weather_types.h"
+#include "weather_parser.h"
+#include "conv_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define SHM_RING_MAGIC            0x474E5257u  // "WRNG"
+#define SHM_RING_VERSION          2
+#define SHM_RING_DEFAULT_CAPACITY 65536u       // records, power of two
+#define SHM_RING_CLOSED           0x1u         // producer finished, no more records
+#define SHM_RING_ATTACH_TIMEOUT_MS 10000
+#define SHM_RING_LIVENESS_MS       100         // how often an idle consumer checks the producer
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Shared ring header; head and tail sit on their own cache lines
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t capacity;
+    uint32_t flags;                  // SHM_RING_CLOSED
+    char file_id[FILE_ID_SIZE];      // Header of the stream, as in a .bin file
+    uint16_t file_version;
+    uint16_t reserved;
+    int32_t producer_pid;            // Checked by an idle consumer, 0 = unknown
+    uint8_t pad0[64 - 28];
+    uint64_t head;                   // Written by the producer only
+    uint8_t pad1[64 - 8];
+    uint64_t tail;                   // Written by the consumer only
+    uint8_t pad2[64 - 8];
+} shm_ring_header_t;
+
+/**
+ * @brief Process-local handle on a mapped ring
+ */
+typedef struct {
+    shm_ring_header_t *hdr;
+    uint8_t *slots;
+    size_t map_size;
+    uint32_t mask;
+} shm_ring_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Create (replacing a stale one) and map a ring, as the producer
+ * 
+ * @param ring Handle to fill
+ * @param name Shared memory name, e.g. "/weather_ring"
+ * @param capacity Number of record slots, rounded up to a power of two
+ * @param header Stream header (file_id, version) passed to the consumer
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int shm_ring_create(shm_ring_t *ring, const char *name, uint32_t capacity,
+                    const file_header_t *header);
+
+/**
+ * @brief Map an existing ring as the consumer
+ * 
+ * @param ring Handle to fill
+ * @param name Shared memory name
+ * @param timeout_ms How long to wait for the producer to create it
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int shm_ring_attach(shm_ring_t *ring, const char *name, int timeout_ms);
+
+/**
+ * @brief Unmap a ring
+ * 
+ * @param ring Handle
+ */
+void shm_ring_detach(shm_ring_t *ring);
+
+/**
+ * @brief Remove the shared memory name (mappings stay valid)
+ * 
+ * @param name Shared memory name
+ */
+void shm_ring_unlink(const char *name);
+
+/**
+ * @brief Contiguous free slots the producer may fill
+ * 
+ * @param ring Handle
+ * @param count Set to the number of writable records (0 when full)
+ * 
+ * @return Pointer to the first free slot
+ */
+uint8_t* shm_ring_write_space(shm_ring_t *ring, uint32_t *count);
+
+/**
+ * @brief Publish n records filled through shm_ring_write_space
+ * 
+ * @param ring Handle
+ * @param n Number of records
+ */
+void shm_ring_publish(shm_ring_t *ring, uint32_t n);
+
+/**
+ * @brief Mark the stream finished; the consumer stops once drained
+ * 
+ * @param ring Handle
+ */
+void shm_ring_close(shm_ring_t *ring);
+
+/**
+ * @brief Contiguous published records the consumer may read in place
+ * 
+ * @param ring Handle
+ * @param count Set to the number of readable records (0 when empty)
+ * 
+ * @return Pointer to the first readable record
+ */
+const uint8_t* shm_ring_read_span(shm_ring_t *ring, uint32_t *count);
+
+/**
+ * @brief Hand n consumed slots back to the producer
+ * 
+ * @param ring Handle
+ * @param n Number of records
+ */
+void shm_ring_release(shm_ring_t *ring, uint32_t n);
+
+/**
+ * @brief Whether the producer closed the ring and every record was consumed
+ * 
+ * @param ring Handle
+ * 
+ * @return 1 if drained, 0 otherwise
+ */
+int shm_ring_drained(shm_ring_t *ring);
+
+/**
+ * @brief Whether the producer can still publish: it closed the ring, or its process is running
+ * 
+ * @param ring Handle
+ * 
+ * @return 1 if records may still arrive or are already published, 0 if the producer died
+ */
+int shm_ring_producer_alive(shm_ring_t *ring);
+
+/**
+ * @brief Convert records streamed through a shared-memory ring to JSON
+ * 
+ * Attaches to the ring, decodes records in place until the producer
+ * closes it, then patches record_count in the output metadata. Fails if
+ * the producer exits without closing the ring. The ring
+ * name is unlinked when done. Dedup is not supported in this mode.
+ * 
+ * @param ring_name Shared memory name
+ * @param output_file Path to output JSON file
+ * @param opts Options, or NULL for defaults
+ * @param stats Stats to fill in, or NULL to disable instrumentation
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int ingest_shm_ring(const char *ring_name, const char *output_file,
+                    const parse_options_t *opts, conv_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SHM_RING_H
\ No newline at end of file
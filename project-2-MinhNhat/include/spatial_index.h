@@ -0,0 +1,141 @@
+/**
+ * @file spatial_index.h
+ * @brief Uniform lat/lon grid index over a cell-ordered binary weather file
+ *
+ * Building the index rewrites a .bin file so that records of the same grid
+ * cell are contiguous (input order kept within a cell) and writes a side
+ * file "<output>.idx" mapping each non-empty cell to its record range.
+ * A bounding-box query then seeks straight to the cells it overlaps.
+ *
+ * Index file layout (little-endian):
+ *   0  "WGIX"            4 bytes
+ *   4  version           u16
+ *   6  reserved          u16
+ *   8  cell size (deg)   f64
+ *   16 record count      u32
+ *   20 cell count        u32
+ *   24 cells             { u64 cell key, u32 first record, u32 record count } sorted by key
+ */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define SPATIAL_INDEX_SUFFIX      ".idx"
+#define SPATIAL_INDEX_MAGIC       "WGIX"
+#define SPATIAL_INDEX_VERSION     1
+#define SPATIAL_INDEX_HEADER_SIZE 24
+#define SPATIAL_INDEX_ENTRY_SIZE  16
+#define SPATIAL_DEFAULT_CELL_DEG  0.01          // About 1.1 km of latitude
+#define SPATIAL_MIN_CELL_DEG      1e-6          // About 0.1 m; keeps the column below 2^32
+#define SPATIAL_INVALID_CELL      UINT64_MAX    // Records with NaN or out-of-range coordinates
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Inclusive latitude/longitude box
+ */
+typedef struct {
+    double min_lat;
+    double min_lon;
+    double max_lat;
+    double max_lon;
+} geo_bbox_t;
+
+/**
+ * @brief One non-empty grid cell
+ */
+typedef struct {
+    uint64_t cell;     // (row << 32) | col
+    uint32_t first;    // Index of the first record in the cell-ordered file
+    uint32_t count;    // Number of records in the cell
+} spatial_cell_t;
+
+/**
+ * @brief Index loaded in memory
+ */
+typedef struct {
+    double cell_deg;
+    uint32_t record_count;
+    uint32_t n_cells;
+    spatial_cell_t *cells;
+} spatial_index_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Grid cell of a coordinate
+ * 
+ * @param lat Latitude in degrees
+ * @param lon Longitude in degrees
+ * @param cell_deg Cell size in degrees
+ * 
+ * @return (row << 32) | col, or SPATIAL_INVALID_CELL
+ */
+uint64_t spatial_cell_key(double lat, double lon, double cell_deg);
+
+/**
+ * @brief Reorder a binary file by grid cell and write its index
+ * 
+ * Reordering uses the external sort (record_sort.h) keyed on the cell,
+ * so the input does not have to fit in memory; only the cell table does.
+ * 
+ * @param input_file Input .bin path
+ * @param output_file Output .bin path; the index goes to output_file + SPATIAL_INDEX_SUFFIX
+ * @param cell_deg Cell size in degrees (0 = SPATIAL_DEFAULT_CELL_DEG, at least SPATIAL_MIN_CELL_DEG)
+ * @param mem_limit Memory for one sort run in bytes (0 = SORT_DEFAULT_MEM_LIMIT)
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int build_spatial_index(const char *input_file, const char *output_file, double cell_deg, size_t mem_limit);
+
+/**
+ * @brief Load an index file
+ * 
+ * @param index Index to fill
+ * @param index_file Path to the .idx file
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int spatial_index_load(spatial_index_t *index, const char *index_file);
+
+/**
+ * @brief Release an index loaded with spatial_index_load
+ * 
+ * @param index Index
+ */
+void spatial_index_free(spatial_index_t *index);
+
+/**
+ * @brief Write the records inside a box as JSON, reading only overlapping cells
+ * 
+ * @param input_file Cell-ordered .bin written by build_spatial_index
+ * @param box Query box (min <= max on both axes)
+ * @param output_file Path to output JSON file
+ * @param derive Add derived metrics (see derived_metrics.h) to every record
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int query_spatial_bbox(const char *input_file, const geo_bbox_t *box, const char *output_file, int derive);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPATIAL_INDEX_H
\ No newline at end of file
@@ -0,0 +1,60 @@
+/**
+ * @file spool_watch.h
+ * @brief Watch a spool directory and convert .bin files as they complete
+ *
+ * inotify reports files closed after writing (IN_CLOSE_WRITE) or renamed
+ * into the directory (IN_MOVED_TO); each completed "*.bin" is queued on a
+ * worker pool right away instead of waiting for the next cron poll. A
+ * worker claims the file by renaming it to a hidden ".NAME.work" inside
+ * the spool (so duplicate events are harmless), writes OUTPUT_DIR/NAME.json
+ * through a temporary name and finally moves the input to ARCHIVE_DIR.
+ * Inputs that fail to convert are parked as ".NAME.failed". Hidden files
+ * are ignored, so writers may also spool under ".name" and rename.
+ */
+
+#ifndef SPOOL_WATCH_H
+#define SPOOL_WATCH_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "weather_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      CONSTANTS
+ *********************/
+#define SPOOL_WATCH_QUEUE_DEPTH 1024
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Convert spooled files until SIGINT/SIGTERM
+ * 
+ * Files already in the spool at startup are converted first. Only the
+ * dedup, derive, iso_time and validate settings of opts are used; every job gets
+ * its own copy of the validator, and one line of per-job stats (with the
+ * latency from the inotify event to the archived input) goes to stdout.
+ * Archive and spool must be on the same filesystem.
+ * 
+ * @param spool_dir Directory to watch
+ * @param output_dir Directory for the JSON output
+ * @param archive_dir Directory converted inputs are moved to
+ * @param opts Conversion options
+ * @param n_workers Number of worker threads (0 = one per CPU)
+ * 
+ * @return 0 on clean shutdown, non-zero on error
+ */
+int spool_watch_run(const char *spool_dir, const char *output_dir, const char *archive_dir,
+                    const parse_options_t *opts, int n_workers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPOOL_WATCH_H
\ No newline at end of file
@@ -0,0 +1,79 @@
+/**
+ * @file util.h
+ * @brief Helpers shared by the lookup tables and config loaders
+ */
+
+#ifndef UTIL_H
+#define UTIL_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Hash a table key (sensor ID, day, hour, ...)
+ * 
+ * Fibonacci hashing: multiplying by 2^64 / phi spreads sequential keys
+ * across the table instead of filling one run of slots. The open-addressing
+ * tables take util_hash(key) & mask as the home slot and step with
+ * util_probe_next(), so a table's layout depends only on its capacity.
+ * 
+ * @param key Key to hash
+ * 
+ * @return 32-bit hash in a 64-bit value
+ */
+static inline uint64_t util_hash(uint64_t key)
+{
+    return (key * 0x9E3779B97F4A7C15ull) >> 32;
+}
+
+/**
+ * @brief Home slot of a key in a power-of-two table
+ * 
+ * @param key Key to hash
+ * @param mask Table capacity - 1
+ * 
+ * @return Slot index
+ */
+static inline size_t util_hash_slot(uint64_t key, size_t mask)
+{
+    return (size_t)util_hash(key) & mask;
+}
+
+/**
+ * @brief Next slot to try after a collision (linear probing)
+ * 
+ * @param i Current slot
+ * @param mask Table capacity - 1
+ * 
+ * @return Slot index
+ */
+static inline size_t util_probe_next(size_t i, size_t mask)
+{
+    return (i + 1) & mask;
+}
+
+/**
+ * @brief Read a whole file into a NUL-terminated buffer
+ * 
+ * @param path File to read
+ * 
+ * @return Buffer to release with mem_free, or NULL with errno set
+ */
+char* util_read_file(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTIL_H
\ No newline at end of file
@@ -11,11 +11,60 @@
  *********************/
 #include <stdio.h>
 #include "weather_types.h"
+#include "conv_stats.h"
+#include "rolling_stats.h"
+#include "quantile_sketch.h"
+#include "sensor_meta.h"
+#include "derived_metrics.h"
+#include "record_validate.h"
+#include "sensor_snapshot.h"
+#include "alert_rules.h"
+#include "json_writer.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*********************
+ *      CONSTANTS
+ *********************/
+#define READ_BATCH_RECORDS 1024
+#define PARSE_OUTPUT_BUFFER_SIZE (1 << 20)
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/**
+ * @brief Conversion buffers kept warm across calls (one per worker thread)
+ */
+typedef struct {
+    uint8_t *batch;             // READ_BATCH_RECORDS packed records
+    weather_record_t *records;  // READ_BATCH_RECORDS decoded records
+    derived_metrics_t *derived; // READ_BATCH_RECORDS derived metrics, parallel to records
+    uint16_t *invalid;          // READ_BATCH_RECORDS validation masks, parallel to records
+    char *out_buf;              // PARSE_OUTPUT_BUFFER_SIZE bytes of stdio buffer for the output file
+} parse_workspace_t;
+
+/**
+ * @brief Options for parse_weather_file_ex
+ */
+typedef struct {
+    size_t mem_budget;       // Fail once peak RSS or live heap exceeds this many bytes (0 = unlimited)
+    int dedup;               // Drop records repeating an earlier (sensor_id, timestamp)
+    size_t dedup_mem_limit;  // Key set size before spilling to partitions (0 = DEDUP_DEFAULT_MEM_LIMIT)
+    int quiet;               // Suppress progress messages on stdout (errors still go to stderr)
+    parse_workspace_t *workspace; // Reused buffers (NULL = allocate per call)
+    rolling_stats_t *anomaly;     // Per-sensor rolling stats fed with every written record (NULL = off)
+    sketch_table_t *sketches;     // Quantile sketches fed with every written record (NULL = off)
+    sensor_meta_table_t *enrich;  // Sensor metadata joined onto every record (NULL = off)
+    int derive;                   // Compute and write dew point, heat index and wind u/v
+    record_validator_t *validate; // Range checks applied right after decoding (NULL = off)
+    sensor_snapshot_t *snapshot;  // Latest record per sensor, updated with every written record (NULL = off)
+    int iso_time;                 // Write timestamps as ISO-8601 UTC strings instead of Unix seconds
+    alert_rules_t *alerts;        // Alert rules evaluated on every written record (NULL = off)
+} parse_options_t;
+
 /*********************
  *    FUNCTIONS
  *********************/
@@ -40,6 +89,110 @@ int read_header(file_header_t *header, FILE *f);
  */
 int read_weather_record(weather_record_t *record, FILE *f);
 
+/**
+ * @brief Decode one packed weather record from a memory buffer
+ * 
+ * @param record Pointer to store record data
+ * @param buf Pointer to RECORD_SIZE bytes of packed record data
+ */
+void decode_weather_record(weather_record_t *record, const uint8_t *buf);
+
+/**
+ * @brief Decode a batch of packed weather records
+ * 
+ * Gathers one field at a time across the batch with the dispatched
+ * bulk loads from binary_io.h, then fills the record structs.
+ * 
+ * @param records Array of at least n records to fill
+ * @param buf Pointer to n * RECORD_SIZE bytes of packed record data
+ * @param n Number of records
+ */
+void decode_weather_batch(weather_record_t *records, const uint8_t *buf, size_t n);
+
+/**
+ * @brief Build the (sensor_id, timestamp) key used for dedup and sorting
+ * 
+ * @param sensor_id Sensor ID
+ * @param timestamp UNIX timestamp
+ * 
+ * @return (sensor_id << 32) | timestamp
+ */
+uint64_t record_key(uint32_t sensor_id, uint32_t timestamp);
+
+/**
+ * @brief Build the record key straight from a packed record
+ * 
+ * @param packed RECORD_SIZE bytes of packed record data
+ * 
+ * @return Same value as record_key() on the decoded record
+ */
+uint64_t record_key_packed(const uint8_t *packed);
+
+/**
+ * @brief Encode one weather record into packed binary form
+ * 
+ * @param buf Pointer to RECORD_SIZE bytes of output
+ * @param record Record to encode
+ */
+void encode_weather_record(uint8_t *buf, const weather_record_t *record);
+
+/**
+ * @brief Whether any stage of analyze_weather_batch is enabled
+ * 
+ * @param opts Options
+ * 
+ * @return 1 if enabled, 0 otherwise
+ */
+int analyze_enabled(const parse_options_t *opts);
+
+/**
+ * @brief Run the per-batch stages enabled in opts over decoded records
+ * 
+ * Joins sensor metadata (opts->enrich, calibrating in place if asked),
+ * then computes derived metrics (opts->derive) and feeds the rolling
+ * stats (opts->anomaly), quantile sketches (opts->sketches) and sensor
+ * snapshot (opts->snapshot), so all of them see calibrated values.
+ * 
+ * @param opts Options
+ * @param records Decoded records
+ * @param derived Filled with derived metrics when opts->derive is set
+ * @param n Number of records
+ * @param first_ordinal Output position of records[0]
+ * 
+ * @return 1 on success, 0 on out of memory or snapshot growth failure (with error message)
+ */
+int analyze_weather_batch(const parse_options_t *opts, weather_record_t *records,
+                          derived_metrics_t *derived, size_t n, uint64_t first_ordinal);
+
+/**
+ * @brief Write one record as JSON with the extra members enabled in opts
+ * 
+ * @param opts Options
+ * @param record Record
+ * @param derived Derived metrics of the record (read only when opts->derive is set)
+ * @param invalid Validation mask of the record (tagged when opts->validate tags)
+ * @param times Day cache of the output stream (used when opts->iso_time is set)
+ * @param f Output file pointer
+ * @param is_last Whether this is the last record (affects comma)
+ */
+void write_weather_json(const parse_options_t *opts, const weather_record_t *record,
+                        const derived_metrics_t *derived, uint16_t invalid,
+                        iso_time_cache_t *times, FILE *f, int is_last);
+
+/**
+ * @brief Run opts->validate over a decoded batch
+ * 
+ * @param opts Options
+ * @param records Decoded records, compacted in place when records are dropped
+ * @param invalid Array of at least n masks, parallel to the kept records
+ * @param n Number of records
+ * @param stats Stats to update (can be NULL)
+ * 
+ * @return Number of records kept
+ */
+size_t validate_weather_records(const parse_options_t *opts, weather_record_t *records,
+                                uint16_t *invalid, size_t n, conv_stats_t *stats);
+
 /**
  * @brief Validate file size against expected size
  * 
@@ -50,6 +203,22 @@ int read_weather_record(weather_record_t *record, FILE *f);
  */
 int validate_file_size(FILE *f, uint32_t record_count);
 
+/**
+ * @brief Allocate conversion buffers for reuse across parse_weather_file_ex calls
+ * 
+ * @param ws Workspace to fill
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int parse_workspace_init(parse_workspace_t *ws);
+
+/**
+ * @brief Release buffers allocated by parse_workspace_init
+ * 
+ * @param ws Workspace
+ */
+void parse_workspace_free(parse_workspace_t *ws);
+
 /**
  * @brief Parse entire weather data file
  * 
@@ -60,6 +229,22 @@ int validate_file_size(FILE *f, uint32_t record_count);
  */
 int parse_weather_file(const char *input_file, const char *output_file);
 
+/**
+ * @brief Parse entire weather data file and collect per-stage stats
+ * 
+ * Records are read in batches of READ_BATCH_RECORDS, decoded from the
+ * batch buffer and written out, so each stage can be timed separately.
+ * 
+ * @param input_file Path to input binary file
+ * @param output_file Path to output JSON file
+ * @param opts Options, or NULL for defaults
+ * @param stats Stats to fill in, or NULL to disable instrumentation
+ * 
+ * @return 0 on success, non-zero on error
+ */
+int parse_weather_file_ex(const char *input_file, const char *output_file,
+                          const parse_options_t *opts, conv_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,96 @@
+/**
+ * @file worker_pool.h
+ * @brief Fixed-size thread pool with a bounded job queue
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      TYPEDEFS
+ *********************/
+
+/**
+ * @brief Job handler, runs on a worker thread
+ * 
+ * @param job Job pointer passed to worker_pool_submit()
+ * @param worker_ctx Per-worker context (e.g. reusable buffers)
+ */
+typedef void (*worker_job_fn)(void *job, void *worker_ctx);
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    pthread_t *threads;
+    int n_threads;
+    void **worker_ctx;
+    worker_job_fn fn;
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    void **queue;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    int stopping;
+} worker_pool_t;
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+
+/**
+ * @brief Start worker threads
+ * 
+ * @param pool Pool to initialize
+ * @param n_threads Number of worker threads
+ * @param capacity Maximum number of queued jobs
+ * @param fn Job handler
+ * @param worker_ctx Array of n_threads contexts (or NULL), one per worker
+ * 
+ * @return 1 on success, 0 on failure
+ */
+int worker_pool_start(worker_pool_t *pool, int n_threads, size_t capacity,
+                      worker_job_fn fn, void **worker_ctx);
+
+/**
+ * @brief Queue a job, blocking while the queue is full
+ * 
+ * @param pool Pool
+ * @param job Job pointer handed to the handler
+ * 
+ * @return 1 if queued, 0 if the pool is stopping
+ */
+int worker_pool_submit(worker_pool_t *pool, void *job);
+
+/**
+ * @brief Finish all queued jobs, then join and release the workers
+ * 
+ * @param pool Pool
+ */
+void worker_pool_stop(worker_pool_t *pool);
+
+/**
+ * @brief Number of online CPUs, at least 1
+ * 
+ * @return CPU count
+ */
+int worker_pool_default_threads(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WORKER_POOL_H
\ No newline at end of file
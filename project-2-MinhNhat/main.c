@@ -6,20 +6,193 @@
  *    INCLUDES
  *********************/
 #include "weather_parser.h"
+#include "json_reader.h"
+#include "record_sort.h"
+#include "conv_stats.h"
+#include "cpu_dispatch.h"
+#include "conv_service.h"
+#include "shm_ring.h"
+#include "spool_watch.h"
+#include "record_sample.h"
+#include "record_compact.h"
+#include "record_partition.h"
+#include "spatial_index.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <unistd.h>
+#endif
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    MODE_CONVERT = 0,
+    MODE_JSON_TO_BIN,
+    MODE_SORT,
+    MODE_MERGE,
+    MODE_COMPACT,
+    MODE_SERVE,
+    MODE_SHM,
+    MODE_WATCH,
+    MODE_BUILD_INDEX,
+    MODE_BBOX,
+    MODE_SKETCH_MERGE,
+    MODE_SKETCH_QUERY,
+    MODE_SNAPSHOT_EXPORT
+} run_mode_t;
+
+typedef enum {
+    STATS_OFF = 0,
+    STATS_TEXT,
+    STATS_JSON
+} stats_mode_t;
 
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 static void print_usage(const char *program_name)
 {
-    printf("Usage: %s [input_file] [output_file]\n", program_name);
+    printf("Usage: %s [options] [input_file] [output_file]\n", program_name);
+    printf("       %s --sort [--sort-mem SIZE] input.bin output.bin\n", program_name);
+    printf("       %s --merge output.bin input.bin...\n", program_name);
+    printf("       %s --compact [--compact-size SIZE] [--compact-sort] [--dedup] PREFIX input...\n",
+           program_name);
+    printf("       %s --serve [SOCKET] [--workers N]\n", program_name);
+    printf("       %s --shm RING_NAME [output_file]\n", program_name);
+    printf("       %s --watch [--workers N] SPOOL_DIR OUTPUT_DIR ARCHIVE_DIR\n", program_name);
+    printf("       %s --build-index [--cell-deg D] [--sort-mem SIZE] input.bin indexed.bin\n", program_name);
+    printf("       %s --bbox MIN_LAT,MIN_LON,MAX_LAT,MAX_LON indexed.bin [output_file]\n", program_name);
+    printf("       %s --sketch-merge output.qsk input.qsk...\n", program_name);
+    printf("       %s --sketch-query [--rollup] input.qsk...\n", program_name);
+    printf("       %s --snapshot-export snapshot.snap [output.json]\n", program_name);
     printf("\n");
     printf("Arguments:\n");
     printf("  input_file   Path to binary weather data file (default: weather_data.bin)\n");
     printf("  output_file  Path to output JSON file (default: data/weather_data.json)\n");
     printf("\n");
+    printf("Options:\n");
+    printf("  -h, --help    Show this help\n");
+    printf("  --json-to-bin Convert weather JSON back to the binary format\n");
+    printf("                (defaults: data/weather_data.json -> weather_data.bin)\n");
+    printf("  --sort        Sort a binary file by (sensor_id, timestamp), larger than memory if needed\n");
+    printf("  --sort-mem SIZE\n");
+    printf("                Memory for one in-memory sort run of --sort or --build-index (default 256M)\n");
+    printf("  --merge       Merge already sorted binary files into one sorted file\n");
+    printf("  --compact     Append many small binary files (or directories of them) into\n");
+    printf("                PREFIX-00000.bin, ... and write PREFIX%s\n", COMPACT_MANIFEST_SUFFIX);
+    printf("  --compact-size SIZE\n");
+    printf("                Output file size before rolling over to the next one (default 256M)\n");
+    printf("  --compact-sort\n");
+    printf("                Sort each compacted file by (sensor_id, timestamp)\n");
+    printf("  --serve       Run as a conversion service on a Unix socket (default: %s);\n",
+           CONV_SERVICE_DEFAULT_SOCKET);
+    printf("                submit jobs with weather_client\n");
+    printf("  --shm         Convert records streamed through a POSIX shared-memory ring\n");
+    printf("                (see tools/shm_producer.c) instead of reading a file\n");
+    printf("  --watch       Convert each .bin file as soon as it is completed in SPOOL_DIR (inotify),\n");
+    printf("                writing OUTPUT_DIR/NAME.json and moving the input to ARCHIVE_DIR\n");
+    printf("  --workers N   Worker threads for --serve, --watch and --partition-by (default: one per CPU)\n");
+    printf("  --build-index Reorder a binary file by lat/lon grid cell and write indexed.bin.idx\n");
+    printf("  --cell-deg D  Grid cell size in degrees for --build-index (default %g)\n",
+           SPATIAL_DEFAULT_CELL_DEG);
+    printf("  --bbox BOX    Convert only records inside the box, reading only overlapping cells\n");
+    printf("  --sample SPEC Convert only a sample: stride:N (every Nth record, read by seeking) or\n");
+    printf("                reservoir:K[:SEED] (K records uniformly at random, default seed %#llx)\n",
+           SAMPLE_DEFAULT_SEED);
+    printf("  --partition-by KEY\n");
+    printf("                Write one JSON file per sensor, day or hour (UTC) under output_file,\n");
+    printf("                which is then a directory (default: data/partitions)\n");
+    printf("  --validate MODE\n");
+    printf("                Range-check every field after decoding: count (default), tag (add an\n");
+    printf("                \"invalid\" list), drop, clamp (NaN and missing CO2 are dropped) or off\n");
+    printf("  --range FIELD=MIN:MAX\n");
+    printf("                Override one validation range, e.g. temperature=-40:55 (repeatable)\n");
+    printf("  --iso-time    Write timestamps as ISO-8601 UTC strings (\"2024-01-01T08:30:00Z\")\n");
+    printf("  --derived     Add dew point, heat index and wind u/v components to every record\n");
+    printf("  --enrich FILE Join sensor metadata (JSON, keyed by sensor_id) onto every record\n");
+    printf("  --enrich-mode MODE\n");
+    printf("                fields (add a \"station\" object, default), calibrate (add the\n");
+    printf("                calibration offsets to the readings) or both\n");
+    printf("  --anomalies FILE\n");
+    printf("                Track per-sensor rolling mean/variance and write readings beyond\n");
+    printf("                the z-score threshold to FILE as JSON lines\n");
+    printf("  --rules FILE  Evaluate the alert rules in FILE (JSON) on every record in one pass\n");
+    printf("  --alerts FILE Write the alerts raised by --rules to FILE as JSON lines\n");
+    printf("  --zscore Z    Anomaly threshold in standard deviations (default %g)\n", ROLLING_DEFAULT_ZSCORE);
+    printf("  --ewma-alpha A\n");
+    printf("                Weight of the newest reading in the rolling stats (default %g)\n",
+           ROLLING_DEFAULT_ALPHA);
+    printf("  --sketch-out FILE\n");
+    printf("                Write temperature and CO2 quantile sketches per sensor and day to FILE\n");
+    printf("  --sketch-merge\n");
+    printf("                Merge sketch files exactly into one\n");
+    printf("  --sketch-query\n");
+    printf("                Print min/mean/p50/p95/p99/max per sensor, day and metric as JSON lines\n");
+    printf("  --snapshot FILE\n");
+    printf("                Keep the latest record of every sensor in the mmap-able table FILE,\n");
+    printf("                created if missing and updated in place\n");
+    printf("  --snapshot-export\n");
+    printf("                Write a snapshot table as compact JSON (stdout without output file)\n");
+    printf("  --rollup      With --sketch-query, merge all days of each sensor and metric\n");
+    printf("  --dedup       Drop records repeating an earlier (sensor_id, timestamp)\n");
+    printf("  --dedup-mem SIZE\n");
+    printf("                Memory for the dedup key set before spilling to disk (default 256M)\n");
+    printf("  --stats       Print per-stage timing and counters after conversion\n");
+    printf("  --stats-json  Print the same stats as one JSON line on stdout, progress on stderr\n");
+    printf("  --mem-budget SIZE\n");
+    printf("                Fail if peak RSS or live heap exceeds SIZE bytes (K/M/G suffix allowed)\n");
+    printf("\n");
+}
+
+static int parse_size(const char *text, size_t *out)
+{
+    char *end = NULL;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text)
+    {
+        return 0;
+    }
+    switch (*end)
+    {
+        case 'G': case 'g': value <<= 10; /* fall through */
+        case 'M': case 'm': value <<= 10; /* fall through */
+        case 'K': case 'k': value <<= 10; end++; break;
+        default: break;
+    }
+    if (*end != '\0')
+    {
+        return 0;
+    }
+    *out = (size_t)value;
+    return 1;
+}
+
+/* Point stdout at stderr and return a stream on the original stdout */
+static FILE* progress_to_stderr(void)
+{
+    fflush(stdout);
+    int fd = dup(fileno(stdout));
+    FILE *out = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!out)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return NULL;
+    }
+    if (dup2(fileno(stderr), fileno(stdout)) < 0)
+    {
+        fclose(out);
+        return NULL;
+    }
+    return out;
 }
 
 /**********************
@@ -27,17 +200,578 @@ static void print_usage(const char *program_name)
  **********************/
 int main(int argc, char **argv)
 {
+    const char *input_file;
+    const char *output_file;
+    const char *positionals[argc];
+    int n_positionals = 0;
+    run_mode_t mode = MODE_CONVERT;
+    stats_mode_t stats_mode = STATS_OFF;
+    parse_options_t opts = { 0 };
+    size_t sort_mem = 0;
+    compact_options_t compact = { 0 };
+    int workers = 0;
+    double cell_deg = 0;
+    geo_bbox_t bbox;
+    const char *anomaly_file = NULL;
+    const char *rules_file = NULL;
+    const char *alerts_file = NULL;
+    double z_threshold = 0;
+    double ewma_alpha = 0;
+    const char *sketch_file = NULL;
+    const char *enrich_file = NULL;
+    const char *snapshot_file = NULL;
+    sample_spec_t sample;
+    int sampling = 0;
+    partition_key_t partition_by = PARTITION_SENSOR;
+    int partitioning = 0;
+    int enrich_fields = 1;
+    int enrich_calibrate = 0;
+    int rollup = 0;
+    record_validator_t validator;
+    record_validator_init(&validator, VALIDATE_COUNT);
+
+    // Detect CPU features once, before any kernel runs
+    simd_level_t level = simd_level();
+
     // Parse command line arguments
-    const char *input_file = (argc > 1) ? argv[1] : "weather_data.bin";
-    const char *output_file = (argc > 2) ? argv[2] : "data/weather_data.json";
-    
-    // Check for help flag
-    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0))
+    for (int i = 1; i < argc; i++)
     {
-        print_usage(argv[0]);
-        return 0;
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--json-to-bin") == 0)
+        {
+            mode = MODE_JSON_TO_BIN;
+        }
+        else if (strcmp(argv[i], "--sort") == 0)
+        {
+            mode = MODE_SORT;
+        }
+        else if (strcmp(argv[i], "--merge") == 0)
+        {
+            mode = MODE_MERGE;
+        }
+        else if (strcmp(argv[i], "--compact") == 0)
+        {
+            mode = MODE_COMPACT;
+        }
+        else if (strcmp(argv[i], "--compact-sort") == 0)
+        {
+            compact.sort = 1;
+        }
+        else if (strcmp(argv[i], "--compact-size") == 0 && i + 1 < argc)
+        {
+            if (!parse_size(argv[++i], &compact.target_size))
+            {
+                fprintf(stderr, "ERROR: Invalid size '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--serve") == 0)
+        {
+            mode = MODE_SERVE;
+        }
+        else if (strcmp(argv[i], "--shm") == 0)
+        {
+            mode = MODE_SHM;
+        }
+        else if (strcmp(argv[i], "--watch") == 0)
+        {
+            mode = MODE_WATCH;
+        }
+        else if (strcmp(argv[i], "--build-index") == 0)
+        {
+            mode = MODE_BUILD_INDEX;
+        }
+        else if (strcmp(argv[i], "--cell-deg") == 0 && i + 1 < argc)
+        {
+            cell_deg = atof(argv[++i]);
+            if (!isfinite(cell_deg) || cell_deg <= 0)
+            {
+                fprintf(stderr, "ERROR: Invalid cell size '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--bbox") == 0 && i + 1 < argc)
+        {
+            mode = MODE_BBOX;
+            if (sscanf(argv[++i], "%lf,%lf,%lf,%lf", &bbox.min_lat, &bbox.min_lon,
+                       &bbox.max_lat, &bbox.max_lon) != 4)
+            {
+                fprintf(stderr, "ERROR: Invalid bounding box '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            workers = atoi(argv[++i]);
+            if (workers <= 0)
+            {
+                fprintf(stderr, "ERROR: Invalid worker count '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--sort-mem") == 0 && i + 1 < argc)
+        {
+            if (!parse_size(argv[++i], &sort_mem))
+            {
+                fprintf(stderr, "ERROR: Invalid size '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc)
+        {
+            if (!sample_spec_parse(argv[++i], &sample))
+            {
+                return 1;
+            }
+            sampling = 1;
+        }
+        else if (strcmp(argv[i], "--partition-by") == 0 && i + 1 < argc)
+        {
+            if (!partition_key_parse(argv[++i], &partition_by))
+            {
+                return 1;
+            }
+            partitioning = 1;
+        }
+        else if (strcmp(argv[i], "--validate") == 0 && i + 1 < argc)
+        {
+            if (!validate_action_from_name(argv[++i], &validator.action))
+            {
+                fprintf(stderr, "ERROR: Invalid validate mode '%s' (expected count, tag, drop, clamp or off)\n",
+                        argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--range") == 0 && i + 1 < argc)
+        {
+            if (!record_validator_set_range(&validator, argv[++i]))
+            {
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--derived") == 0)
+        {
+            opts.derive = 1;
+        }
+        else if (strcmp(argv[i], "--iso-time") == 0)
+        {
+            opts.iso_time = 1;
+        }
+        else if (strcmp(argv[i], "--enrich") == 0 && i + 1 < argc)
+        {
+            enrich_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--enrich-mode") == 0 && i + 1 < argc)
+        {
+            const char *m = argv[++i];
+            enrich_fields = strcmp(m, "fields") == 0 || strcmp(m, "both") == 0;
+            enrich_calibrate = strcmp(m, "calibrate") == 0 || strcmp(m, "both") == 0;
+            if (!enrich_fields && !enrich_calibrate)
+            {
+                fprintf(stderr, "ERROR: Invalid enrich mode '%s' (expected fields, calibrate or both)\n", m);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--anomalies") == 0 && i + 1 < argc)
+        {
+            anomaly_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc)
+        {
+            rules_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--alerts") == 0 && i + 1 < argc)
+        {
+            alerts_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--zscore") == 0 && i + 1 < argc)
+        {
+            z_threshold = atof(argv[++i]);
+            if (z_threshold <= 0)
+            {
+                fprintf(stderr, "ERROR: Invalid z-score threshold '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--ewma-alpha") == 0 && i + 1 < argc)
+        {
+            ewma_alpha = atof(argv[++i]);
+            if (ewma_alpha <= 0 || ewma_alpha > 1)
+            {
+                fprintf(stderr, "ERROR: Invalid EWMA alpha '%s' (expected 0 < A <= 1)\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--sketch-out") == 0 && i + 1 < argc)
+        {
+            sketch_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--sketch-merge") == 0)
+        {
+            mode = MODE_SKETCH_MERGE;
+        }
+        else if (strcmp(argv[i], "--sketch-query") == 0)
+        {
+            mode = MODE_SKETCH_QUERY;
+        }
+        else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+        {
+            snapshot_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--snapshot-export") == 0)
+        {
+            mode = MODE_SNAPSHOT_EXPORT;
+        }
+        else if (strcmp(argv[i], "--rollup") == 0)
+        {
+            rollup = 1;
+        }
+        else if (strcmp(argv[i], "--dedup") == 0)
+        {
+            opts.dedup = 1;
+        }
+        else if (strcmp(argv[i], "--dedup-mem") == 0 && i + 1 < argc)
+        {
+            if (!parse_size(argv[++i], &opts.dedup_mem_limit))
+            {
+                fprintf(stderr, "ERROR: Invalid size '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            stats_mode = STATS_TEXT;
+        }
+        else if (strcmp(argv[i], "--stats-json") == 0)
+        {
+            stats_mode = STATS_JSON;
+        }
+        else if (strcmp(argv[i], "--mem-budget") == 0 && i + 1 < argc)
+        {
+            if (!parse_size(argv[++i], &opts.mem_budget))
+            {
+                fprintf(stderr, "ERROR: Invalid size '%s'\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (argv[i][0] == '-' && argv[i][1] == '-')
+        {
+            fprintf(stderr, "ERROR: Unknown option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+        else
+        {
+            positionals[n_positionals++] = argv[i];
+        }
+    }
+
+    if (mode == MODE_SERVE)
+    {
+        return conv_service_run(n_positionals > 0 ? positionals[0] : CONV_SERVICE_DEFAULT_SOCKET, workers);
+    }
+    if (mode == MODE_SKETCH_MERGE)
+    {
+        if (n_positionals < 2)
+        {
+            fprintf(stderr, "ERROR: --sketch-merge needs an output file and at least one input\n");
+            return 1;
+        }
+        return merge_sketch_files(&positionals[1], n_positionals - 1, positionals[0]);
+    }
+    if (mode == MODE_SKETCH_QUERY)
+    {
+        if (n_positionals < 1)
+        {
+            fprintf(stderr, "ERROR: --sketch-query needs at least one sketch file\n");
+            return 1;
+        }
+        return query_sketch_files(positionals, n_positionals, rollup);
+    }
+    if (mode == MODE_SNAPSHOT_EXPORT)
+    {
+        if (n_positionals < 1)
+        {
+            fprintf(stderr, "ERROR: --snapshot-export needs a snapshot file\n");
+            return 1;
+        }
+        return export_sensor_snapshot(positionals[0], n_positionals > 1 ? positionals[1] : NULL);
+    }
+    if (mode == MODE_BUILD_INDEX)
+    {
+        if (n_positionals != 2)
+        {
+            fprintf(stderr, "ERROR: --build-index needs an input and an output file\n");
+            return 1;
+        }
+        return build_spatial_index(positionals[0], positionals[1], cell_deg, sort_mem);
+    }
+    if (mode == MODE_BBOX)
+    {
+        if (n_positionals < 1)
+        {
+            fprintf(stderr, "ERROR: --bbox needs an indexed input file\n");
+            return 1;
+        }
+        // The query only decodes and filters; say so instead of ignoring the flags
+        if (opts.dedup || opts.iso_time || sampling || partitioning || enrich_file || anomaly_file ||
+            rules_file || alerts_file || sketch_file || snapshot_file || validator.action != VALIDATE_COUNT)
+        {
+            fprintf(stderr, "ERROR: --bbox only supports --derived; validation, --iso-time, --dedup and the "
+                            "analysis options are not applied to queries\n");
+            return 1;
+        }
+        return query_spatial_bbox(positionals[0], &bbox,
+                                  n_positionals > 1 ? positionals[1] : "data/weather_data.json",
+                                  opts.derive);
+    }
+    if (mode == MODE_MERGE)
+    {
+        if (n_positionals < 2)
+        {
+            fprintf(stderr, "ERROR: --merge needs an output file and at least one input\n");
+            return 1;
+        }
+        return merge_weather_files(&positionals[1], n_positionals - 1, positionals[0]);
+    }
+    if (mode == MODE_COMPACT)
+    {
+        if (n_positionals < 2)
+        {
+            fprintf(stderr, "ERROR: --compact needs an output prefix and at least one input\n");
+            return 1;
+        }
+        compact.dedup = opts.dedup;
+        return compact_weather_files(&positionals[1], n_positionals - 1, positionals[0], &compact);
+    }
+    if (mode == MODE_SORT)
+    {
+        if (n_positionals != 2)
+        {
+            fprintf(stderr, "ERROR: --sort needs an input and an output file\n");
+            return 1;
+        }
+        return sort_weather_file(positionals[0], positionals[1], sort_mem);
+    }
+
+    input_file = (n_positionals > 0) ? positionals[0]
+               : (mode == MODE_JSON_TO_BIN) ? "data/weather_data.json" : "weather_data.bin";
+    output_file = (n_positionals > 1) ? positionals[1]
+                : (mode == MODE_JSON_TO_BIN) ? "weather_data.bin" : "data/weather_data.json";
+
+    if (validator.action != VALIDATE_OFF)
+    {
+        opts.validate = &validator;
+    }
+    if (sampling && (mode != MODE_CONVERT || opts.dedup))
+    {
+        fprintf(stderr, "ERROR: --sample only applies to binary -> JSON conversion without --dedup\n");
+        return 1;
+    }
+    if (partitioning && (mode != MODE_CONVERT || sampling))
+    {
+        fprintf(stderr, "ERROR: --partition-by only applies to binary -> JSON conversion without --sample\n");
+        return 1;
+    }
+    if (partitioning && n_positionals < 2)
+    {
+        output_file = "data/partitions";
+    }
+    if (mode == MODE_WATCH)
+    {
+        if (n_positionals != 3)
+        {
+            fprintf(stderr, "ERROR: --watch needs a spool, an output and an archive directory\n");
+            return 1;
+        }
+        // These stages keep one shared state for the whole run, which the
+        // concurrent per-file jobs of watch mode cannot share
+        if (enrich_file || anomaly_file || rules_file || alerts_file || sketch_file || snapshot_file)
+        {
+            fprintf(stderr, "ERROR: --enrich, --anomalies, --rules, --alerts, --sketch-out and --snapshot "
+                            "cannot be used with --watch\n");
+            return 1;
+        }
+        return spool_watch_run(positionals[0], positionals[1], positionals[2], &opts, workers);
+    }
+
+    sensor_meta_table_t enrich;
+    if (enrich_file)
+    {
+        if (!sensor_meta_load(&enrich, enrich_file, enrich_fields, enrich_calibrate))
+        {
+            return 1;
+        }
+        opts.enrich = &enrich;
+    }
+
+    rolling_stats_t anomaly;
+    FILE *anomaly_out = NULL;
+    if (anomaly_file)
+    {
+        anomaly_out = fopen(anomaly_file, "w");
+        if (!anomaly_out)
+        {
+            fprintf(stderr, "ERROR: Cannot open anomaly file '%s'\n", anomaly_file);
+            return 1;
+        }
+        if (!rolling_stats_init(&anomaly, ewma_alpha, z_threshold, anomaly_out))
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            fclose(anomaly_out);
+            return 1;
+        }
+        opts.anomaly = &anomaly;
+    }
+
+    alert_rules_t alerts;
+    FILE *alerts_out = NULL;
+    if (alerts_file && !rules_file)
+    {
+        fprintf(stderr, "ERROR: --alerts needs --rules\n");
+        return 1;
+    }
+    if (rules_file)
+    {
+        if (alerts_file)
+        {
+            alerts_out = fopen(alerts_file, "w");
+            if (!alerts_out)
+            {
+                fprintf(stderr, "ERROR: Cannot open alerts file '%s'\n", alerts_file);
+                return 1;
+            }
+        }
+        if (!alert_rules_load(&alerts, rules_file, alerts_out))
+        {
+            if (alerts_out)
+            {
+                fclose(alerts_out);
+            }
+            return 1;
+        }
+        opts.alerts = &alerts;
+    }
+
+    sketch_table_t sketches;
+    if (sketch_file)
+    {
+        if (!sketch_table_init(&sketches, 0))
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            return 1;
+        }
+        opts.sketches = &sketches;
+    }
+
+    sensor_snapshot_t snapshot;
+    if (snapshot_file)
+    {
+        if (!sensor_snapshot_open(&snapshot, snapshot_file, 1))
+        {
+            return 1;
+        }
+        opts.snapshot = &snapshot;
+    }
+
+    conv_stats_t stats;
+    conv_stats_t *stats_ptr = (stats_mode == STATS_OFF) ? NULL : &stats;
+    // The JSON line is meant for log collectors, so it gets stdout to itself
+    FILE *stats_out = stdout;
+    if (stats_mode == STATS_JSON && !(stats_out = progress_to_stderr()))
+    {
+        fprintf(stderr, "ERROR: Cannot move progress output to stderr\n");
+        return 1;
+    }
+    int rc;
+    if (mode == MODE_JSON_TO_BIN)
+    {
+        rc = convert_json_to_bin(input_file, output_file, stats_ptr);
+    }
+    else if (mode == MODE_SHM)
+    {
+        if (n_positionals < 1)
+        {
+            fprintf(stderr, "ERROR: --shm needs a ring name\n");
+            return 1;
+        }
+        rc = ingest_shm_ring(input_file, output_file, &opts, stats_ptr);
+    }
+    else if (partitioning)
+    {
+        rc = partition_weather_file(input_file, output_file, partition_by, workers, &opts, stats_ptr);
+    }
+    else if (sampling)
+    {
+        rc = sample_weather_file(input_file, output_file, &sample, &opts, stats_ptr);
+    }
+    else
+    {
+        // Parse the weather file
+        rc = parse_weather_file_ex(input_file, output_file, &opts, stats_ptr);
+    }
+
+    if (validator.invalid > 0)
+    {
+        record_validator_print_summary(&validator, stdout);
+    }
+    if (opts.enrich)
+    {
+        printf("Enrich: %zu sensors with metadata, %llu records without\n",
+               enrich.sensors, (unsigned long long)enrich.unmatched);
+        sensor_meta_free(&enrich);
+    }
+    if (opts.anomaly)
+    {
+        rolling_stats_print_summary(&anomaly, stdout);
+        rolling_stats_free(&anomaly);
+        fclose(anomaly_out);
+    }
+    if (opts.alerts)
+    {
+        alert_rules_print_summary(&alerts, stdout);
+        alert_rules_free(&alerts);
+        if (alerts_out)
+        {
+            fclose(alerts_out);
+        }
+    }
+    if (opts.snapshot)
+    {
+        printf("Snapshot: %u sensors, %llu records stored in %s\n", snapshot.hdr ? snapshot.hdr->sensors : 0,
+               (unsigned long long)snapshot.updated, snapshot_file);
+        sensor_snapshot_close(&snapshot);
+    }
+    if (opts.sketches)
+    {
+        if (rc == 0 && !sketch_table_save(&sketches, sketch_file))
+        {
+            rc = 1;
+        }
+        else if (rc == 0)
+        {
+            printf("Sketches: %zu (sensor, day, metric) sketches written to %s\n", sketches.size, sketch_file);
+        }
+        sketch_table_free(&sketches);
+    }
+
+    if (stats_mode == STATS_OFF)
+    {
+        return rc;
+    }
+    if (stats_mode == STATS_JSON)
+    {
+        conv_stats_print_json(&stats, input_file, output_file, stats_out);
+        fclose(stats_out);
+    }
+    else
+    {
+        printf("SIMD level: %s\n", simd_level_name(level));
+        conv_stats_print(&stats, stdout);
     }
-    
-    // Parse the weather file
-    return parse_weather_file(input_file, output_file);
+    return rc;
 }
\ No newline at end of file
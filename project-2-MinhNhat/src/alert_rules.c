@@ -0,0 +1,384 @@
+/**
+ * @file alert_rules.c
+ * @brief Alert rule compiler and one-pass evaluator
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "alert_rules.h"
+#include "mem_track.h"
+#include "util.h"
+#include "cJSON.h"
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define INITIAL_CAPACITY 256
+
+/*********************
+ *      CONSTANTS
+ *********************/
+static const char *const op_names[] = { "<", "<=", ">", ">=", "==", "!=", "change>" };
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static const char* field_name(unsigned field)
+{
+    return field == ALERT_SENSOR_ID ? "sensor_id" : validate_field_name((validate_field_t)field);
+}
+
+static double field_value(const weather_record_t *r, unsigned field)
+{
+    switch (field)
+    {
+        case VALIDATE_BATTERY:     return r->battery;
+        case VALIDATE_LAT:         return r->lat;
+        case VALIDATE_LON:         return r->lon;
+        case VALIDATE_TEMPERATURE: return r->temperature;
+        case VALIDATE_HUMIDITY:    return r->humidity;
+        case VALIDATE_PRESSURE:    return r->pressure;
+        case VALIDATE_CO2:         return r->co2 == 0xFFFF ? NAN : (double)r->co2;
+        case VALIDATE_WIND_SPEED:  return r->wind_speed;
+        case VALIDATE_WIND_DIR:    return r->wind_dir;
+        case VALIDATE_RAIN:        return r->rain;
+        case VALIDATE_UV:          return r->uv;
+        case VALIDATE_LIGHT:       return r->light;
+        default:                   return r->sensor_id;
+    }
+}
+
+static int compile_predicate(alert_rules_t *ar, const cJSON *cond, size_t rule, const char *path)
+{
+    const cJSON *field = cJSON_GetObjectItemCaseSensitive(cond, "field");
+    const cJSON *op = cJSON_GetObjectItemCaseSensitive(cond, "op");
+    const cJSON *value = cJSON_GetObjectItemCaseSensitive(cond, "value");
+    const char *rule_name = ar->names[rule];
+    if (!cJSON_IsString(field) || !cJSON_IsString(op) || !value)
+    {
+        fprintf(stderr, "ERROR: Rule '%s' in '%s' needs \"field\", \"op\" and \"value\"\n", rule_name, path);
+        return 0;
+    }
+
+    alert_pred_t pred;
+    memset(&pred, 0, sizeof(pred));
+    pred.rule = (uint8_t)rule;
+    pred.field = ALERT_FIELD_COUNT;
+    for (unsigned f = 0; f < ALERT_FIELD_COUNT; f++)
+    {
+        if (strcmp(field->valuestring, field_name(f)) == 0)
+        {
+            pred.field = (uint8_t)f;
+        }
+    }
+    pred.op = (uint8_t)(sizeof(op_names) / sizeof(op_names[0]));
+    for (unsigned o = 0; o < sizeof(op_names) / sizeof(op_names[0]); o++)
+    {
+        if (strcmp(op->valuestring, op_names[o]) == 0)
+        {
+            pred.op = (uint8_t)o;
+        }
+    }
+    if (pred.field == ALERT_FIELD_COUNT || pred.op == sizeof(op_names) / sizeof(op_names[0]))
+    {
+        fprintf(stderr, "ERROR: Rule '%s' has unknown field '%s' or operator '%s'\n",
+                rule_name, field->valuestring, op->valuestring);
+        return 0;
+    }
+
+    // Battery thresholds may be given by name
+    if (cJSON_IsNumber(value))
+    {
+        pred.threshold = value->valuedouble;
+    }
+    else if (cJSON_IsString(value) && pred.field == VALIDATE_BATTERY && pred.op != ALERT_CHANGE_GT)
+    {
+        pred.threshold = -1;
+        for (unsigned b = BATTERY_NORMAL; b <= BATTERY_EMERGENCY; b++)
+        {
+            if (strcmp(value->valuestring, battery_status_to_string((uint8_t)b)) == 0)
+            {
+                pred.threshold = b;
+            }
+        }
+        if (pred.threshold < 0)
+        {
+            fprintf(stderr, "ERROR: Rule '%s' has unknown battery status '%s'\n", rule_name, value->valuestring);
+            return 0;
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Rule '%s' needs a numeric value\n", rule_name);
+        return 0;
+    }
+
+    alert_pred_t *preds = (alert_pred_t*)mem_realloc(ar->preds, (ar->n_preds + 1) * sizeof(alert_pred_t));
+    if (!preds)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 0;
+    }
+    ar->preds = preds;
+    ar->preds[ar->n_preds++] = pred;
+    ar->used_fields |= 1u << pred.field;
+    if (pred.op == ALERT_CHANGE_GT)
+    {
+        ar->change_fields |= 1u << pred.field;
+    }
+    return 1;
+}
+
+static int compile_rule(alert_rules_t *ar, const cJSON *rule, const char *path)
+{
+    size_t index = ar->n_rules;
+    if (index == ALERT_MAX_RULES)
+    {
+        fprintf(stderr, "ERROR: More than %d rules in '%s'\n", ALERT_MAX_RULES, path);
+        return 0;
+    }
+    const cJSON *name = cJSON_GetObjectItemCaseSensitive(rule, "name");
+    if (!cJSON_IsString(name) || name->valuestring[0] == '\0' || strlen(name->valuestring) >= ALERT_NAME_SIZE)
+    {
+        fprintf(stderr, "ERROR: Every rule in '%s' needs a \"name\" of 1 to %d characters\n",
+                path, ALERT_NAME_SIZE - 1);
+        return 0;
+    }
+    for (const char *c = name->valuestring; *c; c++)
+    {
+        if (*c == '"' || *c == '\\' || (unsigned char)*c < 0x20)
+        {
+            fprintf(stderr, "ERROR: Rule name '%s' may not contain quotes, backslashes or control characters\n",
+                    name->valuestring);
+            return 0;
+        }
+    }
+    strcpy(ar->names[index], name->valuestring);
+    ar->n_rules++;
+
+    size_t first_pred = ar->n_preds;
+    const cJSON *all = cJSON_GetObjectItemCaseSensitive(rule, "all");
+    if (all)
+    {
+        if (!cJSON_IsArray(all) || cJSON_GetArraySize(all) == 0)
+        {
+            fprintf(stderr, "ERROR: \"all\" of rule '%s' must be a non-empty array\n", ar->names[index]);
+            return 0;
+        }
+        const cJSON *cond;
+        cJSON_ArrayForEach(cond, all)
+        {
+            if (!compile_predicate(ar, cond, index, path))
+            {
+                return 0;
+            }
+        }
+    }
+    else if (!compile_predicate(ar, rule, index, path))
+    {
+        return 0;
+    }
+    ar->first_field[index] = ar->preds[first_pred].field;
+    return 1;
+}
+
+static alert_sensor_t* find_or_add(alert_rules_t *ar, uint32_t sensor_id)
+{
+    if ((ar->sensors + 1) * 2 > ar->capacity)
+    {
+        size_t capacity = ar->capacity * 2;
+        alert_sensor_t *slots = (alert_sensor_t*)mem_calloc(capacity, sizeof(alert_sensor_t));
+        if (!slots)
+        {
+            return NULL;
+        }
+        for (size_t i = 0; i < ar->capacity; i++)
+        {
+            if (ar->slots[i].used)
+            {
+                size_t s = util_hash_slot(ar->slots[i].sensor_id, capacity - 1);
+                while (slots[s].used)
+                {
+                    s = util_probe_next(s, capacity - 1);
+                }
+                slots[s] = ar->slots[i];
+            }
+        }
+        mem_free(ar->slots);
+        ar->slots = slots;
+        ar->capacity = capacity;
+    }
+
+    size_t mask = ar->capacity - 1;
+    size_t s = util_hash_slot(sensor_id, mask);
+    while (ar->slots[s].used)
+    {
+        if (ar->slots[s].sensor_id == sensor_id)
+        {
+            return &ar->slots[s];
+        }
+        s = util_probe_next(s, mask);
+    }
+    alert_sensor_t *state = &ar->slots[s];
+    state->sensor_id = sensor_id;
+    state->used = 1;
+    for (int f = 0; f < ALERT_FIELD_COUNT; f++)
+    {
+        state->last[f] = NAN;
+    }
+    ar->sensors++;
+    return state;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int alert_rules_load(alert_rules_t *ar, const char *path, FILE *events)
+{
+    memset(ar, 0, sizeof(*ar));
+    ar->events = events;
+
+    char *text = util_read_file(path);
+    if (!text)
+    {
+        fprintf(stderr, "ERROR: Cannot read rules '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+    cJSON *root = cJSON_Parse(text);
+    mem_free(text);
+    const cJSON *list = cJSON_IsObject(root) ? cJSON_GetObjectItemCaseSensitive(root, "rules") : root;
+    if (!cJSON_IsArray(list) || cJSON_GetArraySize(list) == 0)
+    {
+        fprintf(stderr, "ERROR: Rules '%s' must be a non-empty array of rules or {\"rules\": [...]}\n", path);
+        cJSON_Delete(root);
+        return 0;
+    }
+    int ok = 1;
+    const cJSON *rule;
+    cJSON_ArrayForEach(rule, list)
+    {
+        if (!compile_rule(ar, rule, path))
+        {
+            ok = 0;
+            break;
+        }
+    }
+    cJSON_Delete(root);
+
+    if (ok && ar->change_fields)
+    {
+        ar->capacity = INITIAL_CAPACITY;
+        ar->slots = (alert_sensor_t*)mem_calloc(ar->capacity, sizeof(alert_sensor_t));
+        if (!ar->slots)
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            ok = 0;
+        }
+    }
+    if (!ok)
+    {
+        alert_rules_free(ar);
+    }
+    return ok;
+}
+
+int alert_rules_eval_batch(alert_rules_t *ar, const weather_record_t *records, size_t n,
+                           uint64_t first_ordinal)
+{
+    const uint64_t all_rules = ar->n_rules == 64 ? ~0ull : (1ull << ar->n_rules) - 1;
+    double value[ALERT_FIELD_COUNT];
+    double last[ALERT_FIELD_COUNT];
+    for (size_t i = 0; i < n; i++)
+    {
+        const weather_record_t *r = &records[i];
+        for (uint32_t m = ar->used_fields; m; m &= m - 1)
+        {
+            int f = __builtin_ctz(m);
+            value[f] = field_value(r, (unsigned)f);
+        }
+        alert_sensor_t *state = NULL;
+        if (ar->change_fields)
+        {
+            state = find_or_add(ar, r->sensor_id);
+            if (!state)
+            {
+                return 0;
+            }
+            memcpy(last, state->last, sizeof(last));
+        }
+
+        // A rule is out as soon as one of its predicates fails; NaN fails every compare
+        uint64_t failed = 0;
+        for (size_t p = 0; p < ar->n_preds; p++)
+        {
+            const alert_pred_t *pred = &ar->preds[p];
+            double x = value[pred->field];
+            int hit;
+            switch (pred->op)
+            {
+                case ALERT_LT: hit = x < pred->threshold; break;
+                case ALERT_LE: hit = x <= pred->threshold; break;
+                case ALERT_GT: hit = x > pred->threshold; break;
+                case ALERT_GE: hit = x >= pred->threshold; break;
+                case ALERT_EQ: hit = x == pred->threshold; break;
+                case ALERT_NE: hit = x != pred->threshold && !isnan(x); break;
+                default:       hit = fabs(x - last[pred->field]) > pred->threshold; break;
+            }
+            failed |= (uint64_t)!hit << pred->rule;
+        }
+
+        if (state)
+        {
+            for (uint32_t m = ar->change_fields; m; m &= m - 1)
+            {
+                int f = __builtin_ctz(m);
+                if (!isnan(value[f]))
+                {
+                    state->last[f] = value[f];
+                }
+            }
+        }
+
+        for (uint64_t fired = all_rules & ~failed; fired; fired &= fired - 1)
+        {
+            int rule = __builtin_ctzll(fired);
+            ar->fired[rule]++;
+            ar->alerts++;
+            if (ar->events)
+            {
+                fprintf(ar->events, "{\"record\":%llu,\"rule\":\"%s\",\"sensor_id\":%u,\"timestamp\":%u,"
+                        "\"field\":\"%s\",\"value\":%.2f}\n",
+                        (unsigned long long)(first_ordinal + i), ar->names[rule], r->sensor_id,
+                        r->timestamp, field_name(ar->first_field[rule]), value[ar->first_field[rule]]);
+            }
+        }
+    }
+    ar->records += n;
+    return 1;
+}
+
+void alert_rules_print_summary(const alert_rules_t *ar, FILE *f)
+{
+    fprintf(f, "Alerts: %llu in %llu records from %zu rules",
+            (unsigned long long)ar->alerts, (unsigned long long)ar->records, ar->n_rules);
+    for (size_t i = 0; i < ar->n_rules; i++)
+    {
+        fprintf(f, "%s%s %llu", i == 0 ? ": " : ", ", ar->names[i], (unsigned long long)ar->fired[i]);
+    }
+    fprintf(f, "\n");
+}
+
+void alert_rules_free(alert_rules_t *ar)
+{
+    mem_free(ar->preds);
+    mem_free(ar->slots);
+    ar->preds = NULL;
+    ar->slots = NULL;
+    ar->n_preds = 0;
+    ar->capacity = 0;
+    ar->sensors = 0;
+}
\ No newline at end of file
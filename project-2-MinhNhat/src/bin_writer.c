@@ -0,0 +1,154 @@
+/**
+ * @file bin_writer.c
+ * @brief Batched binary writer implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "bin_writer.h"
+#include "binary_io.h"
+#include "weather_parser.h"
+#include "mem_track.h"
+#include <string.h>
+#include <errno.h>
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static int flush_batch(bin_writer_t *w)
+{
+    if (w->batch_count == 0)
+    {
+        return 1;
+    }
+    size_t bytes = (size_t)w->batch_count * RECORD_SIZE;
+    int ok = fwrite(w->batch, 1, bytes, w->f) == bytes;
+    // Drop the batch either way so the buffer never overflows after an error
+    w->batch_count = 0;
+    if (!ok)
+    {
+        w->error = 1;
+        return 0;
+    }
+    w->bytes_written += bytes;
+    return 1;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+void encode_file_header(uint8_t *buf, const file_header_t *header)
+{
+    memcpy(buf, header->file_id, FILE_ID_SIZE);
+    store_u16_le(buf + 4, header->version);
+    store_u32_le(buf + 6, header->count);
+}
+
+int bin_writer_open(bin_writer_t *w, const char *path, const file_header_t *header)
+{
+    memset(w, 0, sizeof(*w));
+    w->header = *header;
+    w->header.count = 0;
+
+    w->f = fopen(path, "wb");
+    if (!w->f)
+    {
+        fprintf(stderr, "ERROR: Cannot open output file '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+
+    w->batch = (uint8_t*)mem_malloc((size_t)WRITE_BATCH_RECORDS * RECORD_SIZE);
+    if (!w->batch)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        fclose(w->f);
+        w->f = NULL;
+        return 0;
+    }
+
+    uint8_t hdr[HEADER_SIZE];
+    encode_file_header(hdr, &w->header);
+    if (fwrite(hdr, 1, HEADER_SIZE, w->f) != HEADER_SIZE)
+    {
+        w->error = 1;
+    }
+    w->bytes_written = HEADER_SIZE;
+    return 1;
+}
+
+int bin_writer_attach(bin_writer_t *w, FILE *f)
+{
+    memset(w, 0, sizeof(*w));
+    w->f = f;
+    w->raw = 1;
+    w->batch = (uint8_t*)mem_malloc((size_t)WRITE_BATCH_RECORDS * RECORD_SIZE);
+    return w->batch != NULL;
+}
+
+int bin_writer_write(bin_writer_t *w, const weather_record_t *record)
+{
+    if (w->error)
+    {
+        return 0;
+    }
+    encode_weather_record(w->batch + (size_t)w->batch_count * RECORD_SIZE, record);
+    w->header.count++;
+    if (++w->batch_count == WRITE_BATCH_RECORDS)
+    {
+        return flush_batch(w);
+    }
+    return 1;
+}
+
+int bin_writer_write_packed(bin_writer_t *w, const uint8_t *packed)
+{
+    if (w->error)
+    {
+        return 0;
+    }
+    memcpy(w->batch + (size_t)w->batch_count * RECORD_SIZE, packed, RECORD_SIZE);
+    w->header.count++;
+    if (++w->batch_count == WRITE_BATCH_RECORDS)
+    {
+        return flush_batch(w);
+    }
+    return 1;
+}
+
+int bin_writer_close(bin_writer_t *w)
+{
+    if (!w->f)
+    {
+        return 0;
+    }
+
+    flush_batch(w);
+
+    if (w->raw)
+    {
+        if (fflush(w->f) != 0)
+        {
+            w->error = 1;
+        }
+        w->f = NULL;
+        mem_free(w->batch);
+        w->batch = NULL;
+        return !w->error;
+    }
+
+    uint8_t hdr[HEADER_SIZE];
+    encode_file_header(hdr, &w->header);
+    if (fseek(w->f, 0, SEEK_SET) != 0 || fwrite(hdr, 1, HEADER_SIZE, w->f) != HEADER_SIZE)
+    {
+        w->error = 1;
+    }
+    if (fclose(w->f) != 0)
+    {
+        w->error = 1;
+    }
+    w->f = NULL;
+    mem_free(w->batch);
+    w->batch = NULL;
+    return !w->error;
+}
\ No newline at end of file
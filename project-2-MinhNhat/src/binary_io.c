@@ -7,8 +7,20 @@
  *    INCLUDES
  *********************/
 #include "binary_io.h"
+#include "cpu_dispatch.h"
 #include <string.h>
 
+#if SIMD_X86
+  #include <immintrin.h>
+#endif
+
+/*********************
+ *      TYPEDEFS
+ *********************/
+typedef void (*load_u16_strided_fn)(uint16_t *dst, const uint8_t *src, size_t stride, size_t n);
+typedef void (*load_u32_strided_fn)(uint32_t *dst, const uint8_t *src, size_t stride, size_t n);
+typedef void (*load_u64_strided_fn)(uint64_t *dst, const uint8_t *src, size_t stride, size_t n);
+
 /*********************
  *    FUNCTIONS
  *********************/
@@ -73,4 +85,282 @@ int read_f64_le(double *out, FILE *f)
     
     memcpy(out, &u, sizeof(double));
     return 1;
+}
+
+uint16_t load_u16_le(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+uint32_t load_u32_le(const uint8_t *p)
+{
+    return ((uint32_t)p[0]) |
+           ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+float load_f32_le(const uint8_t *p)
+{
+    uint32_t u = load_u32_le(p);
+    float out;
+    memcpy(&out, &u, sizeof(float));
+    return out;
+}
+
+double load_f64_le(const uint8_t *p)
+{
+    uint64_t u = ((uint64_t)load_u32_le(p)) |
+                 ((uint64_t)load_u32_le(p + 4) << 32);
+    double out;
+    memcpy(&out, &u, sizeof(double));
+    return out;
+}
+
+void store_u16_le(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+void store_u32_le(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    p[2] = (uint8_t)((v >> 16) & 0xFF);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+void store_f32_le(uint8_t *p, float v)
+{
+    uint32_t u;
+    memcpy(&u, &v, sizeof(float));
+    store_u32_le(p, u);
+}
+
+void store_f64_le(uint8_t *p, double v)
+{
+    uint64_t u;
+    memcpy(&u, &v, sizeof(double));
+    store_u32_le(p, (uint32_t)(u & 0xFFFFFFFFu));
+    store_u32_le(p + 4, (uint32_t)(u >> 32));
+}
+
+/*********************
+ *  STRIDED KERNELS
+ *********************/
+static void load_u16_strided_scalar(uint16_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[i] = load_u16_le(src + i * stride);
+    }
+}
+
+static void load_u32_strided_scalar(uint32_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[i] = load_u32_le(src + i * stride);
+    }
+}
+
+static void load_u64_strided_scalar(uint64_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[i] = ((uint64_t)load_u32_le(src + i * stride)) |
+                 ((uint64_t)load_u32_le(src + i * stride + 4) << 32);
+    }
+}
+
+#if SIMD_X86
+/*
+ * x86 is little-endian, so the vector kernels only have to gather.
+ * 16-bit gathers fetch 4 bytes per element; the vector loop stops one
+ * element early so the 2 extra bytes always fall inside the next value.
+ */
+__attribute__((target("sse4.2")))
+static void load_u16_strided_sse42(uint16_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const uint8_t *p = src + i * stride;
+        __m128i v = _mm_setzero_si128();
+        v = _mm_insert_epi16(v, (short)load_u16_le(p + 0 * stride), 0);
+        v = _mm_insert_epi16(v, (short)load_u16_le(p + 1 * stride), 1);
+        v = _mm_insert_epi16(v, (short)load_u16_le(p + 2 * stride), 2);
+        v = _mm_insert_epi16(v, (short)load_u16_le(p + 3 * stride), 3);
+        v = _mm_insert_epi16(v, (short)load_u16_le(p + 4 * stride), 4);
+        v = _mm_insert_epi16(v, (short)load_u16_le(p + 5 * stride), 5);
+        v = _mm_insert_epi16(v, (short)load_u16_le(p + 6 * stride), 6);
+        v = _mm_insert_epi16(v, (short)load_u16_le(p + 7 * stride), 7);
+        _mm_storeu_si128((__m128i*)(dst + i), v);
+    }
+    load_u16_strided_scalar(dst + i, src + i * stride, stride, n - i);
+}
+
+__attribute__((target("sse4.2")))
+static void load_u32_strided_sse42(uint32_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const uint8_t *p = src + i * stride;
+        uint32_t a, b, c, d;
+        memcpy(&a, p, 4);
+        memcpy(&b, p + stride, 4);
+        memcpy(&c, p + 2 * stride, 4);
+        memcpy(&d, p + 3 * stride, 4);
+        __m128i v = _mm_cvtsi32_si128((int)a);
+        v = _mm_insert_epi32(v, (int)b, 1);
+        v = _mm_insert_epi32(v, (int)c, 2);
+        v = _mm_insert_epi32(v, (int)d, 3);
+        _mm_storeu_si128((__m128i*)(dst + i), v);
+    }
+    load_u32_strided_scalar(dst + i, src + i * stride, stride, n - i);
+}
+
+__attribute__((target("sse4.2")))
+static void load_u64_strided_sse42(uint64_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        const uint8_t *p = src + i * stride;
+        __m128i lo = _mm_loadl_epi64((const __m128i*)p);
+        __m128i hi = _mm_loadl_epi64((const __m128i*)(p + stride));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi64(lo, hi));
+    }
+    load_u64_strided_scalar(dst + i, src + i * stride, stride, n - i);
+}
+
+__attribute__((target("avx2")))
+static void load_u16_strided_avx2(uint16_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    const int s = (int)stride;
+    const __m256i idx = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    size_t i = 0;
+    for (; i + 8 < n; i += 8)
+    {
+        __m256i v = _mm256_i32gather_epi32((const int*)(src + i * stride), idx, 1);
+        v = _mm256_and_si256(v, _mm256_set1_epi32(0xFFFF));
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storeu_si128((__m128i*)(dst + i), packed);
+    }
+    load_u16_strided_scalar(dst + i, src + i * stride, stride, n - i);
+}
+
+__attribute__((target("avx2")))
+static void load_u32_strided_avx2(uint32_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    const int s = (int)stride;
+    const __m256i idx = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_i32gather_epi32((const int*)(src + i * stride), idx, 1);
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+    }
+    load_u32_strided_scalar(dst + i, src + i * stride, stride, n - i);
+}
+
+__attribute__((target("avx2")))
+static void load_u64_strided_avx2(uint64_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    const int s = (int)stride;
+    const __m128i idx = _mm_setr_epi32(0, s, 2 * s, 3 * s);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i v = _mm256_i32gather_epi64((const long long*)(src + i * stride), idx, 1);
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+    }
+    load_u64_strided_scalar(dst + i, src + i * stride, stride, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void load_u16_strided_avx512(uint16_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    const __m512i idx = _mm512_mullo_epi32(
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm512_set1_epi32((int)stride));
+    size_t i = 0;
+    for (; i + 16 < n; i += 16)
+    {
+        __m512i v = _mm512_i32gather_epi32(idx, (const void*)(src + i * stride), 1);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm512_cvtepi32_epi16(v));
+    }
+    load_u16_strided_scalar(dst + i, src + i * stride, stride, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void load_u32_strided_avx512(uint32_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    const __m512i idx = _mm512_mullo_epi32(
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm512_set1_epi32((int)stride));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512i v = _mm512_i32gather_epi32(idx, (const void*)(src + i * stride), 1);
+        _mm512_storeu_si512((void*)(dst + i), v);
+    }
+    load_u32_strided_scalar(dst + i, src + i * stride, stride, n - i);
+}
+
+__attribute__((target("avx512f")))
+static void load_u64_strided_avx512(uint64_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    const int s = (int)stride;
+    const __m256i idx = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512i v = _mm512_i32gather_epi64(idx, (const void*)(src + i * stride), 1);
+        _mm512_storeu_si512((void*)(dst + i), v);
+    }
+    load_u64_strided_scalar(dst + i, src + i * stride, stride, n - i);
+}
+#endif
+
+/*********************
+ *  DISPATCH TABLES
+ *********************/
+#if SIMD_X86
+static const load_u16_strided_fn load_u16_strided_impl[SIMD_LEVEL_COUNT] = {
+    load_u16_strided_scalar, load_u16_strided_sse42, load_u16_strided_avx2, load_u16_strided_avx512
+};
+static const load_u32_strided_fn load_u32_strided_impl[SIMD_LEVEL_COUNT] = {
+    load_u32_strided_scalar, load_u32_strided_sse42, load_u32_strided_avx2, load_u32_strided_avx512
+};
+static const load_u64_strided_fn load_u64_strided_impl[SIMD_LEVEL_COUNT] = {
+    load_u64_strided_scalar, load_u64_strided_sse42, load_u64_strided_avx2, load_u64_strided_avx512
+};
+#else
+static const load_u16_strided_fn load_u16_strided_impl[SIMD_LEVEL_COUNT] = {
+    load_u16_strided_scalar, load_u16_strided_scalar, load_u16_strided_scalar, load_u16_strided_scalar
+};
+static const load_u32_strided_fn load_u32_strided_impl[SIMD_LEVEL_COUNT] = {
+    load_u32_strided_scalar, load_u32_strided_scalar, load_u32_strided_scalar, load_u32_strided_scalar
+};
+static const load_u64_strided_fn load_u64_strided_impl[SIMD_LEVEL_COUNT] = {
+    load_u64_strided_scalar, load_u64_strided_scalar, load_u64_strided_scalar, load_u64_strided_scalar
+};
+#endif
+
+void load_u16_le_strided(uint16_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    load_u16_strided_impl[simd_level()](dst, src, stride, n);
+}
+
+void load_u32_le_strided(uint32_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    load_u32_strided_impl[simd_level()](dst, src, stride, n);
+}
+
+void load_u64_le_strided(uint64_t *dst, const uint8_t *src, size_t stride, size_t n)
+{
+    load_u64_strided_impl[simd_level()](dst, src, stride, n);
 }
\ No newline at end of file
@@ -0,0 +1,364 @@
+/**
+ * @file conv_service.c
+ * @brief Conversion service implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "conv_service.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+
+int conv_service_run(const char *socket_path, int n_workers)
+{
+    (void)socket_path;
+    (void)n_workers;
+    fprintf(stderr, "ERROR: Service mode is not supported on this platform\n");
+    return 1;
+}
+
+#else
+
+#include "weather_parser.h"
+#include "json_reader.h"
+#include "conv_stats.h"
+#include "worker_pool.h"
+#include "mem_track.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    int fd;
+    uint64_t id;
+    uint64_t t_queued;
+} service_job_t;
+
+/*********************
+ *  STATIC VARIABLES
+ *********************/
+static volatile sig_atomic_t stop_requested = 0;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static void on_stop_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static int read_request_line(int fd, char *line, size_t size)
+{
+    size_t len = 0;
+    while (len + 1 < size)
+    {
+        ssize_t n = read(fd, line + len, size - 1 - len);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)  // EOF, error or SO_RCVTIMEO expired
+        {
+            break;
+        }
+        char *nl = memchr(line + len, '\n', (size_t)n);
+        len += (size_t)n;
+        if (nl)
+        {
+            *nl = '\0';
+            return 1;
+        }
+    }
+    line[len] = '\0';
+    return 0;
+}
+
+static void reply(int fd, const char *text)
+{
+    size_t len = strlen(text);
+    while (len > 0)
+    {
+        ssize_t n = write(fd, text, len);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return;
+        }
+        text += n;
+        len -= (size_t)n;
+    }
+}
+
+static void run_job(void *arg, void *worker_ctx)
+{
+    service_job_t *job = (service_job_t*)arg;
+    parse_workspace_t *ws = (parse_workspace_t*)worker_ctx;
+    char line[CONV_SERVICE_MAX_LINE];
+    uint64_t queue_ns = stats_now_ns() - job->t_queued;
+
+    if (!read_request_line(job->fd, line, sizeof(line)))
+    {
+        reply(job->fd, "ERR incomplete request line\n");
+        goto done;
+    }
+
+    // CONVERT <format> <filters> <input> <output>
+    char *fields[5];
+    int n_fields = 0;
+    char *save = NULL;
+    for (char *tok = strtok_r(line, "\t", &save); tok && n_fields < 5; tok = strtok_r(NULL, "\t", &save))
+    {
+        fields[n_fields++] = tok;
+    }
+    if (n_fields != 5 || strcmp(fields[0], "CONVERT") != 0)
+    {
+        reply(job->fd, "ERR expected CONVERT<TAB>format<TAB>filters<TAB>input<TAB>output\n");
+        goto done;
+    }
+    const char *format = fields[1];
+    const char *input_file = fields[3];
+    const char *output_file = fields[4];
+    if (strcmp(format, "bin") == 0 && strcmp(fields[2], "-") != 0)
+    {
+        reply(job->fd, "ERR filters not supported for bin\n");
+        goto done;
+    }
+
+    // Jobs validate in count-only mode, like the CLI default
+    record_validator_t validator;
+    record_validator_init(&validator, VALIDATE_COUNT);
+    parse_options_t opts = { 0 };
+    opts.quiet = 1;
+    opts.workspace = ws;
+    opts.validate = &validator;
+    if (strcmp(fields[2], "-") != 0)
+    {
+        for (char *f = strtok_r(fields[2], ",", &save); f; f = strtok_r(NULL, ",", &save))
+        {
+            if (strcmp(f, "dedup") == 0)
+            {
+                opts.dedup = 1;
+            }
+            else if (strcmp(f, "derived") == 0)
+            {
+                opts.derive = 1;
+            }
+            else if (strcmp(f, "iso-time") == 0)
+            {
+                opts.iso_time = 1;
+            }
+            else
+            {
+                reply(job->fd, "ERR unknown filter\n");
+                goto done;
+            }
+        }
+    }
+
+    conv_stats_t stats;
+    int rc;
+    if (strcmp(format, "json") == 0)
+    {
+        rc = parse_weather_file_ex(input_file, output_file, &opts, &stats);
+    }
+    else if (strcmp(format, "bin") == 0)
+    {
+        rc = convert_json_to_bin(input_file, output_file, &stats);
+    }
+    else
+    {
+        reply(job->fd, "ERR unknown format (expected json or bin)\n");
+        goto done;
+    }
+
+    FILE *resp = fdopen(job->fd, "w");
+    if (resp)
+    {
+        if (rc == 0)
+        {
+            // Memory counters are process-wide and would mix concurrent jobs
+            fprintf(resp, "OK queue_ns=%llu ", (unsigned long long)queue_ns);
+            conv_stats_print_json_ex(&stats, input_file, output_file, 0, resp);
+        }
+        else
+        {
+            fprintf(resp, "ERR conversion failed with code %d (see service log)\n", rc);
+        }
+        fclose(resp);
+        job->fd = -1;
+    }
+
+    flockfile(stdout);
+    printf("job %llu rc=%d queue_ns=%llu ", (unsigned long long)job->id, rc,
+           (unsigned long long)queue_ns);
+    conv_stats_print_json_ex(&stats, input_file, output_file, 0, stdout);
+    fflush(stdout);
+    funlockfile(stdout);
+
+done:
+    if (job->fd >= 0)
+    {
+        close(job->fd);
+    }
+    mem_free(job);
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int conv_service_run(const char *socket_path, int n_workers)
+{
+    struct sockaddr_un addr;
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "ERROR: Socket path too long: %s\n", socket_path);
+        return 1;
+    }
+    if (n_workers <= 0)
+    {
+        n_workers = worker_pool_default_threads();
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+        fprintf(stderr, "ERROR: socket: %s\n", strerror(errno));
+        return 1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 64) != 0)
+    {
+        fprintf(stderr, "ERROR: Cannot listen on '%s': %s\n", socket_path, strerror(errno));
+        close(listen_fd);
+        return 1;
+    }
+
+    // One warm workspace per worker thread
+    parse_workspace_t *workspaces = (parse_workspace_t*)mem_calloc((size_t)n_workers, sizeof(parse_workspace_t));
+    void **ctx = (void**)mem_calloc((size_t)n_workers, sizeof(void*));
+    int ok = workspaces && ctx;
+    for (int i = 0; ok && i < n_workers; i++)
+    {
+        ok = parse_workspace_init(&workspaces[i]);
+        ctx[i] = &workspaces[i];
+    }
+
+    // Block the shutdown signals before the workers start so they inherit the
+    // mask; only pselect() in the accept loop below lets them through
+    sigset_t stop_signals;
+    sigset_t old_mask;
+    sigset_t wait_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+    wait_mask = old_mask;
+    sigdelset(&wait_mask, SIGINT);
+    sigdelset(&wait_mask, SIGTERM);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    worker_pool_t pool;
+    if (!ok || !worker_pool_start(&pool, n_workers, CONV_SERVICE_QUEUE_DEPTH, run_job, ctx))
+    {
+        fprintf(stderr, "ERROR: Cannot start %d workers\n", n_workers);
+        ok = 0;
+    }
+
+    uint64_t next_id = 1;
+    if (ok)
+    {
+        printf("Listening on %s with %d workers\n", socket_path, n_workers);
+        fflush(stdout);
+    }
+    while (ok && !stop_requested)
+    {
+        // A signal arriving before pselect() is still pending, so it interrupts it
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listen_fd, &readable);
+        if (pselect(listen_fd + 1, &readable, NULL, NULL, NULL, &wait_mask) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "ERROR: pselect: %s\n", strerror(errno));
+            break;
+        }
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            fprintf(stderr, "ERROR: accept: %s\n", strerror(errno));
+            break;
+        }
+
+        // An idle client gives up its worker after the timeout
+        struct timeval timeout = { CONV_SERVICE_READ_TIMEOUT_SEC, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        service_job_t *job = (service_job_t*)mem_malloc(sizeof(service_job_t));
+        if (!job)
+        {
+            reply(fd, "ERR out of memory\n");
+            close(fd);
+            continue;
+        }
+        job->fd = fd;
+        job->id = next_id++;
+        job->t_queued = stats_now_ns();
+        if (!worker_pool_submit(&pool, job))
+        {
+            close(fd);
+            mem_free(job);
+        }
+    }
+
+    close(listen_fd);
+    unlink(socket_path);
+    if (ok)
+    {
+        // Finish the jobs already accepted before exiting
+        worker_pool_stop(&pool);
+        printf("Service stopped after %llu jobs\n", (unsigned long long)(next_id - 1));
+    }
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    for (int i = 0; workspaces && i < n_workers; i++)
+    {
+        parse_workspace_free(&workspaces[i]);
+    }
+    mem_free(workspaces);
+    mem_free(ctx);
+    return ok ? 0 : 1;
+}
+
+#endif
\ No newline at end of file
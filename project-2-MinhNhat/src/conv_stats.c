@@ -0,0 +1,184 @@
+/**
+ * @file conv_stats.c
+ * @brief Conversion stats implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#ifndef _WIN32
+  #define _POSIX_C_SOURCE 200809L
+#endif
+#include "conv_stats.h"
+#include "mem_track.h"
+#include <time.h>
+
+#ifdef _WIN32
+  #include <windows.h>
+#endif
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static double ns_to_ms(uint64_t ns)
+{
+    return (double)ns / 1e6;
+}
+
+static double records_per_sec(const conv_stats_t *stats)
+{
+    if (stats->total_ns == 0)
+    {
+        return 0.0;
+    }
+    return (double)stats->records * 1e9 / (double)stats->total_ns;
+}
+
+static double bytes_to_mib(uint64_t bytes)
+{
+    return (double)bytes / (1024.0 * 1024.0);
+}
+
+static void print_json_string(const char *s, FILE *f)
+{
+    fputc('"', f);
+    for (; s && *s; s++)
+    {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+        {
+            fputc('\\', f);
+            fputc(c, f);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(f, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+uint64_t stats_now_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void conv_stats_end_stage(conv_stats_t *stats, conv_stage_t stage, uint64_t *t_mark)
+{
+    uint64_t t = stats_now_ns();
+    stats->stage_ns[stage] += t - *t_mark;
+    *t_mark = t;
+
+    uint64_t heap = mem_window_peak_bytes();
+    uint64_t rss = mem_peak_rss_bytes();
+    if (heap > stats->stage_heap_peak[stage])
+    {
+        stats->stage_heap_peak[stage] = heap;
+    }
+    if (rss > stats->stage_rss_peak[stage])
+    {
+        stats->stage_rss_peak[stage] = rss;
+    }
+    mem_window_reset();
+}
+
+const char* conv_stage_name(conv_stage_t stage)
+{
+    switch (stage)
+    {
+        case STAGE_READ:     return "read";
+        case STAGE_DECODE:   return "decode";
+        case STAGE_VALIDATE: return "validate";
+        case STAGE_ANALYZE:  return "analyze";
+        case STAGE_WRITE:    return "write";
+        default:             return "unknown";
+    }
+}
+
+void conv_stats_print(const conv_stats_t *stats, FILE *f)
+{
+    fprintf(f, "Stats:\n");
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        double pct = stats->total_ns ? 100.0 * (double)stats->stage_ns[s] / (double)stats->total_ns : 0.0;
+        fprintf(f, "  %-8s %10.3f ms (%5.1f%%)  heap peak %8.2f MiB  rss peak %8.2f MiB\n",
+                conv_stage_name((conv_stage_t)s), ns_to_ms(stats->stage_ns[s]), pct,
+                bytes_to_mib(stats->stage_heap_peak[s]), bytes_to_mib(stats->stage_rss_peak[s]));
+    }
+    fprintf(f, "  %-8s %10.3f ms\n", "total", ns_to_ms(stats->total_ns));
+    fprintf(f, "  Records:       %llu (%.0f records/s)\n",
+            (unsigned long long)stats->records, records_per_sec(stats));
+    fprintf(f, "  Bytes read:    %llu\n", (unsigned long long)stats->bytes_read);
+    fprintf(f, "  Bytes written: %llu\n", (unsigned long long)stats->bytes_written);
+    fprintf(f, "  Short reads:   %llu\n", (unsigned long long)stats->short_reads);
+    fprintf(f, "  Duplicates:    %llu\n", (unsigned long long)stats->duplicates);
+    fprintf(f, "  Anomalies:     %llu\n", (unsigned long long)stats->anomalies);
+    fprintf(f, "  Invalid:       %llu\n", (unsigned long long)stats->invalid);
+    fprintf(f, "  Heap peak:     %.2f MiB\n", bytes_to_mib(stats->heap_peak_bytes));
+    fprintf(f, "  RSS peak:      %.2f MiB\n", bytes_to_mib(stats->rss_peak_bytes));
+}
+
+void conv_stats_print_json(const conv_stats_t *stats, const char *input_file,
+                           const char *output_file, FILE *f)
+{
+    conv_stats_print_json_ex(stats, input_file, output_file, 1, f);
+}
+
+void conv_stats_print_json_ex(const conv_stats_t *stats, const char *input_file,
+                              const char *output_file, int with_memory, FILE *f)
+{
+    fprintf(f, "{\"input\":");
+    print_json_string(input_file, f);
+    fprintf(f, ",\"output\":");
+    print_json_string(output_file, f);
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        const char *name = conv_stage_name((conv_stage_t)s);
+        fprintf(f, ",\"%s_ns\":%llu", name, (unsigned long long)stats->stage_ns[s]);
+        if (with_memory)
+        {
+            fprintf(f, ",\"%s_heap_peak\":%llu,\"%s_rss_peak\":%llu",
+                    name, (unsigned long long)stats->stage_heap_peak[s],
+                    name, (unsigned long long)stats->stage_rss_peak[s]);
+        }
+    }
+    fprintf(f, ",\"total_ns\":%llu,\"records\":%llu,\"records_per_sec\":%.1f,"
+               "\"bytes_read\":%llu,\"bytes_written\":%llu,\"short_reads\":%llu,\"duplicates\":%llu,"
+               "\"anomalies\":%llu,\"invalid\":%llu",
+            (unsigned long long)stats->total_ns,
+            (unsigned long long)stats->records,
+            records_per_sec(stats),
+            (unsigned long long)stats->bytes_read,
+            (unsigned long long)stats->bytes_written,
+            (unsigned long long)stats->short_reads,
+            (unsigned long long)stats->duplicates,
+            (unsigned long long)stats->anomalies,
+            (unsigned long long)stats->invalid);
+    if (with_memory)
+    {
+        fprintf(f, ",\"heap_peak\":%llu,\"rss_peak\":%llu",
+                (unsigned long long)stats->heap_peak_bytes,
+                (unsigned long long)stats->rss_peak_bytes);
+    }
+    fprintf(f, "}\n");
+}
\ No newline at end of file
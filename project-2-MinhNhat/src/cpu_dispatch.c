@@ -0,0 +1,144 @@
+/**
+ * @file cpu_dispatch.c
+ * @brief Runtime CPU feature detection implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "cpu_dispatch.h"
+#include <string.h>
+
+#if SIMD_X86
+  #include <cpuid.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+// Set from the WEATHER_SIMD_LEVEL CMake option to force a level for testing
+#ifndef WEATHER_FORCE_SIMD_LEVEL
+  #define WEATHER_FORCE_SIMD_LEVEL SIMD_AVX512
+#endif
+
+#define LEVEL_UNKNOWN (-1)
+
+/*********************
+ *  STATIC VARIABLES
+ *********************/
+static int detected_level = LEVEL_UNKNOWN;
+static int active_level = LEVEL_UNKNOWN;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+#if SIMD_X86
+static uint64_t read_xcr0(void)
+{
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+#endif
+
+static simd_level_t min_level(simd_level_t a, simd_level_t b)
+{
+    return a < b ? a : b;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+simd_level_t cpu_detect_simd_level(void)
+{
+#if SIMD_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return SIMD_SCALAR;
+    }
+    int has_sse42 = (ecx >> 20) & 1;
+    int has_osxsave = (ecx >> 27) & 1;
+    if (!has_sse42)
+    {
+        return SIMD_SCALAR;
+    }
+    if (!has_osxsave)
+    {
+        return SIMD_SSE42;
+    }
+
+    uint64_t xcr0 = read_xcr0();
+    int os_ymm = (xcr0 & 0x6) == 0x6;     // SSE + AVX state
+    int os_zmm = (xcr0 & 0xE6) == 0xE6;   // + opmask, ZMM_Hi256, Hi16_ZMM
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    {
+        return SIMD_SSE42;
+    }
+    int has_avx2 = (ebx >> 5) & 1;
+    int has_avx512f = (ebx >> 16) & 1;
+
+    if (has_avx512f && os_zmm)
+    {
+        return SIMD_AVX512;
+    }
+    if (has_avx2 && os_ymm)
+    {
+        return SIMD_AVX2;
+    }
+    return SIMD_SSE42;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+simd_level_t simd_level(void)
+{
+    int level = __atomic_load_n(&active_level, __ATOMIC_RELAXED);
+    if (level == LEVEL_UNKNOWN)
+    {
+        level = (int)simd_set_level((simd_level_t)WEATHER_FORCE_SIMD_LEVEL);
+    }
+    return (simd_level_t)level;
+}
+
+simd_level_t simd_set_level(simd_level_t level)
+{
+    int detected = __atomic_load_n(&detected_level, __ATOMIC_RELAXED);
+    if (detected == LEVEL_UNKNOWN)
+    {
+        detected = (int)cpu_detect_simd_level();
+        __atomic_store_n(&detected_level, detected, __ATOMIC_RELAXED);
+    }
+
+    simd_level_t selected = min_level(level, (simd_level_t)detected);
+    selected = min_level(selected, (simd_level_t)WEATHER_FORCE_SIMD_LEVEL);
+    __atomic_store_n(&active_level, (int)selected, __ATOMIC_RELAXED);
+    return selected;
+}
+
+const char* simd_level_name(simd_level_t level)
+{
+    switch (level)
+    {
+        case SIMD_SCALAR: return "scalar";
+        case SIMD_SSE42:  return "sse4.2";
+        case SIMD_AVX2:   return "avx2";
+        case SIMD_AVX512: return "avx512";
+        default:          return "unknown";
+    }
+}
+
+int simd_level_from_name(const char *name, simd_level_t *out)
+{
+    for (int l = 0; l < SIMD_LEVEL_COUNT; l++)
+    {
+        if (strcmp(name, simd_level_name((simd_level_t)l)) == 0)
+        {
+            *out = (simd_level_t)l;
+            return 1;
+        }
+    }
+    return 0;
+}
\ No newline at end of file
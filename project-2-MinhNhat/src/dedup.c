@@ -0,0 +1,250 @@
+/**
+ * @file dedup.c
+ * @brief Duplicate detection implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "dedup.h"
+#include "binary_io.h"
+#include "weather_types.h"
+#include "weather_parser.h"
+#include "mem_track.h"
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SPILL_ENTRY_SIZE 12   // u64 key + u32 ordinal
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+static size_t capacity_for(size_t keys)
+{
+    size_t cap = 16;
+    while (cap < keys * 2)
+    {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+static void insert_slot(uint64_t *slots, size_t mask, uint64_t key)
+{
+    size_t i = (size_t)mix64(key) & mask;
+    while (slots[i] != 0)
+    {
+        i = (i + 1) & mask;
+    }
+    slots[i] = key;
+}
+
+static int grow(dedup_set_t *set)
+{
+    size_t new_cap = set->capacity * 2;
+    uint64_t *slots = (uint64_t*)mem_calloc(new_cap, sizeof(uint64_t));
+    if (!slots)
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < set->capacity; i++)
+    {
+        if (set->slots[i] != 0)
+        {
+            insert_slot(slots, new_cap - 1, set->slots[i]);
+        }
+    }
+    mem_free(set->slots);
+    set->slots = slots;
+    set->capacity = new_cap;
+    return 1;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+size_t dedup_set_bytes(size_t keys)
+{
+    return capacity_for(keys) * sizeof(uint64_t);
+}
+
+int dedup_set_init(dedup_set_t *set, size_t expected)
+{
+    memset(set, 0, sizeof(*set));
+    set->capacity = capacity_for(expected);
+    set->slots = (uint64_t*)mem_calloc(set->capacity, sizeof(uint64_t));
+    return set->slots != NULL;
+}
+
+int dedup_set_insert(dedup_set_t *set, uint64_t key)
+{
+    if (key == 0)
+    {
+        if (set->has_zero)
+        {
+            return 0;
+        }
+        set->has_zero = 1;
+        return 1;
+    }
+
+    size_t mask = set->capacity - 1;
+    size_t i = (size_t)mix64(key) & mask;
+    while (set->slots[i] != 0)
+    {
+        if (set->slots[i] == key)
+        {
+            return 0;
+        }
+        i = (i + 1) & mask;
+    }
+
+    if ((set->size + 1) * 2 > set->capacity)
+    {
+        if (!grow(set))
+        {
+            return -1;
+        }
+        insert_slot(set->slots, set->capacity - 1, key);
+    }
+    else
+    {
+        set->slots[i] = key;
+    }
+    set->size++;
+    return 1;
+}
+
+void dedup_set_free(dedup_set_t *set)
+{
+    mem_free(set->slots);
+    memset(set, 0, sizeof(*set));
+}
+
+int dedup_mark_partitioned(FILE *fin, long data_offset, uint32_t count, unsigned partitions,
+                           uint8_t *dup_bitmap, uint64_t *dups)
+{
+    FILE *parts[DEDUP_MAX_PARTITIONS] = { 0 };
+    uint32_t part_sizes[DEDUP_MAX_PARTITIONS] = { 0 };
+    uint8_t *batch = NULL;
+    int ok = 0;
+    long saved_pos = ftell(fin);
+
+    *dups = 0;
+    if (partitions < 1)
+    {
+        partitions = 1;
+    }
+    if (partitions > DEDUP_MAX_PARTITIONS)
+    {
+        partitions = DEDUP_MAX_PARTITIONS;
+    }
+
+    for (unsigned p = 0; p < partitions; p++)
+    {
+        parts[p] = tmpfile();
+        if (!parts[p])
+        {
+            fprintf(stderr, "ERROR: Cannot create dedup spill file\n");
+            goto cleanup;
+        }
+    }
+
+    // Pass 1: spill (key, ordinal) to partitions by key hash, in file order
+    batch = (uint8_t*)mem_malloc((size_t)1024 * RECORD_SIZE);
+    if (!batch || fseek(fin, data_offset, SEEK_SET) != 0)
+    {
+        goto cleanup;
+    }
+    uint32_t ordinal = 0;
+    while (ordinal < count)
+    {
+        uint32_t want = count - ordinal < 1024 ? count - ordinal : 1024;
+        uint32_t got = (uint32_t)(fread(batch, 1, (size_t)want * RECORD_SIZE, fin) / RECORD_SIZE);
+        for (uint32_t i = 0; i < got; i++)
+        {
+            uint8_t entry[SPILL_ENTRY_SIZE];
+            uint64_t key = record_key_packed(batch + (size_t)i * RECORD_SIZE);
+            unsigned p = (unsigned)((mix64(key) >> 40) % partitions);
+            store_u32_le(entry, (uint32_t)(key & 0xFFFFFFFFu));
+            store_u32_le(entry + 4, (uint32_t)(key >> 32));
+            store_u32_le(entry + 8, ordinal + i);
+            if (fwrite(entry, 1, SPILL_ENTRY_SIZE, parts[p]) != SPILL_ENTRY_SIZE)
+            {
+                fprintf(stderr, "ERROR: Failed to write dedup spill file\n");
+                goto cleanup;
+            }
+            part_sizes[p]++;
+        }
+        ordinal += got;
+        if (got < want)
+        {
+            break;
+        }
+    }
+
+    // Pass 2: dedup each partition in memory, first occurrence wins
+    for (unsigned p = 0; p < partitions; p++)
+    {
+        dedup_set_t set;
+        if (!dedup_set_init(&set, part_sizes[p]))
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            goto cleanup;
+        }
+        rewind(parts[p]);
+        uint8_t entry[SPILL_ENTRY_SIZE];
+        for (uint32_t i = 0; i < part_sizes[p]; i++)
+        {
+            if (fread(entry, 1, SPILL_ENTRY_SIZE, parts[p]) != SPILL_ENTRY_SIZE)
+            {
+                dedup_set_free(&set);
+                goto cleanup;
+            }
+            uint64_t key = load_u32_le(entry) | ((uint64_t)load_u32_le(entry + 4) << 32);
+            uint32_t ord = load_u32_le(entry + 8);
+            int r = dedup_set_insert(&set, key);
+            if (r < 0)
+            {
+                dedup_set_free(&set);
+                goto cleanup;
+            }
+            if (r == 0)
+            {
+                dup_bitmap[ord >> 3] |= (uint8_t)(1u << (ord & 7));
+                (*dups)++;
+            }
+        }
+        dedup_set_free(&set);
+        fclose(parts[p]);
+        parts[p] = NULL;
+    }
+    ok = 1;
+
+cleanup:
+    for (unsigned p = 0; p < partitions; p++)
+    {
+        if (parts[p])
+        {
+            fclose(parts[p]);
+        }
+    }
+    mem_free(batch);
+    if (saved_pos >= 0)
+    {
+        fseek(fin, saved_pos, SEEK_SET);
+    }
+    return ok;
+}
\ No newline at end of file
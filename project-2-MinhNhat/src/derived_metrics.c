@@ -0,0 +1,463 @@
+/**
+ * @file derived_metrics.c
+ * @brief Dew point, heat index and wind components computed per batch
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "derived_metrics.h"
+#include "cpu_dispatch.h"
+#include <math.h>
+#include <string.h>
+
+#if SIMD_X86
+  #include <immintrin.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+#define DEG_TO_RAD (3.14159265358979323846 / 180.0)
+
+#define MAGNUS_B 17.62f
+#define MAGNUS_C 243.12f
+
+// 2*atanh(f) series for ln(m), m in [sqrt(0.5), sqrt(2)]
+#define LOG_C1 0.33333333f
+#define LOG_C2 0.2f
+#define LOG_C3 0.14285714f
+#define LOG_LN2 0.69314718f
+#define LOG_SQRT2 1.41421356f
+
+// NWS Rothfusz regression, degF and percent
+#define HI_C0 -42.379f
+#define HI_C1 2.04901523f
+#define HI_C2 10.14333127f
+#define HI_C3 -0.22475541f
+#define HI_C4 -0.00683783f
+#define HI_C5 -0.05481717f
+#define HI_C6 0.00122874f
+#define HI_C7 0.00085282f
+#define HI_C8 -0.00000199f
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/*
+ * One chunk of records split into per-field lanes. dir holds the
+ * direction already reduced to a table index (0..359).
+ */
+typedef struct {
+    float t[DERIVED_CHUNK_RECORDS];
+    float rh[DERIVED_CHUNK_RECORDS];
+    float ws[DERIVED_CHUNK_RECORDS];
+    int32_t dir[DERIVED_CHUNK_RECORDS];
+    float dew[DERIVED_CHUNK_RECORDS];
+    float hi[DERIVED_CHUNK_RECORDS];
+    float u[DERIVED_CHUNK_RECORDS];
+    float v[DERIVED_CHUNK_RECORDS];
+} derive_lanes_t __attribute__((aligned(64)));
+
+/*********************
+ *      TYPEDEFS
+ *********************/
+typedef void (*derive_kernel_fn)(derive_lanes_t *l, size_t n);
+
+/*********************
+ *  STATIC VARIABLES
+ *********************/
+
+// -sin/-cos per whole degree, so u = ws * neg_sin[dir] and v = ws * neg_cos[dir]
+static float wind_neg_sin[360];
+static float wind_neg_cos[360];
+static int wind_tables_ready = 0;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+
+/*
+ * Filled on first use. Concurrent callers compute the same values, so
+ * a second writer racing the first is harmless.
+ */
+static void init_wind_tables(void)
+{
+    if (__atomic_load_n(&wind_tables_ready, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+    for (int d = 0; d < 360; d++)
+    {
+        double rad = d * DEG_TO_RAD;
+        // + 0.0f turns -0 into +0 for the axis-aligned directions
+        wind_neg_sin[d] = (float)-sin(rad) + 0.0f;
+        wind_neg_cos[d] = (float)-cos(rad) + 0.0f;
+    }
+    __atomic_store_n(&wind_tables_ready, 1, __ATOMIC_RELEASE);
+}
+
+/*********************
+ *  DERIVE KERNELS
+ *********************/
+
+/*
+ * Natural log for positive normal floats. The vector kernels repeat
+ * these exact steps lane-wise.
+ */
+static float log_approx(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float e = (float)((int32_t)(bits >> 23) - 127);
+    bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > LOG_SQRT2)
+    {
+        m = m * 0.5f;
+        e = e + 1.0f;
+    }
+    float f = (m - 1.0f) / (m + 1.0f);
+    float f2 = f * f;
+    float p = f2 * LOG_C3 + LOG_C2;
+    p = p * f2 + LOG_C1;
+    p = p * f2 + 1.0f;
+    return (f + f) * p + e * LOG_LN2;
+}
+
+static void derive_scalar_range(derive_lanes_t *l, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        float t = l->t[i];
+        float rh = l->rh[i];
+
+        float g = log_approx(rh * 0.01f) + (MAGNUS_B * t) / (MAGNUS_C + t);
+        float dew = (MAGNUS_C * g) / (MAGNUS_B - g);
+        l->dew[i] = rh > 0.0f ? dew : NAN;
+
+        float tf = t * 1.8f + 32.0f;
+        float simple = 0.5f * (tf + 61.0f + (tf - 68.0f) * 1.2f + rh * 0.094f);
+        float tt = tf * tf;
+        float rr = rh * rh;
+        float full = HI_C0 + HI_C1 * tf + HI_C2 * rh + HI_C3 * (tf * rh) +
+                     HI_C4 * tt + HI_C5 * rr + HI_C6 * (tt * rh) +
+                     HI_C7 * (tf * rr) + HI_C8 * (tt * rr);
+        if (rh < 13.0f && tf > 80.0f && tf < 112.0f)
+        {
+            full = full - ((13.0f - rh) * 0.25f) * sqrtf((17.0f - fabsf(tf - 95.0f)) * (1.0f / 17.0f));
+        }
+        if (rh > 85.0f && tf > 80.0f && tf < 87.0f)
+        {
+            full = full + ((rh - 85.0f) * 0.1f) * ((87.0f - tf) * 0.2f);
+        }
+        float hi = (simple + tf) * 0.5f >= 80.0f ? full : simple;
+        l->hi[i] = (hi - 32.0f) * (5.0f / 9.0f);
+
+        l->u[i] = l->ws[i] * wind_neg_sin[l->dir[i]];
+        l->v[i] = l->ws[i] * wind_neg_cos[l->dir[i]];
+    }
+}
+
+static void derive_scalar(derive_lanes_t *l, size_t n)
+{
+    derive_scalar_range(l, 0, n);
+}
+
+#if SIMD_X86
+/*
+ * Each vector kernel mirrors derive_scalar_range operation for operation
+ * (no FMA, same association), with branches turned into blends. Lanes
+ * that end up discarded by a blend may compute garbage (log of 0, sqrt of
+ * a negative), which is fine.
+ */
+__attribute__((target("sse4.2")))
+static __m128 log_approx_sse42(__m128 x)
+{
+    __m128i bits = _mm_castps_si128(x);
+    __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    bits = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000));
+    __m128 m = _mm_castsi128_ps(bits);
+    __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(LOG_SQRT2));
+    m = _mm_blendv_ps(m, _mm_mul_ps(m, _mm_set1_ps(0.5f)), big);
+    e = _mm_blendv_ps(e, _mm_add_ps(e, _mm_set1_ps(1.0f)), big);
+    __m128 f = _mm_div_ps(_mm_sub_ps(m, _mm_set1_ps(1.0f)), _mm_add_ps(m, _mm_set1_ps(1.0f)));
+    __m128 f2 = _mm_mul_ps(f, f);
+    __m128 p = _mm_add_ps(_mm_mul_ps(f2, _mm_set1_ps(LOG_C3)), _mm_set1_ps(LOG_C2));
+    p = _mm_add_ps(_mm_mul_ps(p, f2), _mm_set1_ps(LOG_C1));
+    p = _mm_add_ps(_mm_mul_ps(p, f2), _mm_set1_ps(1.0f));
+    return _mm_add_ps(_mm_mul_ps(_mm_add_ps(f, f), p), _mm_mul_ps(e, _mm_set1_ps(LOG_LN2)));
+}
+
+__attribute__((target("sse4.2")))
+static void derive_sse42(derive_lanes_t *l, size_t n)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 t = _mm_load_ps(l->t + i);
+        __m128 rh = _mm_load_ps(l->rh + i);
+
+        __m128 g = _mm_add_ps(log_approx_sse42(_mm_mul_ps(rh, _mm_set1_ps(0.01f))),
+                              _mm_div_ps(_mm_mul_ps(_mm_set1_ps(MAGNUS_B), t),
+                                         _mm_add_ps(_mm_set1_ps(MAGNUS_C), t)));
+        __m128 dew = _mm_div_ps(_mm_mul_ps(_mm_set1_ps(MAGNUS_C), g), _mm_sub_ps(_mm_set1_ps(MAGNUS_B), g));
+        dew = _mm_blendv_ps(_mm_set1_ps(NAN), dew, _mm_cmpgt_ps(rh, _mm_setzero_ps()));
+        _mm_store_ps(l->dew + i, dew);
+
+        __m128 tf = _mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(1.8f)), _mm_set1_ps(32.0f));
+        __m128 simple = _mm_add_ps(_mm_add_ps(_mm_add_ps(tf, _mm_set1_ps(61.0f)),
+                                              _mm_mul_ps(_mm_sub_ps(tf, _mm_set1_ps(68.0f)), _mm_set1_ps(1.2f))),
+                                   _mm_mul_ps(rh, _mm_set1_ps(0.094f)));
+        simple = _mm_mul_ps(_mm_set1_ps(0.5f), simple);
+        __m128 tt = _mm_mul_ps(tf, tf);
+        __m128 rr = _mm_mul_ps(rh, rh);
+        __m128 full = _mm_add_ps(_mm_set1_ps(HI_C0), _mm_mul_ps(_mm_set1_ps(HI_C1), tf));
+        full = _mm_add_ps(full, _mm_mul_ps(_mm_set1_ps(HI_C2), rh));
+        full = _mm_add_ps(full, _mm_mul_ps(_mm_set1_ps(HI_C3), _mm_mul_ps(tf, rh)));
+        full = _mm_add_ps(full, _mm_mul_ps(_mm_set1_ps(HI_C4), tt));
+        full = _mm_add_ps(full, _mm_mul_ps(_mm_set1_ps(HI_C5), rr));
+        full = _mm_add_ps(full, _mm_mul_ps(_mm_set1_ps(HI_C6), _mm_mul_ps(tt, rh)));
+        full = _mm_add_ps(full, _mm_mul_ps(_mm_set1_ps(HI_C7), _mm_mul_ps(tf, rr)));
+        full = _mm_add_ps(full, _mm_mul_ps(_mm_set1_ps(HI_C8), _mm_mul_ps(tt, rr)));
+
+        __m128 hot = _mm_and_ps(_mm_cmpgt_ps(tf, _mm_set1_ps(80.0f)), _mm_cmplt_ps(tf, _mm_set1_ps(112.0f)));
+        __m128 dry = _mm_and_ps(hot, _mm_cmplt_ps(rh, _mm_set1_ps(13.0f)));
+        __m128 dist = _mm_andnot_ps(sign, _mm_sub_ps(tf, _mm_set1_ps(95.0f)));
+        __m128 adj = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(13.0f), rh), _mm_set1_ps(0.25f)),
+                                _mm_sqrt_ps(_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(17.0f), dist),
+                                                       _mm_set1_ps(1.0f / 17.0f))));
+        full = _mm_blendv_ps(full, _mm_sub_ps(full, adj), dry);
+        __m128 humid = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(tf, _mm_set1_ps(80.0f)), _mm_cmplt_ps(tf, _mm_set1_ps(87.0f))),
+                                  _mm_cmpgt_ps(rh, _mm_set1_ps(85.0f)));
+        adj = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(rh, _mm_set1_ps(85.0f)), _mm_set1_ps(0.1f)),
+                         _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(87.0f), tf), _mm_set1_ps(0.2f)));
+        full = _mm_blendv_ps(full, _mm_add_ps(full, adj), humid);
+
+        __m128 use_full = _mm_cmpge_ps(_mm_mul_ps(_mm_add_ps(simple, tf), _mm_set1_ps(0.5f)), _mm_set1_ps(80.0f));
+        __m128 hi = _mm_blendv_ps(simple, full, use_full);
+        _mm_store_ps(l->hi + i, _mm_mul_ps(_mm_sub_ps(hi, _mm_set1_ps(32.0f)), _mm_set1_ps(5.0f / 9.0f)));
+
+        __m128 ws = _mm_load_ps(l->ws + i);
+        const int32_t *d = l->dir + i;
+        __m128 s = _mm_setr_ps(wind_neg_sin[d[0]], wind_neg_sin[d[1]], wind_neg_sin[d[2]], wind_neg_sin[d[3]]);
+        __m128 c = _mm_setr_ps(wind_neg_cos[d[0]], wind_neg_cos[d[1]], wind_neg_cos[d[2]], wind_neg_cos[d[3]]);
+        _mm_store_ps(l->u + i, _mm_mul_ps(ws, s));
+        _mm_store_ps(l->v + i, _mm_mul_ps(ws, c));
+    }
+    derive_scalar_range(l, i, n);
+}
+
+__attribute__((target("avx2")))
+static __m256 log_approx_avx2(__m256 x)
+{
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    bits = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000));
+    __m256 m = _mm256_castsi256_ps(bits);
+    __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(LOG_SQRT2), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+    e = _mm256_blendv_ps(e, _mm256_add_ps(e, _mm256_set1_ps(1.0f)), big);
+    __m256 f = _mm256_div_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)), _mm256_add_ps(m, _mm256_set1_ps(1.0f)));
+    __m256 f2 = _mm256_mul_ps(f, f);
+    __m256 p = _mm256_add_ps(_mm256_mul_ps(f2, _mm256_set1_ps(LOG_C3)), _mm256_set1_ps(LOG_C2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, f2), _mm256_set1_ps(LOG_C1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, f2), _mm256_set1_ps(1.0f));
+    return _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(f, f), p), _mm256_mul_ps(e, _mm256_set1_ps(LOG_LN2)));
+}
+
+__attribute__((target("avx2")))
+static void derive_avx2(derive_lanes_t *l, size_t n)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 t = _mm256_load_ps(l->t + i);
+        __m256 rh = _mm256_load_ps(l->rh + i);
+
+        __m256 g = _mm256_add_ps(log_approx_avx2(_mm256_mul_ps(rh, _mm256_set1_ps(0.01f))),
+                                 _mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(MAGNUS_B), t),
+                                               _mm256_add_ps(_mm256_set1_ps(MAGNUS_C), t)));
+        __m256 dew = _mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(MAGNUS_C), g),
+                                   _mm256_sub_ps(_mm256_set1_ps(MAGNUS_B), g));
+        dew = _mm256_blendv_ps(_mm256_set1_ps(NAN), dew, _mm256_cmp_ps(rh, _mm256_setzero_ps(), _CMP_GT_OQ));
+        _mm256_store_ps(l->dew + i, dew);
+
+        __m256 tf = _mm256_add_ps(_mm256_mul_ps(t, _mm256_set1_ps(1.8f)), _mm256_set1_ps(32.0f));
+        __m256 simple = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(tf, _mm256_set1_ps(61.0f)),
+                                                    _mm256_mul_ps(_mm256_sub_ps(tf, _mm256_set1_ps(68.0f)),
+                                                                  _mm256_set1_ps(1.2f))),
+                                      _mm256_mul_ps(rh, _mm256_set1_ps(0.094f)));
+        simple = _mm256_mul_ps(_mm256_set1_ps(0.5f), simple);
+        __m256 tt = _mm256_mul_ps(tf, tf);
+        __m256 rr = _mm256_mul_ps(rh, rh);
+        __m256 full = _mm256_add_ps(_mm256_set1_ps(HI_C0), _mm256_mul_ps(_mm256_set1_ps(HI_C1), tf));
+        full = _mm256_add_ps(full, _mm256_mul_ps(_mm256_set1_ps(HI_C2), rh));
+        full = _mm256_add_ps(full, _mm256_mul_ps(_mm256_set1_ps(HI_C3), _mm256_mul_ps(tf, rh)));
+        full = _mm256_add_ps(full, _mm256_mul_ps(_mm256_set1_ps(HI_C4), tt));
+        full = _mm256_add_ps(full, _mm256_mul_ps(_mm256_set1_ps(HI_C5), rr));
+        full = _mm256_add_ps(full, _mm256_mul_ps(_mm256_set1_ps(HI_C6), _mm256_mul_ps(tt, rh)));
+        full = _mm256_add_ps(full, _mm256_mul_ps(_mm256_set1_ps(HI_C7), _mm256_mul_ps(tf, rr)));
+        full = _mm256_add_ps(full, _mm256_mul_ps(_mm256_set1_ps(HI_C8), _mm256_mul_ps(tt, rr)));
+
+        __m256 warm = _mm256_cmp_ps(tf, _mm256_set1_ps(80.0f), _CMP_GT_OQ);
+        __m256 dry = _mm256_and_ps(_mm256_and_ps(warm, _mm256_cmp_ps(tf, _mm256_set1_ps(112.0f), _CMP_LT_OQ)),
+                                   _mm256_cmp_ps(rh, _mm256_set1_ps(13.0f), _CMP_LT_OQ));
+        __m256 dist = _mm256_andnot_ps(sign, _mm256_sub_ps(tf, _mm256_set1_ps(95.0f)));
+        __m256 adj = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(13.0f), rh), _mm256_set1_ps(0.25f)),
+                                   _mm256_sqrt_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(17.0f), dist),
+                                                                _mm256_set1_ps(1.0f / 17.0f))));
+        full = _mm256_blendv_ps(full, _mm256_sub_ps(full, adj), dry);
+        __m256 humid = _mm256_and_ps(_mm256_and_ps(warm, _mm256_cmp_ps(tf, _mm256_set1_ps(87.0f), _CMP_LT_OQ)),
+                                     _mm256_cmp_ps(rh, _mm256_set1_ps(85.0f), _CMP_GT_OQ));
+        adj = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(rh, _mm256_set1_ps(85.0f)), _mm256_set1_ps(0.1f)),
+                            _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(87.0f), tf), _mm256_set1_ps(0.2f)));
+        full = _mm256_blendv_ps(full, _mm256_add_ps(full, adj), humid);
+
+        __m256 use_full = _mm256_cmp_ps(_mm256_mul_ps(_mm256_add_ps(simple, tf), _mm256_set1_ps(0.5f)),
+                                        _mm256_set1_ps(80.0f), _CMP_GE_OQ);
+        __m256 hi = _mm256_blendv_ps(simple, full, use_full);
+        _mm256_store_ps(l->hi + i, _mm256_mul_ps(_mm256_sub_ps(hi, _mm256_set1_ps(32.0f)), _mm256_set1_ps(5.0f / 9.0f)));
+
+        __m256 ws = _mm256_load_ps(l->ws + i);
+        __m256i d = _mm256_load_si256((const __m256i*)(l->dir + i));
+        _mm256_store_ps(l->u + i, _mm256_mul_ps(ws, _mm256_i32gather_ps(wind_neg_sin, d, 4)));
+        _mm256_store_ps(l->v + i, _mm256_mul_ps(ws, _mm256_i32gather_ps(wind_neg_cos, d, 4)));
+    }
+    derive_scalar_range(l, i, n);
+}
+
+__attribute__((target("avx512f")))
+static __m512 log_approx_avx512(__m512 x)
+{
+    __m512i bits = _mm512_castps_si512(x);
+    __m512 e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(127)));
+    bits = _mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007FFFFF)), _mm512_set1_epi32(0x3F800000));
+    __m512 m = _mm512_castsi512_ps(bits);
+    __mmask16 big = _mm512_cmp_ps_mask(m, _mm512_set1_ps(LOG_SQRT2), _CMP_GT_OQ);
+    m = _mm512_mask_mul_ps(m, big, m, _mm512_set1_ps(0.5f));
+    e = _mm512_mask_add_ps(e, big, e, _mm512_set1_ps(1.0f));
+    __m512 f = _mm512_div_ps(_mm512_sub_ps(m, _mm512_set1_ps(1.0f)), _mm512_add_ps(m, _mm512_set1_ps(1.0f)));
+    __m512 f2 = _mm512_mul_ps(f, f);
+    __m512 p = _mm512_add_ps(_mm512_mul_ps(f2, _mm512_set1_ps(LOG_C3)), _mm512_set1_ps(LOG_C2));
+    p = _mm512_add_ps(_mm512_mul_ps(p, f2), _mm512_set1_ps(LOG_C1));
+    p = _mm512_add_ps(_mm512_mul_ps(p, f2), _mm512_set1_ps(1.0f));
+    return _mm512_add_ps(_mm512_mul_ps(_mm512_add_ps(f, f), p), _mm512_mul_ps(e, _mm512_set1_ps(LOG_LN2)));
+}
+
+__attribute__((target("avx512f")))
+static void derive_avx512(derive_lanes_t *l, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512 t = _mm512_load_ps(l->t + i);
+        __m512 rh = _mm512_load_ps(l->rh + i);
+
+        __m512 g = _mm512_add_ps(log_approx_avx512(_mm512_mul_ps(rh, _mm512_set1_ps(0.01f))),
+                                 _mm512_div_ps(_mm512_mul_ps(_mm512_set1_ps(MAGNUS_B), t),
+                                               _mm512_add_ps(_mm512_set1_ps(MAGNUS_C), t)));
+        __m512 dew = _mm512_div_ps(_mm512_mul_ps(_mm512_set1_ps(MAGNUS_C), g),
+                                   _mm512_sub_ps(_mm512_set1_ps(MAGNUS_B), g));
+        __mmask16 valid = _mm512_cmp_ps_mask(rh, _mm512_setzero_ps(), _CMP_GT_OQ);
+        _mm512_store_ps(l->dew + i, _mm512_mask_blend_ps(valid, _mm512_set1_ps(NAN), dew));
+
+        __m512 tf = _mm512_add_ps(_mm512_mul_ps(t, _mm512_set1_ps(1.8f)), _mm512_set1_ps(32.0f));
+        __m512 simple = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(tf, _mm512_set1_ps(61.0f)),
+                                                    _mm512_mul_ps(_mm512_sub_ps(tf, _mm512_set1_ps(68.0f)),
+                                                                  _mm512_set1_ps(1.2f))),
+                                      _mm512_mul_ps(rh, _mm512_set1_ps(0.094f)));
+        simple = _mm512_mul_ps(_mm512_set1_ps(0.5f), simple);
+        __m512 tt = _mm512_mul_ps(tf, tf);
+        __m512 rr = _mm512_mul_ps(rh, rh);
+        __m512 full = _mm512_add_ps(_mm512_set1_ps(HI_C0), _mm512_mul_ps(_mm512_set1_ps(HI_C1), tf));
+        full = _mm512_add_ps(full, _mm512_mul_ps(_mm512_set1_ps(HI_C2), rh));
+        full = _mm512_add_ps(full, _mm512_mul_ps(_mm512_set1_ps(HI_C3), _mm512_mul_ps(tf, rh)));
+        full = _mm512_add_ps(full, _mm512_mul_ps(_mm512_set1_ps(HI_C4), tt));
+        full = _mm512_add_ps(full, _mm512_mul_ps(_mm512_set1_ps(HI_C5), rr));
+        full = _mm512_add_ps(full, _mm512_mul_ps(_mm512_set1_ps(HI_C6), _mm512_mul_ps(tt, rh)));
+        full = _mm512_add_ps(full, _mm512_mul_ps(_mm512_set1_ps(HI_C7), _mm512_mul_ps(tf, rr)));
+        full = _mm512_add_ps(full, _mm512_mul_ps(_mm512_set1_ps(HI_C8), _mm512_mul_ps(tt, rr)));
+
+        __mmask16 warm = _mm512_cmp_ps_mask(tf, _mm512_set1_ps(80.0f), _CMP_GT_OQ);
+        __mmask16 dry = warm & _mm512_cmp_ps_mask(tf, _mm512_set1_ps(112.0f), _CMP_LT_OQ)
+                             & _mm512_cmp_ps_mask(rh, _mm512_set1_ps(13.0f), _CMP_LT_OQ);
+        __m512 dist = _mm512_abs_ps(_mm512_sub_ps(tf, _mm512_set1_ps(95.0f)));
+        __m512 adj = _mm512_mul_ps(_mm512_mul_ps(_mm512_sub_ps(_mm512_set1_ps(13.0f), rh), _mm512_set1_ps(0.25f)),
+                                   _mm512_sqrt_ps(_mm512_mul_ps(_mm512_sub_ps(_mm512_set1_ps(17.0f), dist),
+                                                                _mm512_set1_ps(1.0f / 17.0f))));
+        full = _mm512_mask_sub_ps(full, dry, full, adj);
+        __mmask16 humid = warm & _mm512_cmp_ps_mask(tf, _mm512_set1_ps(87.0f), _CMP_LT_OQ)
+                               & _mm512_cmp_ps_mask(rh, _mm512_set1_ps(85.0f), _CMP_GT_OQ);
+        adj = _mm512_mul_ps(_mm512_mul_ps(_mm512_sub_ps(rh, _mm512_set1_ps(85.0f)), _mm512_set1_ps(0.1f)),
+                            _mm512_mul_ps(_mm512_sub_ps(_mm512_set1_ps(87.0f), tf), _mm512_set1_ps(0.2f)));
+        full = _mm512_mask_add_ps(full, humid, full, adj);
+
+        __mmask16 use_full = _mm512_cmp_ps_mask(_mm512_mul_ps(_mm512_add_ps(simple, tf), _mm512_set1_ps(0.5f)),
+                                                _mm512_set1_ps(80.0f), _CMP_GE_OQ);
+        __m512 hi = _mm512_mask_blend_ps(use_full, simple, full);
+        _mm512_store_ps(l->hi + i, _mm512_mul_ps(_mm512_sub_ps(hi, _mm512_set1_ps(32.0f)), _mm512_set1_ps(5.0f / 9.0f)));
+
+        __m512 ws = _mm512_load_ps(l->ws + i);
+        __m512i d = _mm512_load_si512((const void*)(l->dir + i));
+        _mm512_store_ps(l->u + i, _mm512_mul_ps(ws, _mm512_i32gather_ps(d, wind_neg_sin, 4)));
+        _mm512_store_ps(l->v + i, _mm512_mul_ps(ws, _mm512_i32gather_ps(d, wind_neg_cos, 4)));
+    }
+    derive_scalar_range(l, i, n);
+}
+#endif
+
+/*********************
+ *  DISPATCH TABLES
+ *********************/
+#if SIMD_X86
+static const derive_kernel_fn derive_impl[SIMD_LEVEL_COUNT] = {
+    derive_scalar, derive_sse42, derive_avx2, derive_avx512
+};
+#else
+static const derive_kernel_fn derive_impl[SIMD_LEVEL_COUNT] = {
+    derive_scalar, derive_scalar, derive_scalar, derive_scalar
+};
+#endif
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+void derive_weather_batch(derived_metrics_t *out, const weather_record_t *records, size_t n)
+{
+    derive_lanes_t lanes;
+    derive_kernel_fn kernel = derive_impl[simd_level()];
+    init_wind_tables();
+
+    for (size_t base = 0; base < n; base += DERIVED_CHUNK_RECORDS)
+    {
+        size_t m = n - base;
+        if (m > DERIVED_CHUNK_RECORDS)
+        {
+            m = DERIVED_CHUNK_RECORDS;
+        }
+        const weather_record_t *r = records + base;
+        for (size_t i = 0; i < m; i++)
+        {
+            lanes.t[i] = r[i].temperature;
+            lanes.rh[i] = r[i].humidity;
+            lanes.ws[i] = r[i].wind_speed;
+            lanes.dir[i] = (int32_t)(r[i].wind_dir % 360);
+        }
+
+        kernel(&lanes, m);
+
+        derived_metrics_t *o = out + base;
+        for (size_t i = 0; i < m; i++)
+        {
+            o[i].dew_point = lanes.dew[i];
+            o[i].heat_index = lanes.hi[i];
+            o[i].wind_u = lanes.u[i];
+            o[i].wind_v = lanes.v[i];
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,760 @@
+/**
+ * @file json_reader.c
+ * @brief Streaming weather JSON reader implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "json_reader.h"
+#include "bin_writer.h"
+#include "mem_track.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TOKEN_MAX 128
+#define NESTING_MAX 64
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    KEY_UNKNOWN = 0,
+    KEY_METADATA,
+    KEY_FILE_ID,
+    KEY_VERSION,
+    KEY_RECORD_COUNT,
+    KEY_RECORDS,
+    KEY_SENSOR_ID,
+    KEY_BATTERY,
+    KEY_TIMESTAMP,
+    KEY_LOCATION,
+    KEY_LAT,
+    KEY_LON,
+    KEY_MEASUREMENTS,
+    KEY_TEMPERATURE,
+    KEY_HUMIDITY,
+    KEY_PRESSURE,
+    KEY_CO2,
+    KEY_WIND,
+    KEY_SPEED,
+    KEY_DIRECTION,
+    KEY_RAIN,
+    KEY_UV,
+    KEY_LIGHT,
+    KEY_COUNT
+} json_key_t;
+
+/*********************
+ *  STATIC VARIABLES
+ *********************/
+static const char *key_names[KEY_COUNT] = {
+    "", "metadata", "file_id", "version", "record_count", "records",
+    "sensor_id", "battery", "timestamp", "location", "lat", "lon",
+    "measurements", "temperature", "humidity", "pressure", "co2",
+    "wind", "speed", "direction", "rain", "uv", "light"
+};
+
+// FNV-1a hashes of key_names, computed once on first open
+static uint32_t key_hashes[KEY_COUNT];
+static pthread_once_t key_hashes_once = PTHREAD_ONCE_INIT;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static uint32_t fnv1a(const char *s, size_t n)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++)
+    {
+        h = (h ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void init_key_hashes(void)
+{
+    for (int k = 1; k < KEY_COUNT; k++)
+    {
+        key_hashes[k] = fnv1a(key_names[k], strlen(key_names[k]));
+    }
+}
+
+static json_key_t lookup_key(const char *s, size_t n, uint32_t hash)
+{
+    for (int k = 1; k < KEY_COUNT; k++)
+    {
+        if (key_hashes[k] == hash && strlen(key_names[k]) == n && memcmp(key_names[k], s, n) == 0)
+        {
+            return (json_key_t)k;
+        }
+    }
+    return KEY_UNKNOWN;
+}
+
+static int fail(json_reader_t *r, const char *what)
+{
+    if (!r->error)
+    {
+        r->error = 1;
+        snprintf(r->error_msg, sizeof(r->error_msg), "%s near line %llu",
+                 what, (unsigned long long)r->line);
+    }
+    return 0;
+}
+
+static int fill(json_reader_t *r)
+{
+    if (r->eof)
+    {
+        return 0;
+    }
+    r->len = fread(r->buf, 1, JSON_READ_BUFFER_SIZE, r->f);
+    r->pos = 0;
+    if (r->len == 0)
+    {
+        r->eof = 1;
+        return 0;
+    }
+    return 1;
+}
+
+// Next byte without consuming it, -1 at end of input
+static int peek(json_reader_t *r)
+{
+    if (r->pos >= r->len && !fill(r))
+    {
+        return -1;
+    }
+    return (unsigned char)r->buf[r->pos];
+}
+
+static int next(json_reader_t *r)
+{
+    int c = peek(r);
+    if (c >= 0)
+    {
+        r->pos++;
+        r->bytes_consumed++;
+        if (c == '\n')
+        {
+            r->line++;
+        }
+    }
+    return c;
+}
+
+static int peek_nonws(json_reader_t *r)
+{
+    for (;;)
+    {
+        int c = peek(r);
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+        {
+            return c;
+        }
+        next(r);
+    }
+}
+
+static int expect(json_reader_t *r, int ch)
+{
+    if (peek_nonws(r) != ch)
+    {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "expected '%c'", ch);
+        return fail(r, msg);
+    }
+    next(r);
+    return 1;
+}
+
+// Reads a string (opening quote next) into out, truncating to out_size - 1
+static int read_string(json_reader_t *r, char *out, size_t out_size, size_t *out_len, uint32_t *hash)
+{
+    if (!expect(r, '"'))
+    {
+        return 0;
+    }
+    size_t n = 0;
+    uint32_t h = 2166136261u;
+    for (;;)
+    {
+        int c = next(r);
+        if (c < 0)
+        {
+            return fail(r, "unterminated string");
+        }
+        if (c == '"')
+        {
+            break;
+        }
+        if (c == '\\')
+        {
+            c = next(r);
+            switch (c)
+            {
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u':
+                {
+                    unsigned v = 0;
+                    for (int i = 0; i < 4; i++)
+                    {
+                        int d = next(r);
+                        v <<= 4;
+                        if (d >= '0' && d <= '9') v |= (unsigned)(d - '0');
+                        else if (d >= 'a' && d <= 'f') v |= (unsigned)(d - 'a' + 10);
+                        else if (d >= 'A' && d <= 'F') v |= (unsigned)(d - 'A' + 10);
+                        else return fail(r, "bad \\u escape");
+                    }
+                    c = v < 0x80 ? (int)v : '?';
+                    break;
+                }
+                case -1: return fail(r, "unterminated string");
+                default: break; // \" \\ \/
+            }
+        }
+        h = (h ^ (uint8_t)c) * 16777619u;
+        if (n + 1 < out_size)
+        {
+            out[n++] = (char)c;
+        }
+    }
+    out[n] = '\0';
+    if (out_len)
+    {
+        *out_len = n;
+    }
+    if (hash)
+    {
+        *hash = h;
+    }
+    return 1;
+}
+
+// Reads a bare token (number, true/false/null, nan/inf from printf)
+static int read_token(json_reader_t *r, char *out, size_t out_size)
+{
+    size_t n = 0;
+    peek_nonws(r);
+    for (;;)
+    {
+        int c = peek(r);
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+              c == '-' || c == '+' || c == '.'))
+        {
+            break;
+        }
+        if (n + 1 < out_size)
+        {
+            out[n++] = (char)c;
+        }
+        next(r);
+    }
+    out[n] = '\0';
+    return n > 0 ? 1 : fail(r, "expected value");
+}
+
+static int read_number(json_reader_t *r, double *out)
+{
+    char tok[TOKEN_MAX];
+    if (!read_token(r, tok, sizeof(tok)))
+    {
+        return 0;
+    }
+    char *end = NULL;
+    *out = strtod(tok, &end);
+    if (end == tok || *end != '\0')
+    {
+        return fail(r, "expected number");
+    }
+    return 1;
+}
+
+// Skips any value, iteratively so deep nesting cannot overflow the stack
+static int skip_value(json_reader_t *r)
+{
+    int depth = 0;
+    char tok[TOKEN_MAX];
+    do
+    {
+        int c = peek_nonws(r);
+        if (c == '{' || c == '[')
+        {
+            next(r);
+            depth++;
+        }
+        else if (c == '}' || c == ']')
+        {
+            next(r);
+            depth--;
+        }
+        else if (c == ',' || c == ':')
+        {
+            next(r);
+        }
+        else if (c == '"')
+        {
+            if (!read_string(r, tok, sizeof(tok), NULL, NULL))
+            {
+                return 0;
+            }
+        }
+        else if (c < 0)
+        {
+            return fail(r, "unexpected end of input");
+        }
+        else if (!read_token(r, tok, sizeof(tok)))
+        {
+            return 0;
+        }
+        if (depth > NESTING_MAX)
+        {
+            return fail(r, "nesting too deep");
+        }
+    } while (depth > 0);
+    return 1;
+}
+
+// Reads '"key":' and returns its ID; *done is set at the closing '}'
+static int read_key(json_reader_t *r, int *first, json_key_t *key, int *done)
+{
+    int c = peek_nonws(r);
+    if (c == '}')
+    {
+        next(r);
+        *done = 1;
+        return 1;
+    }
+    if (!*first && !expect(r, ','))
+    {
+        return 0;
+    }
+    *first = 0;
+
+    char name[TOKEN_MAX];
+    size_t len;
+    uint32_t hash;
+    if (!read_string(r, name, sizeof(name), &len, &hash) || !expect(r, ':'))
+    {
+        return 0;
+    }
+    *key = lookup_key(name, len, hash);
+    *done = 0;
+    return 1;
+}
+
+static uint8_t battery_from_string(const char *s)
+{
+    if (strcmp(s, "normal") == 0)    return BATTERY_NORMAL;
+    if (strcmp(s, "low") == 0)       return BATTERY_LOW;
+    if (strcmp(s, "emergency") == 0) return BATTERY_EMERGENCY;
+    return 0xFF;
+}
+
+// Days since 1970-01-01 of a civil date (inverse of civil_from_days)
+static int64_t days_from_civil(int y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+// Parses "YYYY-MM-DDThh:mm:ssZ" as written by --iso-time
+static int parse_iso8601(const char *s, uint32_t *out)
+{
+    int y;
+    unsigned mo, d, h, mi, sec;
+    char z;
+    if (sscanf(s, "%4d-%2u-%2uT%2u:%2u:%2u%c", &y, &mo, &d, &h, &mi, &sec, &z) != 7 || z != 'Z' ||
+        mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || sec > 60)
+    {
+        return 0;
+    }
+    int64_t t = days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + sec;
+    if (t < 0 || t > (int64_t)UINT32_MAX)
+    {
+        return 0;
+    }
+    *out = (uint32_t)t;
+    return 1;
+}
+
+// Reads one object whose keys may be record fields or nested field groups
+static int read_record_object(json_reader_t *r, weather_record_t *rec, int depth)
+{
+    if (!expect(r, '{'))
+    {
+        return 0;
+    }
+    int first = 1;
+    for (;;)
+    {
+        json_key_t key;
+        int done;
+        double v = 0.0;
+        if (!read_key(r, &first, &key, &done))
+        {
+            return 0;
+        }
+        if (done)
+        {
+            return 1;
+        }
+
+        switch (key)
+        {
+            case KEY_LOCATION:
+            case KEY_MEASUREMENTS:
+            case KEY_WIND:
+                if (depth >= 3 || peek_nonws(r) != '{')
+                {
+                    if (!skip_value(r)) return 0;
+                }
+                else if (!read_record_object(r, rec, depth + 1))
+                {
+                    return 0;
+                }
+                break;
+
+            case KEY_BATTERY:
+                if (peek_nonws(r) == '"')
+                {
+                    char s[TOKEN_MAX];
+                    if (!read_string(r, s, sizeof(s), NULL, NULL)) return 0;
+                    rec->battery = battery_from_string(s);
+                }
+                else
+                {
+                    if (!read_number(r, &v)) return 0;
+                    rec->battery = (uint8_t)v;
+                }
+                break;
+
+            case KEY_TIMESTAMP:
+                if (peek_nonws(r) == '"')
+                {
+                    char s[TOKEN_MAX];
+                    if (!read_string(r, s, sizeof(s), NULL, NULL)) return 0;
+                    if (!parse_iso8601(s, &rec->timestamp)) return fail(r, "bad ISO-8601 timestamp");
+                }
+                else
+                {
+                    if (!read_number(r, &v)) return 0;
+                    rec->timestamp = (uint32_t)v;
+                }
+                break;
+
+            case KEY_SENSOR_ID:   if (!read_number(r, &v)) return 0; rec->sensor_id = (uint32_t)v; break;
+            case KEY_LAT:         if (!read_number(r, &v)) return 0; rec->lat = v; break;
+            case KEY_LON:         if (!read_number(r, &v)) return 0; rec->lon = v; break;
+            case KEY_TEMPERATURE: if (!read_number(r, &v)) return 0; rec->temperature = (float)v; break;
+            case KEY_HUMIDITY:    if (!read_number(r, &v)) return 0; rec->humidity = (float)v; break;
+            case KEY_PRESSURE:    if (!read_number(r, &v)) return 0; rec->pressure = (float)v; break;
+            case KEY_CO2:         if (!read_number(r, &v)) return 0; rec->co2 = (uint16_t)v; break;
+            case KEY_SPEED:       if (!read_number(r, &v)) return 0; rec->wind_speed = (float)v; break;
+            case KEY_DIRECTION:   if (!read_number(r, &v)) return 0; rec->wind_dir = (uint16_t)v; break;
+            case KEY_RAIN:        if (!read_number(r, &v)) return 0; rec->rain = (float)v; break;
+            case KEY_UV:          if (!read_number(r, &v)) return 0; rec->uv = (float)v; break;
+            case KEY_LIGHT:       if (!read_number(r, &v)) return 0; rec->light = (float)v; break;
+
+            default:
+                if (!skip_value(r)) return 0;
+                break;
+        }
+    }
+}
+
+static int read_metadata(json_reader_t *r)
+{
+    if (!expect(r, '{'))
+    {
+        return 0;
+    }
+    int first = 1;
+    for (;;)
+    {
+        json_key_t key;
+        int done;
+        if (!read_key(r, &first, &key, &done))
+        {
+            return 0;
+        }
+        if (done)
+        {
+            return 1;
+        }
+
+        double v;
+        if (key == KEY_FILE_ID && peek_nonws(r) == '"')
+        {
+            char s[TOKEN_MAX];
+            if (!read_string(r, s, sizeof(s), NULL, NULL)) return 0;
+            size_t n = strlen(s);
+            if (n > FILE_ID_SIZE) n = FILE_ID_SIZE;
+            memset(r->header.file_id, 0, sizeof(r->header.file_id));
+            memcpy(r->header.file_id, s, n);
+        }
+        else if (key == KEY_VERSION)
+        {
+            if (!read_number(r, &v)) return 0;
+            r->header.version = (uint16_t)v;
+        }
+        else if (key == KEY_RECORD_COUNT)
+        {
+            if (!read_number(r, &v)) return 0;
+            r->header.count = (uint32_t)v;
+        }
+        else if (!skip_value(r))
+        {
+            return 0;
+        }
+    }
+}
+
+// Walks top-level keys until the "records" array is entered
+static int seek_records(json_reader_t *r, int *first)
+{
+    for (;;)
+    {
+        json_key_t key;
+        int done;
+        if (!read_key(r, first, &key, &done))
+        {
+            return 0;
+        }
+        if (done)
+        {
+            return fail(r, "no \"records\" array");
+        }
+        if (key == KEY_METADATA)
+        {
+            if (!read_metadata(r)) return 0;
+        }
+        else if (key == KEY_RECORDS)
+        {
+            if (!expect(r, '['))
+            {
+                return 0;
+            }
+            r->in_records = 1;
+            r->first_record = 1;
+            return 1;
+        }
+        else if (!skip_value(r))
+        {
+            return 0;
+        }
+    }
+}
+
+// After the records array: pick up trailing metadata, then the final '}'
+static int finish_document(json_reader_t *r)
+{
+    int first = 0;
+    for (;;)
+    {
+        json_key_t key;
+        int done;
+        if (!read_key(r, &first, &key, &done))
+        {
+            return 0;
+        }
+        if (done)
+        {
+            return 1;
+        }
+        if (key == KEY_METADATA)
+        {
+            if (!read_metadata(r)) return 0;
+        }
+        else if (!skip_value(r))
+        {
+            return 0;
+        }
+    }
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int json_reader_open(json_reader_t *r, const char *path)
+{
+    memset(r, 0, sizeof(*r));
+    pthread_once(&key_hashes_once, init_key_hashes);
+    r->line = 1;
+    memcpy(r->header.file_id, "WTHR", FILE_ID_SIZE + 1);
+    r->header.version = 1;
+
+    r->f = fopen(path, "rb");
+    if (!r->f)
+    {
+        snprintf(r->error_msg, sizeof(r->error_msg), "cannot open '%s': %s", path, strerror(errno));
+        r->error = 1;
+        return 0;
+    }
+    r->buf = (char*)mem_malloc(JSON_READ_BUFFER_SIZE);
+    if (!r->buf)
+    {
+        return fail(r, "out of memory");
+    }
+
+    int first = 1;
+    return expect(r, '{') && seek_records(r, &first);
+}
+
+int json_reader_next(json_reader_t *r, weather_record_t *record)
+{
+    if (r->error)
+    {
+        return -1;
+    }
+    if (!r->in_records)
+    {
+        return 0;
+    }
+
+    int c = peek_nonws(r);
+    if (c == ']')
+    {
+        next(r);
+        r->in_records = 0;
+        return finish_document(r) ? 0 : -1;
+    }
+    if (!r->first_record && !expect(r, ','))
+    {
+        return -1;
+    }
+    r->first_record = 0;
+
+    memset(record, 0, sizeof(*record));
+    return read_record_object(r, record, 0) ? 1 : -1;
+}
+
+void json_reader_close(json_reader_t *r)
+{
+    if (r->f)
+    {
+        fclose(r->f);
+        r->f = NULL;
+    }
+    mem_free(r->buf);
+    r->buf = NULL;
+}
+
+int convert_json_to_bin(const char *input_file, const char *output_file, conv_stats_t *stats)
+{
+    uint64_t t_start = 0;
+    uint64_t t_mark = 0;
+    if (stats)
+    {
+        memset(stats, 0, sizeof(*stats));
+        t_start = stats_now_ns();
+        t_mark = t_start;
+    }
+
+    printf("Converting: %s -> %s\n", input_file, output_file);
+
+    json_reader_t reader;
+    if (!json_reader_open(&reader, input_file))
+    {
+        fprintf(stderr, "ERROR: %s\n", reader.error_msg);
+        json_reader_close(&reader);
+        return 1;
+    }
+
+    bin_writer_t writer;
+    weather_record_t *records = (weather_record_t*)mem_malloc(WRITE_BATCH_RECORDS * sizeof(weather_record_t));
+    if (!records || !bin_writer_open(&writer, output_file, &reader.header))
+    {
+        if (!records)
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+        }
+        mem_free(records);
+        json_reader_close(&reader);
+        return 1;
+    }
+    if (stats)
+    {
+        conv_stats_end_stage(stats, STAGE_READ, &t_mark);
+    }
+
+    // Parse a batch of records, then encode and write it
+    int rc = 0;
+    int write_failed = 0;
+    for (;;)
+    {
+        uint32_t n = 0;
+        while (n < WRITE_BATCH_RECORDS && (rc = json_reader_next(&reader, &records[n])) == 1)
+        {
+            n++;
+        }
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_DECODE, &t_mark);
+        }
+
+        for (uint32_t i = 0; i < n && !write_failed; i++)
+        {
+            write_failed = !bin_writer_write(&writer, &records[i]);
+        }
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_WRITE, &t_mark);
+        }
+
+        if (rc != 1 || write_failed)
+        {
+            break;
+        }
+    }
+
+    // Metadata may have followed the records array
+    memcpy(writer.header.file_id, reader.header.file_id, sizeof(writer.header.file_id));
+    writer.header.version = reader.header.version;
+    uint32_t written = writer.header.count;
+    int write_ok = bin_writer_close(&writer);
+
+    if (stats)
+    {
+        stats->records = written;
+        stats->bytes_read = reader.bytes_consumed;
+        stats->bytes_written = writer.bytes_written;
+        stats->heap_peak_bytes = mem_peak_bytes();
+        stats->rss_peak_bytes = mem_peak_rss_bytes();
+        stats->total_ns = stats_now_ns() - t_start;
+    }
+
+    mem_free(records);
+    json_reader_close(&reader);
+
+    if (rc < 0)
+    {
+        fprintf(stderr, "ERROR: Invalid JSON: %s\n", reader.error_msg);
+        return 1;
+    }
+    if (!write_ok)
+    {
+        fprintf(stderr, "ERROR: Failed to write '%s'\n", output_file);
+        return 1;
+    }
+    if (reader.header.count != 0 && reader.header.count != written)
+    {
+        printf("WARNING: metadata record_count is %u, wrote %u records\n", reader.header.count, written);
+    }
+    printf("SUCCESS: Converted %u records to binary format\n", written);
+    return 0;
+}
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "weather_types.h"
 #include <stdio.h>
 #include <errno.h>
+#include <math.h>
 #include <string.h>
 
 /*********************
@@ -24,9 +25,88 @@
   #define MKDIR(p) mkdir(p, 0755)
 #endif
 
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static void put2(char *p, unsigned v)
+{
+    p[0] = (char)('0' + v / 10);
+    p[1] = (char)('0' + v % 10);
+}
+
+static void format_u32(uint32_t v, char *out)
+{
+    char tmp[10];
+    int n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n > 0)
+    {
+        *out++ = tmp[--n];
+    }
+    *out = '\0';
+}
+
+/**
+ * @brief Derived value as a JSON number, "null" when it is not finite
+ * 
+ * Values that round to zero are written as 0.00, never -0.00.
+ */
+static void format_derived(double v, char *out, size_t size)
+{
+    if (!isfinite(v))
+    {
+        snprintf(out, size, "null");
+        return;
+    }
+    snprintf(out, size, "%.2f", fabs(v) < 0.005 ? 0.0 : v);
+}
+
 /*********************
  *    FUNCTIONS
  *********************/
+void civil_from_days(uint32_t day, int *year, unsigned *month, unsigned *mday)
+{
+    int64_t z = (int64_t)day + 719468;
+    int64_t era = z / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    *mday = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = (int)(yoe + era * 400) + (*month <= 2);
+}
+
+const char* format_iso8601(iso_time_cache_t *times, uint32_t timestamp, char *out)
+{
+    uint32_t day = timestamp / 86400u;
+    uint32_t sec = timestamp - day * 86400u;
+    if (!times->valid || times->day != day)
+    {
+        int year;
+        unsigned month, mday;
+        char date[16];
+        civil_from_days(day, &year, &month, &mday);
+        snprintf(date, sizeof(date), "%04d-%02u-%02uT", year, month, mday);
+        memcpy(times->date, date, sizeof(times->date));
+        times->day = day;
+        times->valid = 1;
+    }
+    memcpy(out, times->date, sizeof(times->date));
+    put2(out + 11, sec / 3600);
+    out[13] = ':';
+    put2(out + 14, sec / 60 % 60);
+    out[16] = ':';
+    put2(out + 17, sec % 60);
+    out[19] = 'Z';
+    out[20] = '\0';
+    return out;
+}
+
 void write_json_header(const file_header_t *header, FILE *f)
 {
     fprintf(f, "{\n");
@@ -38,13 +118,80 @@ void write_json_header(const file_header_t *header, FILE *f)
     fprintf(f, "  \"records\": [\n");
 }
 
+long write_json_header_patchable(const file_header_t *header, FILE *f)
+{
+    fprintf(f, "{\n");
+    fprintf(f, "  \"metadata\": {\n");
+    fprintf(f, "    \"file_id\": \"%s\",\n", header->file_id);
+    fprintf(f, "    \"version\": %u,\n", header->version);
+    fprintf(f, "    \"record_count\": ");
+    long offset = ftell(f);
+    fprintf(f, "%-10u\n", header->count);
+    fprintf(f, "  },\n");
+    fprintf(f, "  \"records\": [\n");
+    return offset;
+}
+
+int patch_json_record_count(FILE *f, long offset, uint32_t count)
+{
+    long end = ftell(f);
+    if (offset < 0 || end < 0 || fseek(f, offset, SEEK_SET) != 0)
+    {
+        return -1;
+    }
+    fprintf(f, "%-10u", count);
+    return fseek(f, end, SEEK_SET);
+}
+
 void write_json_record(const weather_record_t *record, FILE *f, int is_last)
 {
+    write_json_record_extra(record, NULL, NULL, "", "", f, is_last);
+}
+
+void write_json_record_extra(const weather_record_t *record, const derived_metrics_t *derived,
+                             iso_time_cache_t *times, const char *invalid, const char *extra,
+                             FILE *f, int is_last)
+{
+    // Quoted ISO-8601 string or the bare number, both without printf parsing
+    char timestamp[ISO8601_SIZE + 2];
+    if (times)
+    {
+        timestamp[0] = '"';
+        format_iso8601(times, record->timestamp, timestamp + 1);
+        timestamp[ISO8601_SIZE] = '"';
+        timestamp[ISO8601_SIZE + 1] = '\0';
+    }
+    else
+    {
+        format_u32(record->timestamp, timestamp);
+    }
+
+    // Sized for four %.2f of FLT_MAX, so the object is never truncated
+    char derived_json[384];
+    derived_json[0] = '\0';
+    if (derived)
+    {
+        char dew[48], heat[48], u[48], v[48];
+        format_derived(derived->dew_point, dew, sizeof(dew));
+        format_derived(derived->heat_index, heat, sizeof(heat));
+        format_derived(derived->wind_u, u, sizeof(u));
+        format_derived(derived->wind_v, v, sizeof(v));
+        snprintf(derived_json, sizeof(derived_json),
+            ",\n"
+            "      \"derived\": {\n"
+            "        \"dew_point\": %s,\n"
+            "        \"heat_index\": %s,\n"
+            "        \"wind_u\": %s,\n"
+            "        \"wind_v\": %s\n"
+            "      }",
+            dew, heat, u, v);
+    }
+
     fprintf(f,
         "    {\n"
         "      \"sensor_id\": %u,\n"
         "      \"battery\": \"%s\",\n"
-        "      \"timestamp\": %u,\n"
+        "      \"timestamp\": %s,\n"
         "      \"location\": {\n"
         "        \"lat\": %.8f,\n"
         "        \"lon\": %.8f\n"
@@ -61,11 +208,11 @@ void write_json_record(const weather_record_t *record, FILE *f, int is_last)
         "        \"rain\": %.2f,\n"
         "        \"uv\": %.2f,\n"
         "        \"light\": %.2f\n"
-        "      }\n"
+        "      }%s%s%s\n"
         "    }%s\n",
         record->sensor_id,
         battery_status_to_string(record->battery),
-        record->timestamp,
+        timestamp,
         record->lat, record->lon,
         record->temperature,
         record->humidity,
@@ -76,6 +223,9 @@ void write_json_record(const weather_record_t *record, FILE *f, int is_last)
         record->rain,
         record->uv,
         record->light,
+        derived_json,
+        invalid,
+        extra,
         is_last ? "" : ","
     );
 }
@@ -0,0 +1,171 @@
+/**
+ * @file mem_track.c
+ * @brief Counting allocator implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "mem_track.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+// Size prefix stored in front of every block; 16 keeps malloc's alignment
+#define MEM_PREFIX 16
+
+/*********************
+ *  STATIC VARIABLES
+ *********************/
+static size_t live_bytes;
+static size_t peak_bytes;
+static size_t window_peak_bytes;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static void raise_peak(size_t *peak, size_t value)
+{
+    size_t cur = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (value > cur &&
+           !__atomic_compare_exchange_n(peak, &cur, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static void account_alloc(size_t size)
+{
+    size_t live = __atomic_add_fetch(&live_bytes, size, __ATOMIC_RELAXED);
+    raise_peak(&peak_bytes, live);
+    raise_peak(&window_peak_bytes, live);
+}
+
+static void account_free(size_t size)
+{
+    __atomic_sub_fetch(&live_bytes, size, __ATOMIC_RELAXED);
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+void* mem_malloc(size_t size)
+{
+    unsigned char *p = (unsigned char*)malloc(size + MEM_PREFIX);
+    if (!p)
+    {
+        return NULL;
+    }
+    memcpy(p, &size, sizeof(size));
+    account_alloc(size);
+    return p + MEM_PREFIX;
+}
+
+void* mem_calloc(size_t count, size_t size)
+{
+    if (size != 0 && count > ((size_t)-1 - MEM_PREFIX) / size)
+    {
+        return NULL;
+    }
+    void *p = mem_malloc(count * size);
+    if (p)
+    {
+        memset(p, 0, count * size);
+    }
+    return p;
+}
+
+void* mem_realloc(void *ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return mem_malloc(size);
+    }
+
+    unsigned char *base = (unsigned char*)ptr - MEM_PREFIX;
+    size_t old_size;
+    memcpy(&old_size, base, sizeof(old_size));
+
+    unsigned char *p = (unsigned char*)realloc(base, size + MEM_PREFIX);
+    if (!p)
+    {
+        return NULL;
+    }
+    memcpy(p, &size, sizeof(size));
+    account_free(old_size);
+    account_alloc(size);
+    return p + MEM_PREFIX;
+}
+
+void mem_free(void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    unsigned char *base = (unsigned char*)ptr - MEM_PREFIX;
+    size_t size;
+    memcpy(&size, base, sizeof(size));
+    account_free(size);
+    free(base);
+}
+
+size_t mem_live_bytes(void)
+{
+    return __atomic_load_n(&live_bytes, __ATOMIC_RELAXED);
+}
+
+size_t mem_peak_bytes(void)
+{
+    return __atomic_load_n(&peak_bytes, __ATOMIC_RELAXED);
+}
+
+void mem_window_reset(void)
+{
+    __atomic_store_n(&window_peak_bytes, mem_live_bytes(), __ATOMIC_RELAXED);
+}
+
+size_t mem_window_peak_bytes(void)
+{
+    return __atomic_load_n(&window_peak_bytes, __ATOMIC_RELAXED);
+}
+
+size_t mem_peak_rss_bytes(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    {
+        return 0;
+    }
+    return (size_t)pmc.PeakWorkingSetSize;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+    {
+        return 0;
+    }
+  #ifdef __APPLE__
+    return (size_t)ru.ru_maxrss;          // bytes on macOS
+  #else
+    return (size_t)ru.ru_maxrss * 1024u;  // kilobytes on Linux
+  #endif
+#endif
+}
+
+int mem_within_budget(size_t budget_bytes)
+{
+    if (budget_bytes == 0)
+    {
+        return 1;
+    }
+    return mem_live_bytes() <= budget_bytes && mem_peak_rss_bytes() <= budget_bytes;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+/**
+ * @file perf_counters.c
+ * @brief Hardware performance counters implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#ifdef __linux__
+  #define _GNU_SOURCE
+#endif
+#include "perf_counters.h"
+#include <string.h>
+
+#ifdef __linux__
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+#ifdef __linux__
+static int open_event(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int perf_counters_open(perf_counters_t *pc)
+{
+    memset(pc, 0, sizeof(*pc));
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        pc->fd[i] = -1;
+    }
+
+#ifdef __linux__
+    static const struct { uint32_t type; uint64_t config; } events[PERF_EVENT_COUNT] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    };
+
+    int opened = 0;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        pc->fd[i] = open_event(events[i].type, events[i].config);
+        if (pc->fd[i] >= 0)
+        {
+            pc->available[i] = 1;
+            opened++;
+        }
+    }
+    return opened;
+#else
+    return 0;
+#endif
+}
+
+void perf_counters_start(perf_counters_t *pc)
+{
+#ifdef __linux__
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (pc->available[i])
+        {
+            ioctl(pc->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)pc;
+#endif
+}
+
+void perf_counters_stop(perf_counters_t *pc)
+{
+#ifdef __linux__
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (pc->available[i])
+        {
+            ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        uint64_t buf[3]; // value, time_enabled, time_running
+        pc->values[i] = 0;
+        if (!pc->available[i] || read(pc->fd[i], buf, sizeof(buf)) != (ssize_t)sizeof(buf))
+        {
+            continue;
+        }
+        if (buf[2] > 0 && buf[2] < buf[1])
+        {
+            buf[0] = (uint64_t)((double)buf[0] * (double)buf[1] / (double)buf[2]);
+        }
+        pc->values[i] = buf[0];
+    }
+#else
+    memset(pc->values, 0, sizeof(pc->values));
+#endif
+}
+
+void perf_counters_close(perf_counters_t *pc)
+{
+#ifdef __linux__
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (pc->fd[i] >= 0)
+        {
+            close(pc->fd[i]);
+        }
+        pc->fd[i] = -1;
+        pc->available[i] = 0;
+    }
+#else
+    (void)pc;
+#endif
+}
+
+const char* perf_event_name(perf_event_id_t id)
+{
+    switch (id)
+    {
+        case PERF_CYCLES:        return "cycles";
+        case PERF_INSTRUCTIONS:  return "instructions";
+        case PERF_BRANCH_MISSES: return "branch-misses";
+        case PERF_L1D_MISSES:    return "L1d-misses";
+        case PERF_LLC_MISSES:    return "LLC-misses";
+        default:                 return "unknown";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,668 @@
+/**
+ * @file quantile_sketch.c
+ * @brief Log-bucket quantile sketch implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "quantile_sketch.h"
+#include "binary_io.h"
+#include "json_writer.h"
+#include "mem_track.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define INITIAL_CAPACITY   256
+#define STORE_SLACK        8
+#define STORE_MAX_BUCKETS  (1u << 20)
+#define FILE_HEADER_SIZE   20
+#define ENTRY_HEADER_SIZE  49
+#define DEFAULT_METRICS    ((1u << METRIC_TEMPERATURE) | (1u << METRIC_CO2))
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static double inv_ln_gamma(void)
+{
+    static double inv = 0.0;
+    if (inv == 0.0)
+    {
+        const double a = QSKETCH_RELATIVE_ACCURACY;
+        inv = 1.0 / log((1.0 + a) / (1.0 - a));
+    }
+    return inv;
+}
+
+static int32_t bucket_index(double magnitude)
+{
+    return (int32_t)ceil(log(magnitude) * inv_ln_gamma());
+}
+
+/* Midpoint (in relative terms) of bucket i, i.e. of (gamma^(i-1), gamma^i] */
+static double bucket_value(int32_t index)
+{
+    const double a = QSKETCH_RELATIVE_ACCURACY;
+    double gamma = (1.0 + a) / (1.0 - a);
+    return 2.0 * exp((double)index / inv_ln_gamma()) / (gamma + 1.0);
+}
+
+static int store_ensure(sketch_store_t *s, int32_t index)
+{
+    if (s->len > 0 && index >= s->lo && index < s->lo + (int32_t)s->len)
+    {
+        return 1;
+    }
+    int64_t lo = s->len ? s->lo : index;
+    int64_t hi = s->len ? (int64_t)s->lo + s->len - 1 : index;
+    if (index < lo)
+    {
+        lo = (int64_t)index - STORE_SLACK;
+    }
+    if (index > hi)
+    {
+        hi = (int64_t)index + STORE_SLACK;
+    }
+    if (hi - lo + 1 > STORE_MAX_BUCKETS)
+    {
+        return 0;
+    }
+    uint32_t len = (uint32_t)(hi - lo + 1);
+    uint64_t *counts = (uint64_t*)mem_calloc(len, sizeof(uint64_t));
+    if (!counts)
+    {
+        return 0;
+    }
+    if (s->len)
+    {
+        memcpy(counts + (s->lo - lo), s->counts, s->len * sizeof(uint64_t));
+    }
+    mem_free(s->counts);
+    s->counts = counts;
+    s->lo = (int32_t)lo;
+    s->len = len;
+    return 1;
+}
+
+static int store_add(sketch_store_t *s, int32_t index, uint64_t n)
+{
+    if (!store_ensure(s, index))
+    {
+        return 0;
+    }
+    s->counts[index - s->lo] += n;
+    return 1;
+}
+
+static int store_merge(sketch_store_t *dst, const sketch_store_t *src)
+{
+    if (src->len == 0)
+    {
+        return 1;
+    }
+    if (!store_ensure(dst, src->lo) || !store_ensure(dst, src->lo + (int32_t)src->len - 1))
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < src->len; i++)
+    {
+        dst->counts[src->lo + (int32_t)i - dst->lo] += src->counts[i];
+    }
+    return 1;
+}
+
+static uint64_t entry_key(uint32_t sensor_id, uint32_t day, uint8_t metric)
+{
+    return ((uint64_t)sensor_id << 32) ^ ((uint64_t)day << 8) ^ metric;
+}
+
+static int table_grow(sketch_table_t *t)
+{
+    size_t capacity = t->capacity * 2;
+    sketch_entry_t *slots = (sketch_entry_t*)mem_calloc(capacity, sizeof(sketch_entry_t));
+    if (!slots)
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < t->capacity; i++)
+    {
+        const sketch_entry_t *e = &t->slots[i];
+        if (!e->used)
+        {
+            continue;
+        }
+        size_t j = util_hash_slot(entry_key(e->sensor_id, e->day, e->metric), capacity - 1);
+        while (slots[j].used)
+        {
+            j = util_probe_next(j, capacity - 1);
+        }
+        slots[j] = *e;
+    }
+    mem_free(t->slots);
+    t->slots = slots;
+    t->capacity = capacity;
+    return 1;
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    const sketch_entry_t *x = *(const sketch_entry_t* const*)a;
+    const sketch_entry_t *y = *(const sketch_entry_t* const*)b;
+    if (x->sensor_id != y->sensor_id)
+    {
+        return x->sensor_id < y->sensor_id ? -1 : 1;
+    }
+    if (x->day != y->day)
+    {
+        return x->day < y->day ? -1 : 1;
+    }
+    return (int)x->metric - (int)y->metric;
+}
+
+static int write_store(const sketch_store_t *s, FILE *f)
+{
+    uint8_t buf[8];
+    store_u32_le(buf, (uint32_t)s->lo);
+    store_u32_le(buf + 4, s->len);
+    if (fwrite(buf, 1, 8, f) != 8)
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < s->len; i++)
+    {
+        store_u32_le(buf, (uint32_t)s->counts[i]);
+        store_u32_le(buf + 4, (uint32_t)(s->counts[i] >> 32));
+        if (fwrite(buf, 1, 8, f) != 8)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int read_store(sketch_store_t *s, FILE *f)
+{
+    uint8_t buf[8];
+    if (fread(buf, 1, 8, f) != 8)
+    {
+        return 0;
+    }
+    s->lo = (int32_t)load_u32_le(buf);
+    s->len = 0;
+    s->counts = NULL;
+    uint32_t len = load_u32_le(buf + 4);
+    if (len == 0)
+    {
+        return 1;
+    }
+    if (len > STORE_MAX_BUCKETS)
+    {
+        return 0;
+    }
+    s->counts = (uint64_t*)mem_malloc(len * sizeof(uint64_t));
+    if (!s->counts)
+    {
+        return 0;
+    }
+    s->len = len;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (fread(buf, 1, 8, f) != 8)
+        {
+            return 0;
+        }
+        s->counts[i] = (uint64_t)load_u32_le(buf) | ((uint64_t)load_u32_le(buf + 4) << 32);
+    }
+    return 1;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+void qsketch_init(quantile_sketch_t *q)
+{
+    memset(q, 0, sizeof(*q));
+    q->min = INFINITY;
+    q->max = -INFINITY;
+}
+
+int qsketch_add(quantile_sketch_t *q, double x)
+{
+    // Infinities have no bucket (log() would overflow the index)
+    if (!isfinite(x))
+    {
+        return 1;
+    }
+    int ok = 1;
+    if (x >= QSKETCH_MIN_MAGNITUDE)
+    {
+        ok = store_add(&q->pos, bucket_index(x), 1);
+    }
+    else if (x <= -QSKETCH_MIN_MAGNITUDE)
+    {
+        ok = store_add(&q->neg, bucket_index(-x), 1);
+    }
+    else
+    {
+        q->zero++;
+    }
+    if (!ok)
+    {
+        return 0;
+    }
+    q->count++;
+    q->sum += x;
+    if (x < q->min)
+    {
+        q->min = x;
+    }
+    if (x > q->max)
+    {
+        q->max = x;
+    }
+    return 1;
+}
+
+int qsketch_merge(quantile_sketch_t *dst, const quantile_sketch_t *src)
+{
+    if (!store_merge(&dst->pos, &src->pos) || !store_merge(&dst->neg, &src->neg))
+    {
+        return 0;
+    }
+    dst->zero += src->zero;
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->min < dst->min)
+    {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max)
+    {
+        dst->max = src->max;
+    }
+    return 1;
+}
+
+double qsketch_quantile(const quantile_sketch_t *q, double p)
+{
+    if (q->count == 0)
+    {
+        return NAN;
+    }
+    p = p < 0.0 ? 0.0 : (p > 1.0 ? 1.0 : p);
+    uint64_t rank = (uint64_t)(p * (double)(q->count - 1));
+    uint64_t seen = 0;
+    double v = q->max;
+
+    // Ascending order: negative store from the largest magnitude down, zero, positive store up
+    int found = 0;
+    for (uint32_t i = q->neg.len; i-- > 0 && !found; )
+    {
+        seen += q->neg.counts[i];
+        if (seen > rank)
+        {
+            v = -bucket_value(q->neg.lo + (int32_t)i);
+            found = 1;
+        }
+    }
+    if (!found)
+    {
+        seen += q->zero;
+        if (seen > rank)
+        {
+            v = 0.0;
+            found = 1;
+        }
+    }
+    for (uint32_t i = 0; i < q->pos.len && !found; i++)
+    {
+        seen += q->pos.counts[i];
+        if (seen > rank)
+        {
+            v = bucket_value(q->pos.lo + (int32_t)i);
+            found = 1;
+        }
+    }
+    if (v < q->min)
+    {
+        v = q->min;
+    }
+    if (v > q->max)
+    {
+        v = q->max;
+    }
+    return v;
+}
+
+void qsketch_free(quantile_sketch_t *q)
+{
+    mem_free(q->pos.counts);
+    mem_free(q->neg.counts);
+    qsketch_init(q);
+}
+
+int sketch_table_init(sketch_table_t *t, uint32_t metric_mask)
+{
+    memset(t, 0, sizeof(*t));
+    t->metric_mask = metric_mask ? metric_mask : DEFAULT_METRICS;
+    t->capacity = INITIAL_CAPACITY;
+    t->slots = (sketch_entry_t*)mem_calloc(t->capacity, sizeof(sketch_entry_t));
+    return t->slots != NULL;
+}
+
+quantile_sketch_t* sketch_table_get(sketch_table_t *t, uint32_t sensor_id, uint32_t day, uint8_t metric)
+{
+    size_t mask = t->capacity - 1;
+    size_t i = util_hash_slot(entry_key(sensor_id, day, metric), mask);
+    while (t->slots[i].used)
+    {
+        sketch_entry_t *e = &t->slots[i];
+        if (e->sensor_id == sensor_id && e->day == day && e->metric == metric)
+        {
+            return &e->sketch;
+        }
+        i = util_probe_next(i, mask);
+    }
+    if ((t->size + 1) * 2 > t->capacity)
+    {
+        if (!table_grow(t))
+        {
+            return NULL;
+        }
+        return sketch_table_get(t, sensor_id, day, metric);
+    }
+    sketch_entry_t *e = &t->slots[i];
+    e->used = 1;
+    e->sensor_id = sensor_id;
+    e->day = day;
+    e->metric = metric;
+    qsketch_init(&e->sketch);
+    t->size++;
+    return &e->sketch;
+}
+
+int sketch_table_add_record(sketch_table_t *t, const weather_record_t *record)
+{
+    const double values[METRIC_COUNT] = {
+        record->temperature,
+        record->humidity,
+        record->pressure,
+        record->co2 == 0xFFFF ? NAN : (double)record->co2,
+    };
+    uint32_t day = record->timestamp / SECONDS_PER_DAY;
+    for (int m = 0; m < METRIC_COUNT; m++)
+    {
+        if (!(t->metric_mask & (1u << m)) || !isfinite(values[m]))
+        {
+            continue;
+        }
+        quantile_sketch_t *q = sketch_table_get(t, record->sensor_id, day, (uint8_t)m);
+        if (!q || !qsketch_add(q, values[m]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int sketch_table_merge(sketch_table_t *t, const sketch_table_t *src)
+{
+    for (size_t i = 0; i < src->capacity; i++)
+    {
+        const sketch_entry_t *e = &src->slots[i];
+        if (!e->used)
+        {
+            continue;
+        }
+        quantile_sketch_t *q = sketch_table_get(t, e->sensor_id, e->day, e->metric);
+        if (!q || !qsketch_merge(q, &e->sketch))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int sketch_table_save(const sketch_table_t *t, const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        fprintf(stderr, "ERROR: Cannot open sketch file '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+    uint8_t buf[ENTRY_HEADER_SIZE];
+    memcpy(buf, QSKETCH_MAGIC, 4);
+    store_u16_le(buf + 4, QSKETCH_VERSION);
+    store_u16_le(buf + 6, 0);
+    store_f64_le(buf + 8, QSKETCH_RELATIVE_ACCURACY);
+    store_u32_le(buf + 16, (uint32_t)t->size);
+    int ok = fwrite(buf, 1, FILE_HEADER_SIZE, f) == FILE_HEADER_SIZE;
+
+    for (size_t i = 0; ok && i < t->capacity; i++)
+    {
+        const sketch_entry_t *e = &t->slots[i];
+        if (!e->used)
+        {
+            continue;
+        }
+        const quantile_sketch_t *q = &e->sketch;
+        store_u32_le(buf, e->sensor_id);
+        store_u32_le(buf + 4, e->day);
+        buf[8] = e->metric;
+        store_u32_le(buf + 9, (uint32_t)q->count);
+        store_u32_le(buf + 13, (uint32_t)(q->count >> 32));
+        store_u32_le(buf + 17, (uint32_t)q->zero);
+        store_u32_le(buf + 21, (uint32_t)(q->zero >> 32));
+        store_f64_le(buf + 25, q->min);
+        store_f64_le(buf + 33, q->max);
+        store_f64_le(buf + 41, q->sum);
+        ok = fwrite(buf, 1, ENTRY_HEADER_SIZE, f) == ENTRY_HEADER_SIZE &&
+             write_store(&q->pos, f) && write_store(&q->neg, f);
+    }
+    if (fclose(f) != 0)
+    {
+        ok = 0;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Failed to write sketch file '%s'\n", path);
+    }
+    return ok;
+}
+
+int sketch_table_load(sketch_table_t *t, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "ERROR: Cannot open sketch file '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+    uint8_t buf[ENTRY_HEADER_SIZE];
+    if (fread(buf, 1, FILE_HEADER_SIZE, f) != FILE_HEADER_SIZE ||
+        memcmp(buf, QSKETCH_MAGIC, 4) != 0 || load_u16_le(buf + 4) != QSKETCH_VERSION)
+    {
+        fprintf(stderr, "ERROR: '%s' is not a sketch file\n", path);
+        fclose(f);
+        return 0;
+    }
+    if (load_f64_le(buf + 8) != QSKETCH_RELATIVE_ACCURACY)
+    {
+        fprintf(stderr, "ERROR: '%s' uses a different bucket layout and cannot be merged exactly\n", path);
+        fclose(f);
+        return 0;
+    }
+
+    uint32_t n = load_u32_le(buf + 16);
+    int ok = 1;
+    for (uint32_t i = 0; ok && i < n; i++)
+    {
+        quantile_sketch_t q;
+        qsketch_init(&q);
+        ok = fread(buf, 1, ENTRY_HEADER_SIZE, f) == ENTRY_HEADER_SIZE;
+        if (ok)
+        {
+            q.count = (uint64_t)load_u32_le(buf + 9) | ((uint64_t)load_u32_le(buf + 13) << 32);
+            q.zero = (uint64_t)load_u32_le(buf + 17) | ((uint64_t)load_u32_le(buf + 21) << 32);
+            q.min = load_f64_le(buf + 25);
+            q.max = load_f64_le(buf + 33);
+            q.sum = load_f64_le(buf + 41);
+            ok = read_store(&q.pos, f) && read_store(&q.neg, f);
+        }
+        if (ok)
+        {
+            quantile_sketch_t *dst = sketch_table_get(t, load_u32_le(buf), load_u32_le(buf + 4), buf[8]);
+            ok = dst && qsketch_merge(dst, &q);
+        }
+        mem_free(q.pos.counts);
+        mem_free(q.neg.counts);
+    }
+    fclose(f);
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Sketch file '%s' is truncated or corrupt\n", path);
+    }
+    return ok;
+}
+
+int sketch_table_print_quantiles(const sketch_table_t *t, int rollup, FILE *f)
+{
+    sketch_table_t days;
+    const sketch_table_t *src = t;
+    if (rollup)
+    {
+        // Merge all days of a (sensor, metric) under day 0
+        if (!sketch_table_init(&days, t->metric_mask))
+        {
+            return 0;
+        }
+        for (size_t i = 0; i < t->capacity; i++)
+        {
+            const sketch_entry_t *e = &t->slots[i];
+            if (!e->used)
+            {
+                continue;
+            }
+            quantile_sketch_t *q = sketch_table_get(&days, e->sensor_id, 0, e->metric);
+            if (!q || !qsketch_merge(q, &e->sketch))
+            {
+                sketch_table_free(&days);
+                return 0;
+            }
+        }
+        src = &days;
+    }
+
+    const sketch_entry_t **sorted = (const sketch_entry_t**)mem_malloc(src->size * sizeof(*sorted) + 1);
+    if (!sorted)
+    {
+        if (rollup)
+        {
+            sketch_table_free(&days);
+        }
+        return 0;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < src->capacity; i++)
+    {
+        if (src->slots[i].used)
+        {
+            sorted[n++] = &src->slots[i];
+        }
+    }
+    qsort(sorted, n, sizeof(*sorted), compare_entries);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const sketch_entry_t *e = sorted[i];
+        const quantile_sketch_t *q = &e->sketch;
+        fprintf(f, "{\"sensor_id\":%u,", e->sensor_id);
+        if (!rollup)
+        {
+            int year;
+            unsigned month, mday;
+            civil_from_days(e->day, &year, &month, &mday);
+            fprintf(f, "\"day\":\"%04d-%02u-%02u\",", year, month, mday);
+        }
+        fprintf(f, "\"metric\":\"%s\",\"count\":%llu,\"min\":%.2f,\"mean\":%.2f,"
+                   "\"p50\":%.2f,\"p95\":%.2f,\"p99\":%.2f,\"max\":%.2f}\n",
+                rolling_metric_name((rolling_metric_t)e->metric), (unsigned long long)q->count,
+                q->min, q->count ? q->sum / (double)q->count : 0.0,
+                qsketch_quantile(q, 0.50), qsketch_quantile(q, 0.95), qsketch_quantile(q, 0.99), q->max);
+    }
+    mem_free(sorted);
+    if (rollup)
+    {
+        sketch_table_free(&days);
+    }
+    return 1;
+}
+
+void sketch_table_free(sketch_table_t *t)
+{
+    for (size_t i = 0; t->slots && i < t->capacity; i++)
+    {
+        if (t->slots[i].used)
+        {
+            qsketch_free(&t->slots[i].sketch);
+        }
+    }
+    mem_free(t->slots);
+    t->slots = NULL;
+    t->capacity = 0;
+    t->size = 0;
+}
+
+int merge_sketch_files(const char **input_files, int n_inputs, const char *output_file)
+{
+    sketch_table_t t;
+    if (!sketch_table_init(&t, 0))
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+    int ok = 1;
+    for (int i = 0; ok && i < n_inputs; i++)
+    {
+        ok = sketch_table_load(&t, input_files[i]);
+    }
+    if (ok)
+    {
+        ok = sketch_table_save(&t, output_file);
+    }
+    if (ok)
+    {
+        printf("SUCCESS: Merged %d sketch files into %zu sketches (%s)\n", n_inputs, t.size, output_file);
+    }
+    sketch_table_free(&t);
+    return ok ? 0 : 1;
+}
+
+int query_sketch_files(const char **input_files, int n_inputs, int rollup)
+{
+    sketch_table_t t;
+    if (!sketch_table_init(&t, 0))
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+    int ok = 1;
+    for (int i = 0; ok && i < n_inputs; i++)
+    {
+        ok = sketch_table_load(&t, input_files[i]);
+    }
+    if (ok && !sketch_table_print_quantiles(&t, rollup, stdout))
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        ok = 0;
+    }
+    sketch_table_free(&t);
+    return ok ? 0 : 1;
+}
\ No newline at end of file
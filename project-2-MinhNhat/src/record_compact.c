@@ -0,0 +1,523 @@
+/**
+ * @file record_compact.c
+ * @brief Small-file compaction implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "record_compact.h"
+#include "record_sort.h"
+#include "weather_parser.h"
+#include "bin_writer.h"
+#include "binary_io.h"
+#include "dedup.h"
+#include "mem_track.h"
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TIMESTAMP_OFFSET 5  // sensor_id (4) + battery (1)
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    char *path;
+    uint32_t records;       // Records read
+} compact_input_t;
+
+typedef struct {
+    char *path;
+    uint32_t records;
+    uint32_t min_sensor;
+    uint32_t max_sensor;
+    uint32_t min_timestamp;
+    uint32_t max_timestamp;
+} compact_output_t;
+
+typedef struct {
+    const compact_options_t *opts;
+    const char *prefix;
+    file_header_t header;       // Output header: the first input's file_id, the shared version
+    int have_header;
+    uint32_t per_output;        // Records per output file
+
+    uint8_t *buf;               // Sort mode: records of the current output
+    uint32_t buf_count;
+    bin_writer_t w;             // Stream mode: current output
+    int writer_open;
+
+    dedup_set_t seen;
+    uint64_t duplicates;
+    uint64_t records_out;
+
+    compact_input_t *inputs;
+    size_t n_inputs;
+    size_t inputs_cap;
+    compact_output_t *outputs;
+    size_t n_outputs;
+    size_t outputs_cap;
+} compact_state_t;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static char* copy_string(const char *s)
+{
+    size_t len = strlen(s) + 1;
+    char *p = (char*)mem_malloc(len);
+    if (p)
+    {
+        memcpy(p, s, len);
+    }
+    return p;
+}
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static int add_input(compact_state_t *st, const char *path)
+{
+    if (st->n_inputs == st->inputs_cap)
+    {
+        size_t cap = st->inputs_cap ? st->inputs_cap * 2 : 64;
+        compact_input_t *grown = (compact_input_t*)mem_calloc(cap, sizeof(compact_input_t));
+        if (!grown)
+        {
+            return 0;
+        }
+        if (st->n_inputs)
+        {
+            memcpy(grown, st->inputs, st->n_inputs * sizeof(compact_input_t));
+        }
+        mem_free(st->inputs);
+        st->inputs = grown;
+        st->inputs_cap = cap;
+    }
+    st->inputs[st->n_inputs].path = copy_string(path);
+    if (!st->inputs[st->n_inputs].path)
+    {
+        return 0;
+    }
+    st->n_inputs++;
+    return 1;
+}
+
+/* Directories expand to their visible *.bin files, in name order */
+static int collect_inputs(compact_state_t *st, const char *path)
+{
+    struct stat sb;
+    if (stat(path, &sb) != 0 || !S_ISDIR(sb.st_mode))
+    {
+        return add_input(st, path);
+    }
+    DIR *dir = opendir(path);
+    if (!dir)
+    {
+        fprintf(stderr, "ERROR: Cannot read directory '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+    char **names = NULL;
+    size_t n = 0, cap = 0;
+    int ok = 1;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL)
+    {
+        size_t len = strlen(entry->d_name);
+        if (entry->d_name[0] == '.' || len <= 4 || strcmp(entry->d_name + len - 4, ".bin") != 0)
+        {
+            continue;
+        }
+        if (n == cap)
+        {
+            cap = cap ? cap * 2 : 64;
+            char **grown = (char**)mem_calloc(cap, sizeof(char*));
+            ok = grown != NULL;
+            if (ok && n)
+            {
+                memcpy(grown, names, n * sizeof(char*));
+            }
+            mem_free(names);
+            names = grown;
+        }
+        if (ok)
+        {
+            size_t size = strlen(path) + len + 2;
+            names[n] = (char*)mem_malloc(size);
+            ok = names[n] != NULL;
+            if (ok)
+            {
+                snprintf(names[n++], size, "%s/%s", path, entry->d_name);
+            }
+        }
+    }
+    closedir(dir);
+    if (ok && n)
+    {
+        qsort(names, n, sizeof(char*), compare_names);
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        ok = ok && add_input(st, names[i]);
+        mem_free(names[i]);
+    }
+    mem_free(names);
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+    }
+    return ok;
+}
+
+static compact_output_t* begin_output(compact_state_t *st)
+{
+    if (st->n_outputs == st->outputs_cap)
+    {
+        size_t cap = st->outputs_cap ? st->outputs_cap * 2 : 16;
+        compact_output_t *grown = (compact_output_t*)mem_calloc(cap, sizeof(compact_output_t));
+        if (!grown)
+        {
+            return NULL;
+        }
+        if (st->n_outputs)
+        {
+            memcpy(grown, st->outputs, st->n_outputs * sizeof(compact_output_t));
+        }
+        mem_free(st->outputs);
+        st->outputs = grown;
+        st->outputs_cap = cap;
+    }
+    size_t size = strlen(st->prefix) + 16;
+    compact_output_t *out = &st->outputs[st->n_outputs];
+    memset(out, 0, sizeof(*out));
+    out->path = (char*)mem_malloc(size);
+    if (!out->path)
+    {
+        return NULL;
+    }
+    snprintf(out->path, size, "%s-%05u.bin", st->prefix, (unsigned)st->n_outputs);
+    out->min_sensor = UINT32_MAX;
+    out->min_timestamp = UINT32_MAX;
+    st->n_outputs++;
+    if (!bin_writer_open(&st->w, out->path, &st->header))
+    {
+        return NULL;
+    }
+    st->writer_open = 1;
+    return out;
+}
+
+static void note_record(compact_output_t *out, const uint8_t *packed)
+{
+    uint32_t sensor_id = load_u32_le(packed);
+    uint32_t timestamp = load_u32_le(packed + TIMESTAMP_OFFSET);
+    out->records++;
+    out->min_sensor = sensor_id < out->min_sensor ? sensor_id : out->min_sensor;
+    out->max_sensor = sensor_id > out->max_sensor ? sensor_id : out->max_sensor;
+    out->min_timestamp = timestamp < out->min_timestamp ? timestamp : out->min_timestamp;
+    out->max_timestamp = timestamp > out->max_timestamp ? timestamp : out->max_timestamp;
+}
+
+static int end_output(compact_state_t *st)
+{
+    st->writer_open = 0;
+    if (!bin_writer_close(&st->w))
+    {
+        fprintf(stderr, "ERROR: Failed to write '%s'\n", st->outputs[st->n_outputs - 1].path);
+        return 0;
+    }
+    return 1;
+}
+
+/* Sort mode: sort the buffered output and write it in one go */
+static int flush_sorted(compact_state_t *st)
+{
+    if (st->buf_count == 0)
+    {
+        return 1;
+    }
+    if (!sort_packed_records(st->buf, st->buf_count))
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 0;
+    }
+    compact_output_t *out = begin_output(st);
+    if (!out)
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < st->buf_count; i++)
+    {
+        const uint8_t *rec = st->buf + (size_t)i * RECORD_SIZE;
+        if (!bin_writer_write_packed(&st->w, rec))
+        {
+            break;
+        }
+        note_record(out, rec);
+    }
+    st->buf_count = 0;
+    return end_output(st);
+}
+
+static int append_record(compact_state_t *st, const uint8_t *packed)
+{
+    if (st->opts->dedup)
+    {
+        int fresh = dedup_set_insert(&st->seen, record_key_packed(packed));
+        if (fresh < 0)
+        {
+            fprintf(stderr, "ERROR: Out of memory in dedup set\n");
+            return 0;
+        }
+        if (!fresh)
+        {
+            st->duplicates++;
+            return 1;
+        }
+    }
+    st->records_out++;
+
+    if (st->buf)
+    {
+        memcpy(st->buf + (size_t)st->buf_count * RECORD_SIZE, packed, RECORD_SIZE);
+        return ++st->buf_count < st->per_output || flush_sorted(st);
+    }
+    if (!st->writer_open && !begin_output(st))
+    {
+        return 0;
+    }
+    compact_output_t *out = &st->outputs[st->n_outputs - 1];
+    if (!bin_writer_write_packed(&st->w, packed))
+    {
+        return end_output(st);
+    }
+    note_record(out, packed);
+    return out->records < st->per_output || end_output(st);
+}
+
+static int compact_input(compact_state_t *st, compact_input_t *in, uint8_t *batch)
+{
+    FILE *fin = fopen(in->path, "rb");
+    if (!fin)
+    {
+        fprintf(stderr, "ERROR: Cannot open input file '%s': %s\n", in->path, strerror(errno));
+        return 0;
+    }
+    file_header_t header;
+    if (!read_header(&header, fin))
+    {
+        fprintf(stderr, "ERROR: Failed to read file header of '%s'\n", in->path);
+        fclose(fin);
+        return 0;
+    }
+    // The record layout only depends on the version; gateways may stamp
+    // their own file_id, and the outputs carry the first input's.
+    if (!st->have_header)
+    {
+        st->header = header;
+        st->have_header = 1;
+    }
+    else if (header.version != st->header.version)
+    {
+        fprintf(stderr, "ERROR: '%s' is version %u, expected version %u like the first input\n",
+                in->path, header.version, st->header.version);
+        fclose(fin);
+        return 0;
+    }
+    validate_file_size(fin, header.count);
+
+    int ok = 1;
+    uint32_t remaining = header.count;
+    while (ok && remaining > 0)
+    {
+        uint32_t want = remaining < READ_BATCH_RECORDS ? remaining : READ_BATCH_RECORDS;
+        uint32_t got = (uint32_t)(fread(batch, 1, (size_t)want * RECORD_SIZE, fin) / RECORD_SIZE);
+        for (uint32_t i = 0; ok && i < got; i++)
+        {
+            ok = append_record(st, batch + (size_t)i * RECORD_SIZE);
+        }
+        in->records += got;
+        remaining -= got;
+        if (got < want)
+        {
+            fprintf(stderr, "WARNING: '%s' is truncated, kept %u of %u records\n",
+                    in->path, in->records, header.count);
+            break;
+        }
+    }
+    fclose(fin);
+    return ok;
+}
+
+static void write_json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+        {
+            fputc('\\', f);
+        }
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+static int write_manifest(const compact_state_t *st, const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+    {
+        fprintf(stderr, "ERROR: Cannot create manifest '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+    fprintf(f, "{\n  \"file_id\": \"%s\",\n  \"version\": %u,\n", st->header.file_id, st->header.version);
+    fprintf(f, "  \"sorted\": %s,\n  \"deduplicated\": %s,\n",
+            st->opts->sort ? "true" : "false", st->opts->dedup ? "true" : "false");
+    fprintf(f, "  \"records\": %llu,\n  \"duplicates\": %llu,\n",
+            (unsigned long long)st->records_out, (unsigned long long)st->duplicates);
+    fprintf(f, "  \"files\": [");
+    for (size_t i = 0; i < st->n_outputs; i++)
+    {
+        const compact_output_t *o = &st->outputs[i];
+        fprintf(f, "%s\n    {\"path\":", i ? "," : "");
+        write_json_string(f, o->path);
+        fprintf(f, ",\"records\":%u,\"min_sensor_id\":%u,\"max_sensor_id\":%u,"
+                   "\"min_timestamp\":%u,\"max_timestamp\":%u}",
+                o->records, o->min_sensor, o->max_sensor, o->min_timestamp, o->max_timestamp);
+    }
+    fprintf(f, "\n  ],\n  \"inputs\": [");
+    for (size_t i = 0; i < st->n_inputs; i++)
+    {
+        fprintf(f, "%s\n    {\"path\":", i ? "," : "");
+        write_json_string(f, st->inputs[i].path);
+        fprintf(f, ",\"records\":%u}", st->inputs[i].records);
+    }
+    fprintf(f, "\n  ]\n}\n");
+    int ok = !ferror(f);
+    ok = (fclose(f) == 0) && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Failed to write manifest '%s'\n", path);
+    }
+    return ok;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int compact_weather_files(const char **inputs, int n_inputs, const char *output_prefix,
+                          const compact_options_t *opts)
+{
+    compact_state_t st;
+    memset(&st, 0, sizeof(st));
+    st.opts = opts;
+    st.prefix = output_prefix;
+    size_t target = opts->target_size ? opts->target_size : COMPACT_DEFAULT_SIZE;
+    size_t per_output = target > HEADER_SIZE ? (target - HEADER_SIZE) / RECORD_SIZE : 0;
+    st.per_output = per_output == 0 ? 1 : per_output > UINT32_MAX ? UINT32_MAX : (uint32_t)per_output;
+
+    int ok = 1;
+    for (int i = 0; ok && i < n_inputs; i++)
+    {
+        ok = collect_inputs(&st, inputs[i]);
+    }
+    if (ok && st.n_inputs == 0)
+    {
+        fprintf(stderr, "ERROR: No input files\n");
+        ok = 0;
+    }
+    if (ok)
+    {
+        printf("Compacting: %zu files -> %s-*.bin (%u records per file%s%s)\n", st.n_inputs, output_prefix,
+               st.per_output, opts->sort ? ", sorted" : "", opts->dedup ? ", deduplicated" : "");
+    }
+
+    uint8_t *batch = (uint8_t*)mem_malloc((size_t)READ_BATCH_RECORDS * RECORD_SIZE);
+    if (opts->sort)
+    {
+        st.buf = (uint8_t*)mem_malloc((size_t)st.per_output * RECORD_SIZE);
+    }
+    if (ok && (!batch || (opts->sort && !st.buf) || (opts->dedup && !dedup_set_init(&st.seen, 65536))))
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        ok = 0;
+    }
+
+    uint64_t records_in = 0;
+    for (size_t i = 0; ok && i < st.n_inputs; i++)
+    {
+        ok = compact_input(&st, &st.inputs[i], batch);
+        records_in += st.inputs[i].records;
+    }
+    if (ok && st.buf)
+    {
+        ok = flush_sorted(&st);
+    }
+    if (st.writer_open)
+    {
+        ok = end_output(&st) && ok;
+    }
+
+    size_t manifest_size = strlen(output_prefix) + sizeof(COMPACT_MANIFEST_SUFFIX);
+    char *manifest = (char*)mem_malloc(manifest_size);
+    int manifest_attempted = 0;
+    if (manifest)
+    {
+        snprintf(manifest, manifest_size, "%s%s", output_prefix, COMPACT_MANIFEST_SUFFIX);
+    }
+    if (ok && manifest)
+    {
+        manifest_attempted = 1;
+        ok = write_manifest(&st, manifest);
+    }
+    else if (ok)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        ok = 0;
+    }
+    if (ok)
+    {
+        printf("SUCCESS: Compacted %llu records from %zu files into %zu files (%llu duplicates dropped), manifest %s\n",
+               (unsigned long long)records_in, st.n_inputs, st.n_outputs,
+               (unsigned long long)st.duplicates, manifest);
+    }
+    else
+    {
+        // Leave no partial compaction behind. A manifest from an earlier run
+        // is stale as soon as one of its outputs has been overwritten.
+        for (size_t i = 0; i < st.n_outputs; i++)
+        {
+            remove(st.outputs[i].path);
+        }
+        if (manifest && (manifest_attempted || st.n_outputs > 0))
+        {
+            remove(manifest);
+        }
+    }
+
+    mem_free(manifest);
+    mem_free(batch);
+    mem_free(st.buf);
+    dedup_set_free(&st.seen);
+    for (size_t i = 0; i < st.n_inputs; i++)
+    {
+        mem_free(st.inputs[i].path);
+    }
+    for (size_t i = 0; i < st.n_outputs; i++)
+    {
+        mem_free(st.outputs[i].path);
+    }
+    mem_free(st.inputs);
+    mem_free(st.outputs);
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,753 @@
+/**
+ * @file record_partition.c
+ * @brief Partitioned conversion implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "record_partition.h"
+#include "worker_pool.h"
+#include "dedup.h"
+#include "mem_track.h"
+#include "util.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define PROGRESS(...) do { if (!opts->quiet) printf(__VA_ARGS__); } while (0)
+#define PARTITION_PATH_SIZE 4096
+#define NO_PART UINT32_MAX
+
+/*********************
+ *      STRUCTS
+ *********************/
+
+/* One output file. The last record is held back until the next one (or
+ * the end) shows whether it needs a trailing comma. */
+typedef struct {
+    uint64_t key;
+    FILE *f;                    // NULL while evicted
+    char *buf;                  // stdio buffer while open
+    long count_offset;
+    uint32_t records;
+    uint32_t lru_prev;
+    uint32_t lru_next;
+    uint16_t pending_invalid;
+    weather_record_t pending;
+    derived_metrics_t pending_derived;
+} partition_t;
+
+typedef struct {
+    const parse_options_t *opts;
+    const char *output_dir;
+    partition_key_t by;
+    file_header_t header;
+
+    partition_t *parts;
+    uint32_t n_parts;
+    uint32_t cap_parts;
+    uint32_t *slots;            // Partition index + 1, 0 = empty
+    size_t slot_mask;
+
+    uint32_t lru_head;          // Most recently used open partition
+    uint32_t lru_tail;
+    size_t n_open;
+    size_t max_open;
+    char *spare_buf;            // Buffer of the last closed handle
+    char last_dir[PARTITION_PATH_SIZE];
+
+    iso_time_cache_t times;
+    uint64_t reopens;
+    uint64_t bytes_written;
+    int failed;
+} partition_writer_t;
+
+/* A batch slice for one writer; n == 0 asks it to finish its files */
+typedef struct {
+    uint32_t n;
+    weather_record_t *records;
+    derived_metrics_t *derived;
+    uint16_t *invalid;
+} partition_job_t;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static uint64_t key_of(partition_key_t by, const weather_record_t *record)
+{
+    switch (by)
+    {
+        case PARTITION_DAY:  return record->timestamp / 86400u;
+        case PARTITION_HOUR: return record->timestamp / 3600u;
+        default:             return record->sensor_id;
+    }
+}
+
+static void partition_path(const partition_writer_t *w, uint64_t key, char *path)
+{
+    int year;
+    unsigned month, mday;
+    switch (w->by)
+    {
+        case PARTITION_DAY:
+            civil_from_days((uint32_t)key, &year, &month, &mday);
+            snprintf(path, PARTITION_PATH_SIZE, "%s/%04d/%02u/%02u.json", w->output_dir, year, month, mday);
+            break;
+        case PARTITION_HOUR:
+            civil_from_days((uint32_t)(key / 24), &year, &month, &mday);
+            snprintf(path, PARTITION_PATH_SIZE, "%s/%04d/%02u/%02u/%02u.json", w->output_dir,
+                     year, month, mday, (unsigned)(key % 24));
+            break;
+        default:
+            snprintf(path, PARTITION_PATH_SIZE, "%s/sensors/%u.json", w->output_dir, (unsigned)key);
+            break;
+    }
+}
+
+/* mkdir -p of the first len bytes of path */
+static void make_dirs(const char *path, size_t len)
+{
+    char dir[PARTITION_PATH_SIZE];
+    memcpy(dir, path, len);
+    dir[len] = '\0';
+    for (size_t i = 1; i <= len; i++)
+    {
+        if (dir[i] == '/' || dir[i] == '\0')
+        {
+            char c = dir[i];
+            dir[i] = '\0';
+            create_output_directory(dir);
+            dir[i] = c;
+        }
+    }
+}
+
+/* Create the file's directory unless it was the last one made */
+static void make_parent_dirs(partition_writer_t *w, const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    size_t len = slash ? (size_t)(slash - path) : 0;
+    if (len == 0 || (strncmp(path, w->last_dir, len) == 0 && w->last_dir[len] == '\0'))
+    {
+        return;
+    }
+    make_dirs(path, len);
+    memcpy(w->last_dir, path, len);
+    w->last_dir[len] = '\0';
+}
+
+static uint32_t find_partition(partition_writer_t *w, uint64_t key)
+{
+    // Grow the index at half load, reinserting every partition
+    if ((size_t)(w->n_parts + 1) * 2 > w->slot_mask + 1)
+    {
+        size_t cap = (w->slot_mask + 1) * 2;
+        uint32_t *slots = (uint32_t*)mem_calloc(cap, sizeof(uint32_t));
+        if (!slots)
+        {
+            return NO_PART;
+        }
+        for (uint32_t p = 0; p < w->n_parts; p++)
+        {
+            size_t s = util_hash_slot(w->parts[p].key, cap - 1);
+            while (slots[s])
+            {
+                s = util_probe_next(s, cap - 1);
+            }
+            slots[s] = p + 1;
+        }
+        mem_free(w->slots);
+        w->slots = slots;
+        w->slot_mask = cap - 1;
+    }
+
+    size_t s = util_hash_slot(key, w->slot_mask);
+    while (w->slots[s])
+    {
+        if (w->parts[w->slots[s] - 1].key == key)
+        {
+            return w->slots[s] - 1;
+        }
+        s = util_probe_next(s, w->slot_mask);
+    }
+
+    if (w->n_parts == w->cap_parts)
+    {
+        uint32_t cap = w->cap_parts ? w->cap_parts * 2 : 64;
+        partition_t *parts = (partition_t*)mem_realloc(w->parts, (size_t)cap * sizeof(partition_t));
+        if (!parts)
+        {
+            return NO_PART;
+        }
+        w->parts = parts;
+        w->cap_parts = cap;
+    }
+    partition_t *part = &w->parts[w->n_parts];
+    memset(part, 0, sizeof(*part));
+    part->key = key;
+    part->count_offset = -1;
+    part->lru_prev = part->lru_next = NO_PART;
+    w->slots[s] = w->n_parts + 1;
+    return w->n_parts++;
+}
+
+static void lru_unlink(partition_writer_t *w, uint32_t p)
+{
+    partition_t *part = &w->parts[p];
+    if (part->lru_prev != NO_PART)
+    {
+        w->parts[part->lru_prev].lru_next = part->lru_next;
+    }
+    else
+    {
+        w->lru_head = part->lru_next;
+    }
+    if (part->lru_next != NO_PART)
+    {
+        w->parts[part->lru_next].lru_prev = part->lru_prev;
+    }
+    else
+    {
+        w->lru_tail = part->lru_prev;
+    }
+    part->lru_prev = part->lru_next = NO_PART;
+}
+
+static void lru_push_front(partition_writer_t *w, uint32_t p)
+{
+    partition_t *part = &w->parts[p];
+    part->lru_prev = NO_PART;
+    part->lru_next = w->lru_head;
+    if (w->lru_head != NO_PART)
+    {
+        w->parts[w->lru_head].lru_prev = p;
+    }
+    w->lru_head = p;
+    if (w->lru_tail == NO_PART)
+    {
+        w->lru_tail = p;
+    }
+}
+
+static void close_partition(partition_writer_t *w, uint32_t p)
+{
+    partition_t *part = &w->parts[p];
+    lru_unlink(w, p);
+    if (ferror(part->f) | fclose(part->f))
+    {
+        char path[PARTITION_PATH_SIZE];
+        partition_path(w, part->key, path);
+        fprintf(stderr, "ERROR: Failed to write '%s'\n", path);
+        __atomic_store_n(&w->failed, 1, __ATOMIC_RELAXED);
+    }
+    part->f = NULL;
+    mem_free(w->spare_buf);
+    w->spare_buf = part->buf;
+    part->buf = NULL;
+    w->n_open--;
+}
+
+/* Make the partition's file the most recently used open handle */
+static int open_partition(partition_writer_t *w, uint32_t p)
+{
+    partition_t *part = &w->parts[p];
+    if (part->f)
+    {
+        if (w->lru_head != p)
+        {
+            lru_unlink(w, p);
+            lru_push_front(w, p);
+        }
+        return 1;
+    }
+    if (w->n_open >= w->max_open)
+    {
+        close_partition(w, w->lru_tail);
+    }
+
+    char path[PARTITION_PATH_SIZE];
+    partition_path(w, part->key, path);
+    if (part->count_offset < 0)
+    {
+        make_parent_dirs(w, path);
+        part->f = fopen(path, "w");
+    }
+    else
+    {
+        part->f = fopen(path, "r+");
+        if (part->f && fseek(part->f, 0, SEEK_END) != 0)
+        {
+            fclose(part->f);
+            part->f = NULL;
+        }
+        w->reopens++;
+    }
+    if (!part->f)
+    {
+        fprintf(stderr, "ERROR: Cannot open output file '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+
+    part->buf = w->spare_buf ? w->spare_buf : (char*)mem_malloc(PARTITION_FILE_BUFFER_SIZE);
+    w->spare_buf = NULL;
+    if (part->buf)
+    {
+        setvbuf(part->f, part->buf, _IOFBF, PARTITION_FILE_BUFFER_SIZE);
+    }
+    if (part->count_offset < 0)
+    {
+        part->count_offset = write_json_header_patchable(&w->header, part->f);
+    }
+    lru_push_front(w, p);
+    w->n_open++;
+    return 1;
+}
+
+static void write_batch(partition_writer_t *w, const partition_job_t *job)
+{
+    const parse_options_t *opts = w->opts;
+    for (uint32_t i = 0; i < job->n && !w->failed; i++)
+    {
+        uint32_t p = find_partition(w, key_of(w->by, &job->records[i]));
+        if (p == NO_PART)
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            __atomic_store_n(&w->failed, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        if (!open_partition(w, p))
+        {
+            __atomic_store_n(&w->failed, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        partition_t *part = &w->parts[p];
+        if (part->records > 0)
+        {
+            write_weather_json(opts, &part->pending, &part->pending_derived, part->pending_invalid,
+                               &w->times, part->f, 0);
+        }
+        part->pending = job->records[i];
+        part->pending_derived = job->derived[i];
+        part->pending_invalid = opts->validate ? job->invalid[i] : 0;
+        part->records++;
+    }
+}
+
+/* Close every array with its held-back record and patch the counts */
+static void finish_partitions(partition_writer_t *w)
+{
+    for (uint32_t p = 0; p < w->n_parts && !w->failed; p++)
+    {
+        if (!open_partition(w, p))
+        {
+            __atomic_store_n(&w->failed, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        partition_t *part = &w->parts[p];
+        write_weather_json(w->opts, &part->pending, &part->pending_derived, part->pending_invalid,
+                           &w->times, part->f, 1);
+        write_json_footer(part->f);
+        long size = ftell(part->f);
+        w->bytes_written += size > 0 ? (uint64_t)size : 0;
+        if (patch_json_record_count(part->f, part->count_offset, part->records) != 0)
+        {
+            fprintf(stderr, "ERROR: Failed to patch record_count of partition file\n");
+            __atomic_store_n(&w->failed, 1, __ATOMIC_RELAXED);
+        }
+        close_partition(w, p);
+    }
+    while (w->lru_head != NO_PART)
+    {
+        close_partition(w, w->lru_head);
+    }
+}
+
+static void partition_job(void *job_ptr, void *worker_ctx)
+{
+    partition_job_t *job = (partition_job_t*)job_ptr;
+    partition_writer_t *w = (partition_writer_t*)worker_ctx;
+    if (job->n == 0)
+    {
+        finish_partitions(w);
+    }
+    else if (!w->failed)
+    {
+        write_batch(w, job);
+    }
+    mem_free(job);
+}
+
+/* One allocation per job: the header, then the record, derived and mask arrays */
+static partition_job_t* alloc_job(uint32_t n)
+{
+    partition_job_t *job = (partition_job_t*)mem_malloc(sizeof(partition_job_t) +
+        (size_t)n * (sizeof(weather_record_t) + sizeof(derived_metrics_t) + sizeof(uint16_t)));
+    if (job)
+    {
+        job->n = 0;
+        job->records = (weather_record_t*)(job + 1);
+        job->derived = (derived_metrics_t*)(job->records + n);
+        job->invalid = (uint16_t*)(job->derived + n);
+    }
+    return job;
+}
+
+static int any_failed(partition_writer_t *writers, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (__atomic_load_n(&writers[i].failed, __ATOMIC_RELAXED))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int partition_key_parse(const char *text, partition_key_t *key)
+{
+    if (strcmp(text, "sensor") == 0)
+    {
+        *key = PARTITION_SENSOR;
+    }
+    else if (strcmp(text, "day") == 0)
+    {
+        *key = PARTITION_DAY;
+    }
+    else if (strcmp(text, "hour") == 0)
+    {
+        *key = PARTITION_HOUR;
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Invalid partition key '%s' (expected sensor, day or hour)\n", text);
+        return 0;
+    }
+    return 1;
+}
+
+int partition_weather_file(const char *input_file, const char *output_dir, partition_key_t by,
+                           int n_writers, const parse_options_t *opts, conv_stats_t *stats)
+{
+    static const parse_options_t default_opts = { 0 };
+    if (!opts)
+    {
+        opts = &default_opts;
+    }
+    if (n_writers <= 0)
+    {
+        n_writers = worker_pool_default_threads();
+    }
+
+    uint64_t t_start = 0;
+    uint64_t t_mark = 0;
+    uint64_t anomalies_before = opts->anomaly ? rolling_stats_flagged(opts->anomaly) : 0;
+    if (stats)
+    {
+        memset(stats, 0, sizeof(*stats));
+        t_start = stats_now_ns();
+        mem_window_reset();
+    }
+
+    PROGRESS("Partitioning: %s -> %s/ by %s (%d writer%s)\n", input_file, output_dir,
+             by == PARTITION_SENSOR ? "sensor" : by == PARTITION_DAY ? "day" : "hour", n_writers,
+             n_writers == 1 ? "" : "s");
+
+    FILE *fin = fopen(input_file, "rb");
+    if (!fin)
+    {
+        fprintf(stderr, "ERROR: Cannot open input file '%s': %s\n", input_file, strerror(errno));
+        return 1;
+    }
+    file_header_t header;
+    if (!read_header(&header, fin))
+    {
+        fprintf(stderr, "ERROR: Failed to read file header\n");
+        fclose(fin);
+        return 1;
+    }
+    validate_file_size(fin, header.count);
+    if (strlen(output_dir) >= PARTITION_PATH_SIZE - 32)
+    {
+        fprintf(stderr, "ERROR: Output directory path too long\n");
+        fclose(fin);
+        return 1;
+    }
+    make_dirs(output_dir, strlen(output_dir));
+
+    parse_workspace_t local_ws = { 0 };
+    parse_workspace_t *ws = opts->workspace;
+    if (!ws)
+    {
+        ws = &local_ws;
+        if (!parse_workspace_init(ws))
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            fclose(fin);
+            return 1;
+        }
+    }
+    uint8_t *batch = ws->batch;
+    weather_record_t *records = ws->records;
+    derived_metrics_t *derived = ws->derived;
+    uint16_t *invalid = ws->invalid;
+
+    // Each writer gets its own single-threaded pool, so it owns its partitions outright
+    partition_writer_t *writers = (partition_writer_t*)mem_calloc((size_t)n_writers, sizeof(partition_writer_t));
+    worker_pool_t *pools = (worker_pool_t*)mem_calloc((size_t)n_writers, sizeof(worker_pool_t));
+    void **ctx = (void**)mem_calloc((size_t)n_writers, sizeof(void*));
+    uint32_t *counts = (uint32_t*)mem_calloc((size_t)n_writers, sizeof(uint32_t));
+    uint32_t *owner = (uint32_t*)mem_malloc(READ_BATCH_RECORDS * sizeof(uint32_t));
+    dedup_set_t seen = { 0 };
+    int n_started = 0;
+    int aborted = !writers || !pools || !ctx || !counts || !owner ||
+                  (opts->dedup && !dedup_set_init(&seen, header.count < 65536 ? header.count : 65536));
+    if (aborted)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+    }
+    for (int i = 0; !aborted && i < n_writers; i++)
+    {
+        partition_writer_t *w = &writers[i];
+        w->opts = opts;
+        w->output_dir = output_dir;
+        w->by = by;
+        w->header = header;
+        w->lru_head = w->lru_tail = NO_PART;
+        w->max_open = PARTITION_MAX_OPEN_FILES / (size_t)n_writers;
+        w->max_open = w->max_open ? w->max_open : 1;
+        ctx[i] = w;
+        if (!worker_pool_start(&pools[i], 1, PARTITION_QUEUE_DEPTH, partition_job, &ctx[i]))
+        {
+            fprintf(stderr, "ERROR: Failed to start partition writers\n");
+            aborted = 1;
+            break;
+        }
+        n_started++;
+    }
+
+    uint32_t records_processed = 0;
+    uint32_t records_written = 0;
+    uint64_t duplicates = 0;
+    while (!aborted && records_processed < header.count)
+    {
+        if (!mem_within_budget(opts->mem_budget))
+        {
+            fprintf(stderr, "ERROR: Memory budget of %zu bytes exceeded (heap %zu, peak RSS %zu)\n",
+                    opts->mem_budget, mem_live_bytes(), mem_peak_rss_bytes());
+            aborted = 1;
+            break;
+        }
+        if (any_failed(writers, n_writers))
+        {
+            aborted = 1;
+            break;
+        }
+
+        uint32_t want = header.count - records_processed;
+        if (want > READ_BATCH_RECORDS)
+        {
+            want = READ_BATCH_RECORDS;
+        }
+        if (stats)
+        {
+            t_mark = stats_now_ns();
+        }
+        size_t bytes = fread(batch, 1, (size_t)want * RECORD_SIZE, fin);
+        uint32_t got = (uint32_t)(bytes / RECORD_SIZE);
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_READ, &t_mark);
+            stats->bytes_read += bytes;
+            stats->short_reads += got < want;
+        }
+
+        uint32_t kept = got;
+        if (opts->dedup)
+        {
+            kept = 0;
+            for (uint32_t i = 0; i < got; i++)
+            {
+                const uint8_t *rec = batch + (size_t)i * RECORD_SIZE;
+                int fresh = dedup_set_insert(&seen, record_key_packed(rec));
+                if (fresh < 0)
+                {
+                    fprintf(stderr, "ERROR: Out of memory in dedup set\n");
+                    aborted = 1;
+                    break;
+                }
+                if (fresh == 0)
+                {
+                    duplicates++;
+                    continue;
+                }
+                if (kept != i)
+                {
+                    memcpy(batch + (size_t)kept * RECORD_SIZE, rec, RECORD_SIZE);
+                }
+                kept++;
+            }
+            if (aborted)
+            {
+                break;
+            }
+        }
+        decode_weather_batch(records, batch, kept);
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_DECODE, &t_mark);
+        }
+        if (opts->validate)
+        {
+            kept = (uint32_t)validate_weather_records(opts, records, invalid, kept, stats);
+            if (stats)
+            {
+                conv_stats_end_stage(stats, STAGE_VALIDATE, &t_mark);
+            }
+        }
+        if (analyze_enabled(opts))
+        {
+            if (!analyze_weather_batch(opts, records, derived, kept, records_written))
+            {
+                aborted = 1;
+                break;
+            }
+            if (stats)
+            {
+                conv_stats_end_stage(stats, STAGE_ANALYZE, &t_mark);
+            }
+        }
+
+        // Route: count per owner, then copy each owner's records into its job
+        memset(counts, 0, (size_t)n_writers * sizeof(uint32_t));
+        for (uint32_t i = 0; i < kept; i++)
+        {
+            owner[i] = (uint32_t)(util_hash(key_of(by, &records[i])) % (uint64_t)n_writers);
+            counts[owner[i]]++;
+        }
+        for (int o = 0; o < n_writers && !aborted; o++)
+        {
+            if (counts[o] == 0)
+            {
+                continue;
+            }
+            partition_job_t *job = alloc_job(counts[o]);
+            if (!job)
+            {
+                fprintf(stderr, "ERROR: Out of memory\n");
+                aborted = 1;
+                break;
+            }
+            for (uint32_t i = 0; i < kept; i++)
+            {
+                if (owner[i] == (uint32_t)o)
+                {
+                    job->records[job->n] = records[i];
+                    job->derived[job->n] = derived[i];
+                    job->invalid[job->n] = opts->validate ? invalid[i] : 0;
+                    job->n++;
+                }
+            }
+            if (!worker_pool_submit(&pools[o], job))
+            {
+                fprintf(stderr, "ERROR: Partition writer %d stopped\n", o);
+                mem_free(job);
+                aborted = 1;
+                break;
+            }
+        }
+        records_written += kept;
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_WRITE, &t_mark);
+        }
+        records_processed += got;
+
+        if (got < want)
+        {
+            fprintf(stderr, "ERROR: Failed to read record %u\n", records_processed + 1);
+            break;
+        }
+    }
+
+    // Finish the files on every writer in parallel, then drain and join
+    for (int i = 0; i < n_started; i++)
+    {
+        partition_job_t *finish = alloc_job(0);
+        if (!aborted && finish && worker_pool_submit(&pools[i], finish))
+        {
+            continue;
+        }
+        mem_free(finish);
+        aborted = 1;
+    }
+    size_t n_parts = 0;
+    uint64_t reopens = 0;
+    uint64_t bytes_written = 0;
+    for (int i = 0; i < n_started; i++)
+    {
+        partition_writer_t *w = &writers[i];
+        worker_pool_stop(&pools[i]);
+        aborted |= w->failed;
+        n_parts += w->n_parts;
+        reopens += w->reopens;
+        bytes_written += w->bytes_written;
+        while (w->lru_head != NO_PART)
+        {
+            close_partition(w, w->lru_head);
+        }
+        mem_free(w->spare_buf);
+        mem_free(w->parts);
+        mem_free(w->slots);
+    }
+
+    if (stats)
+    {
+        stats->bytes_read += HEADER_SIZE;
+        stats->bytes_written = bytes_written;
+        stats->records = records_processed;
+        stats->duplicates = duplicates;
+        stats->heap_peak_bytes = mem_peak_bytes();
+        stats->anomalies = opts->anomaly ? rolling_stats_flagged(opts->anomaly) - anomalies_before : 0;
+    }
+    if (opts->dedup)
+    {
+        PROGRESS("Dedup: dropped %llu duplicate records, wrote %u\n",
+                 (unsigned long long)duplicates, records_written);
+    }
+
+    dedup_set_free(&seen);
+    mem_free(owner);
+    mem_free(counts);
+    mem_free(ctx);
+    mem_free(pools);
+    mem_free(writers);
+    fclose(fin);
+    parse_workspace_free(&local_ws);
+
+    if (stats)
+    {
+        stats->total_ns = stats_now_ns() - t_start;
+        stats->rss_peak_bytes = mem_peak_rss_bytes();
+    }
+    if (aborted)
+    {
+        return 1;
+    }
+    if (records_processed != header.count)
+    {
+        PROGRESS("WARNING: Only processed %u out of %u records\n", records_processed, header.count);
+        return 1;
+    }
+    PROGRESS("SUCCESS: Wrote %u records to %zu partitions under %s (%llu reopens)\n",
+             records_written, n_parts, output_dir, (unsigned long long)reopens);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,369 @@
+/**
+ * @file record_sample.c
+ * @brief Stride and reservoir sampling implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#ifndef _WIN32
+  #define _FILE_OFFSET_BITS 64
+  #define _POSIX_C_SOURCE 200809L
+#endif
+#include "record_sample.h"
+#include "json_writer.h"
+#include "mem_track.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define PROGRESS(...) do { if (!opts->quiet) printf(__VA_ARGS__); } while (0)
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* Uniform double in (0, 1), never 0 so its log is finite */
+static double random_open01(uint64_t *state)
+{
+    return ((double)(splitmix64(state) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+/* Seek to a record; long is 32 bits on Windows, so plain fseek fails past 2 GB there */
+static int seek_record(FILE *f, int64_t ordinal)
+{
+    int64_t offset = (int64_t)HEADER_SIZE + ordinal * RECORD_SIZE;
+#ifdef _WIN32
+    return _fseeki64(f, offset, SEEK_SET);
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Draw k of the ordinals 0..count-1 uniformly, sorted ascending
+ * 
+ * Algorithm L jumps straight to the next replaced ordinal, so only
+ * O(k * (1 + log(count / k))) random numbers are drawn.
+ */
+static uint32_t* reservoir_ordinals(uint32_t count, uint32_t k, uint64_t seed)
+{
+    uint32_t *res = (uint32_t*)mem_malloc((size_t)k * sizeof(uint32_t));
+    if (!res)
+    {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < k; i++)
+    {
+        res[i] = i;
+    }
+    uint64_t state = seed;
+    double w = exp(log(random_open01(&state)) / k);
+    double i = (double)k - 1.0;
+    for (;;)
+    {
+        i += floor(log(random_open01(&state)) / log1p(-w)) + 1.0;
+        if (!(i < (double)count))
+        {
+            break;
+        }
+        res[splitmix64(&state) % k] = (uint32_t)i;
+        w *= exp(log(random_open01(&state)) / k);
+    }
+    qsort(res, k, sizeof(uint32_t), compare_u32);
+    return res;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int sample_spec_parse(const char *text, sample_spec_t *spec)
+{
+    memset(spec, 0, sizeof(*spec));
+    spec->seed = SAMPLE_DEFAULT_SEED;
+    const char *arg;
+    if (strncmp(text, "stride:", 7) == 0)
+    {
+        spec->mode = SAMPLE_STRIDE;
+        arg = text + 7;
+    }
+    else if (strncmp(text, "reservoir:", 10) == 0)
+    {
+        spec->mode = SAMPLE_RESERVOIR;
+        arg = text + 10;
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Invalid sample '%s' (expected stride:N or reservoir:K[:SEED])\n", text);
+        return 0;
+    }
+
+    char *end = NULL;
+    unsigned long long n = strtoull(arg, &end, 10);
+    if (end == arg || n == 0 || n > UINT32_MAX)
+    {
+        fprintf(stderr, "ERROR: Invalid sample size in '%s'\n", text);
+        return 0;
+    }
+    spec->n = (uint32_t)n;
+    if (spec->mode == SAMPLE_RESERVOIR && *end == ':' && end[1] != '\0')
+    {
+        spec->seed = strtoull(end + 1, &end, 0);
+    }
+    if (*end != '\0')
+    {
+        fprintf(stderr, "ERROR: Invalid sample '%s' (expected stride:N or reservoir:K[:SEED])\n", text);
+        return 0;
+    }
+    return 1;
+}
+
+int sample_weather_file(const char *input_file, const char *output_file, const sample_spec_t *spec,
+                        const parse_options_t *opts, conv_stats_t *stats)
+{
+    static const parse_options_t default_opts = { 0 };
+    if (!opts)
+    {
+        opts = &default_opts;
+    }
+
+    uint64_t t_start = 0;
+    uint64_t t_mark = 0;
+    uint64_t anomalies_before = opts->anomaly ? rolling_stats_flagged(opts->anomaly) : 0;
+    if (stats)
+    {
+        memset(stats, 0, sizeof(*stats));
+        t_start = stats_now_ns();
+        mem_window_reset();
+    }
+
+    PROGRESS("Sampling: %s -> %s\n", input_file, output_file);
+
+    FILE *fin = fopen(input_file, "rb");
+    if (!fin)
+    {
+        fprintf(stderr, "ERROR: Cannot open input file '%s': %s\n", input_file, strerror(errno));
+        return 1;
+    }
+    file_header_t header;
+    if (!read_header(&header, fin))
+    {
+        fprintf(stderr, "ERROR: Failed to read file header\n");
+        fclose(fin);
+        return 1;
+    }
+    validate_file_size(fin, header.count);
+
+    // Pick the ordinals; stride ones are computed on the fly
+    uint32_t total;
+    uint32_t *ordinals = NULL;
+    if (spec->mode == SAMPLE_STRIDE)
+    {
+        total = header.count / spec->n + (header.count % spec->n != 0);
+    }
+    else
+    {
+        total = spec->n < header.count ? spec->n : header.count;
+        ordinals = total > 0 ? reservoir_ordinals(header.count, total, spec->seed) : NULL;
+        if (total > 0 && !ordinals)
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            fclose(fin);
+            return 1;
+        }
+    }
+    PROGRESS("Sample: %u of %u records\n", total, header.count);
+
+    create_output_directory("data");
+    FILE *fout = fopen(output_file, "w");
+    if (!fout)
+    {
+        fprintf(stderr, "ERROR: Cannot open output file '%s': %s\n", output_file, strerror(errno));
+        mem_free(ordinals);
+        fclose(fin);
+        return 1;
+    }
+
+    parse_workspace_t local_ws = { 0 };
+    parse_workspace_t *ws = opts->workspace;
+    if (!ws)
+    {
+        ws = &local_ws;
+        if (!parse_workspace_init(ws))
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            mem_free(ordinals);
+            fclose(fin);
+            fclose(fout);
+            return 1;
+        }
+    }
+    uint8_t *batch = ws->batch;
+    weather_record_t *records = ws->records;
+    derived_metrics_t *derived = ws->derived;
+    uint16_t *invalid = ws->invalid;
+    setvbuf(fout, ws->out_buf, _IOFBF, PARSE_OUTPUT_BUFFER_SIZE);
+
+    long count_offset = write_json_header_patchable(&header, fout);
+
+    // Gather a batch with one seek per record (none for adjacent ones), then
+    // run it through the usual stages. The last written record is held back
+    // so it can close the array.
+    uint32_t picked = 0;
+    uint32_t records_written = 0;
+    int64_t next_pos = -1;
+    weather_record_t pending;
+    derived_metrics_t pending_derived;
+    uint16_t pending_invalid = 0;
+    iso_time_cache_t times = { 0 };
+    int has_pending = 0;
+    int failed = 0;
+    while (picked < total && !failed)
+    {
+        uint32_t want = total - picked;
+        if (want > READ_BATCH_RECORDS)
+        {
+            want = READ_BATCH_RECORDS;
+        }
+        if (stats)
+        {
+            t_mark = stats_now_ns();
+        }
+        uint32_t got = 0;
+        for (; got < want; got++)
+        {
+            uint32_t i = picked + got;
+            int64_t ordinal = ordinals ? ordinals[i] : (int64_t)i * spec->n;
+            if (ordinal != next_pos &&
+                seek_record(fin, ordinal) != 0)
+            {
+                break;
+            }
+            if (fread(batch + (size_t)got * RECORD_SIZE, RECORD_SIZE, 1, fin) != 1)
+            {
+                break;
+            }
+            next_pos = ordinal + 1;
+        }
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_READ, &t_mark);
+            stats->bytes_read += (uint64_t)got * RECORD_SIZE;
+            stats->short_reads += got < want;
+        }
+        if (got < want)
+        {
+            fprintf(stderr, "ERROR: Failed to read sampled record %u\n", picked + got + 1);
+            failed = 1;
+        }
+
+        decode_weather_batch(records, batch, got);
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_DECODE, &t_mark);
+        }
+        uint32_t kept = got;
+        if (opts->validate)
+        {
+            kept = (uint32_t)validate_weather_records(opts, records, invalid, kept, stats);
+            if (stats)
+            {
+                conv_stats_end_stage(stats, STAGE_VALIDATE, &t_mark);
+            }
+        }
+        if (analyze_enabled(opts))
+        {
+            if (!analyze_weather_batch(opts, records, derived, kept, records_written))
+            {
+                failed = 1;
+                break;
+            }
+            if (stats)
+            {
+                conv_stats_end_stage(stats, STAGE_ANALYZE, &t_mark);
+            }
+        }
+        if (kept > 0)
+        {
+            if (has_pending)
+            {
+                write_weather_json(opts, &pending, &pending_derived, pending_invalid, &times, fout, 0);
+            }
+            for (uint32_t i = 0; i + 1 < kept; i++)
+            {
+                write_weather_json(opts, &records[i], &derived[i], opts->validate ? invalid[i] : 0, &times, fout, 0);
+            }
+            pending = records[kept - 1];
+            pending_derived = derived[kept - 1];
+            pending_invalid = opts->validate ? invalid[kept - 1] : 0;
+            has_pending = 1;
+            records_written += kept;
+        }
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_WRITE, &t_mark);
+        }
+        picked += got;
+    }
+
+    if (has_pending)
+    {
+        write_weather_json(opts, &pending, &pending_derived, pending_invalid, &times, fout, 1);
+    }
+    write_json_footer(fout);
+    if (patch_json_record_count(fout, count_offset, records_written) != 0)
+    {
+        fprintf(stderr, "WARNING: Output is not seekable, record_count left at %u\n", header.count);
+    }
+    if (ferror(fout))
+    {
+        fprintf(stderr, "ERROR: Failed to write '%s'\n", output_file);
+        failed = 1;
+    }
+
+    if (stats)
+    {
+        long out_size = ftell(fout);
+        stats->bytes_read += HEADER_SIZE;
+        stats->bytes_written = out_size > 0 ? (uint64_t)out_size : 0;
+        stats->records = picked;
+        stats->heap_peak_bytes = mem_peak_bytes();
+        stats->anomalies = opts->anomaly ? rolling_stats_flagged(opts->anomaly) - anomalies_before : 0;
+    }
+
+    mem_free(ordinals);
+    fclose(fin);
+    fclose(fout);
+    parse_workspace_free(&local_ws);
+
+    if (stats)
+    {
+        stats->total_ns = stats_now_ns() - t_start;
+        stats->rss_peak_bytes = mem_peak_rss_bytes();
+    }
+    if (failed)
+    {
+        return 1;
+    }
+    PROGRESS("SUCCESS: Wrote %u sampled records to JSON format\n", records_written);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,548 @@
+/**
+ * @file record_sort.c
+ * @brief External merge sort implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "record_sort.h"
+#include "weather_parser.h"
+#include "bin_writer.h"
+#include "mem_track.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SOURCE_BUFFER_RECORDS 1024
+// Run memory per record: packed input + permuted copy + two key/index arrays
+#define SORT_BYTES_PER_RECORD (2 * RECORD_SIZE + 2 * sizeof(sort_entry_t))
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    uint64_t key;
+    uint32_t index;
+} sort_entry_t;
+
+/**
+ * @brief One sorted input of the merge (temp run or input file)
+ */
+typedef struct {
+    FILE *f;
+    const char *name;       // For messages, NULL for temp runs
+    uint8_t *buf;
+    uint32_t buf_count;
+    uint32_t buf_pos;
+    uint64_t remaining;     // Records not yet loaded into buf
+    record_sort_key_fn key_fn;
+    const void *key_ctx;
+    uint64_t key;
+    uint64_t last_key;
+    int done;
+    int unsorted_reported;
+} merge_source_t;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static inline uint64_t sort_key(record_sort_key_fn key_fn, const void *key_ctx, const uint8_t *packed)
+{
+    return key_fn ? key_fn(packed, key_ctx) : record_key_packed(packed);
+}
+
+static void radix_sort_entries(sort_entry_t *a, sort_entry_t *tmp, size_t n)
+{
+    size_t counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t k = a[i].key;
+        for (int b = 0; b < 8; b++)
+        {
+            counts[b][(k >> (8 * b)) & 0xFF]++;
+        }
+    }
+
+    for (int b = 0; b < 8; b++)
+    {
+        // All keys share this byte: the pass would not move anything
+        if (counts[b][(a[0].key >> (8 * b)) & 0xFF] == n)
+        {
+            continue;
+        }
+        size_t offset = 0;
+        for (int d = 0; d < 256; d++)
+        {
+            size_t c = counts[b][d];
+            counts[b][d] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            tmp[counts[b][(a[i].key >> (8 * b)) & 0xFF]++] = a[i];
+        }
+        memcpy(a, tmp, n * sizeof(sort_entry_t));
+    }
+}
+
+static int source_fill(merge_source_t *s)
+{
+    uint32_t want = s->remaining < SOURCE_BUFFER_RECORDS ? (uint32_t)s->remaining : SOURCE_BUFFER_RECORDS;
+    uint32_t got = want ? (uint32_t)(fread(s->buf, 1, (size_t)want * RECORD_SIZE, s->f) / RECORD_SIZE) : 0;
+    s->remaining = (got < want) ? 0 : s->remaining - got;
+    s->buf_count = got;
+    s->buf_pos = 0;
+    return got > 0;
+}
+
+// Loads the key of the current record, or marks the source done
+static void source_load_key(merge_source_t *s)
+{
+    if (s->buf_pos >= s->buf_count && !source_fill(s))
+    {
+        s->done = 1;
+        return;
+    }
+    s->last_key = s->key;
+    s->key = sort_key(s->key_fn, s->key_ctx, s->buf + (size_t)s->buf_pos * RECORD_SIZE);
+    if (s->key < s->last_key && s->name && !s->unsorted_reported)
+    {
+        fprintf(stderr, "WARNING: '%s' is not sorted by (sensor_id, timestamp)\n", s->name);
+        s->unsorted_reported = 1;
+    }
+}
+
+// a beats b: smaller key, ties go to the lower source index (stable)
+static int source_beats(const merge_source_t *src, int k, int a, int b)
+{
+    if (a == k) return 1;   // Sentinel used while building the tree
+    if (b == k) return 0;
+    if (src[a].done) return 0;
+    if (src[b].done) return 1;
+    if (src[a].key != src[b].key) return src[a].key < src[b].key;
+    return a < b;
+}
+
+static void loser_tree_adjust(int *tree, const merge_source_t *src, int k, int s)
+{
+    for (int t = (s + k) / 2; t > 0; t /= 2)
+    {
+        if (source_beats(src, k, tree[t], s))
+        {
+            int tmp = s;
+            s = tree[t];
+            tree[t] = tmp;
+        }
+    }
+    tree[0] = s;
+}
+
+static int merge_sources(merge_source_t *src, int k, bin_writer_t *w)
+{
+    int tree[SORT_MAX_FANIN] = { 0 };  // Zeroed so -O2 can see no node is read unset
+    for (int i = 0; i < k; i++)
+    {
+        source_load_key(&src[i]);
+        src[i].last_key = 0;
+        tree[i] = k;
+    }
+    for (int i = k - 1; i >= 0; i--)
+    {
+        loser_tree_adjust(tree, src, k, i);
+    }
+
+    for (;;)
+    {
+        int win = tree[0];
+        merge_source_t *s = &src[win];
+        if (s->done)
+        {
+            break;
+        }
+        if (!bin_writer_write_packed(w, s->buf + (size_t)s->buf_pos * RECORD_SIZE))
+        {
+            return 0;
+        }
+        s->buf_pos++;
+        source_load_key(s);
+        loser_tree_adjust(tree, src, k, win);
+    }
+    return 1;
+}
+
+static void sources_free(merge_source_t *src, int k)
+{
+    for (int i = 0; i < k; i++)
+    {
+        if (src[i].f)
+        {
+            fclose(src[i].f);
+        }
+        mem_free(src[i].buf);
+    }
+    mem_free(src);
+}
+
+static merge_source_t* sources_alloc(int k, record_sort_key_fn key_fn, const void *key_ctx)
+{
+    merge_source_t *src = (merge_source_t*)mem_calloc((size_t)k, sizeof(merge_source_t));
+    if (!src)
+    {
+        return NULL;
+    }
+    for (int i = 0; i < k; i++)
+    {
+        src[i].key_fn = key_fn;
+        src[i].key_ctx = key_ctx;
+        src[i].buf = (uint8_t*)mem_malloc((size_t)SOURCE_BUFFER_RECORDS * RECORD_SIZE);
+        if (!src[i].buf)
+        {
+            sources_free(src, k);
+            return NULL;
+        }
+    }
+    return src;
+}
+
+// Merges k temp runs into one new temp run; the input runs are closed
+static FILE* merge_runs_to_temp(FILE **runs, const uint64_t *sizes, int k, uint64_t *out_size,
+                                record_sort_key_fn key_fn, const void *key_ctx)
+{
+    FILE *out = tmpfile();
+    merge_source_t *src = sources_alloc(k, key_fn, key_ctx);
+    bin_writer_t w;
+    if (!out || !src || !bin_writer_attach(&w, out))
+    {
+        if (out) fclose(out);
+        if (src) sources_free(src, k);
+        for (int i = 0; i < k; i++)
+        {
+            fclose(runs[i]);
+        }
+        return NULL;
+    }
+
+    for (int i = 0; i < k; i++)
+    {
+        src[i].f = runs[i];
+        src[i].remaining = sizes[i];
+        rewind(runs[i]);
+    }
+
+    int ok = merge_sources(src, k, &w);
+    *out_size = w.header.count;
+    ok = bin_writer_close(&w) && ok;
+    sources_free(src, k);
+    if (!ok)
+    {
+        fclose(out);
+        return NULL;
+    }
+    return out;
+}
+
+static int sort_packed_by(uint8_t *records, size_t n, record_sort_key_fn key_fn, const void *key_ctx)
+{
+    if (n < 2)
+    {
+        return 1;
+    }
+    sort_entry_t *entries = (sort_entry_t*)mem_malloc(n * sizeof(sort_entry_t));
+    sort_entry_t *tmp = (sort_entry_t*)mem_malloc(n * sizeof(sort_entry_t));
+    uint8_t *sorted = (uint8_t*)mem_malloc(n * RECORD_SIZE);
+    if (!entries || !tmp || !sorted)
+    {
+        mem_free(entries);
+        mem_free(tmp);
+        mem_free(sorted);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        entries[i].key = sort_key(key_fn, key_ctx, records + i * RECORD_SIZE);
+        entries[i].index = (uint32_t)i;
+    }
+    radix_sort_entries(entries, tmp, n);
+    for (size_t i = 0; i < n; i++)
+    {
+        memcpy(sorted + i * RECORD_SIZE, records + (size_t)entries[i].index * RECORD_SIZE, RECORD_SIZE);
+    }
+    memcpy(records, sorted, n * RECORD_SIZE);
+
+    mem_free(entries);
+    mem_free(tmp);
+    mem_free(sorted);
+    return 1;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int sort_packed_records(uint8_t *records, size_t n)
+{
+    return sort_packed_by(records, n, NULL, NULL);
+}
+
+int sort_weather_file(const char *input_file, const char *output_file, size_t mem_limit)
+{
+    printf("Sorting: %s -> %s\n", input_file, output_file);
+    uint32_t sorted = 0;
+    int rc = sort_weather_file_by(input_file, output_file, mem_limit, NULL, NULL, &sorted);
+    if (rc == 0)
+    {
+        printf("SUCCESS: Sorted %u records\n", sorted);
+    }
+    return rc;
+}
+
+int sort_weather_file_by(const char *input_file, const char *output_file, size_t mem_limit,
+                         record_sort_key_fn key_fn, const void *key_ctx, uint32_t *sorted_count)
+{
+    FILE *fin = fopen(input_file, "rb");
+    if (!fin)
+    {
+        fprintf(stderr, "ERROR: Cannot open input file '%s': %s\n", input_file, strerror(errno));
+        return 1;
+    }
+    file_header_t header;
+    if (!read_header(&header, fin))
+    {
+        fprintf(stderr, "ERROR: Failed to read file header\n");
+        fclose(fin);
+        return 1;
+    }
+    validate_file_size(fin, header.count);
+
+    if (mem_limit == 0)
+    {
+        mem_limit = SORT_DEFAULT_MEM_LIMIT;
+    }
+    size_t run_records = mem_limit / SORT_BYTES_PER_RECORD;
+    if (run_records < SOURCE_BUFFER_RECORDS)
+    {
+        run_records = SOURCE_BUFFER_RECORDS;
+    }
+    if (run_records > header.count)
+    {
+        run_records = header.count ? header.count : 1;
+    }
+
+    uint8_t *run = (uint8_t*)mem_malloc(run_records * RECORD_SIZE);
+    FILE **runs = (FILE**)mem_calloc(((size_t)header.count + run_records - 1) / run_records + 1, sizeof(FILE*));
+    uint64_t *run_sizes = (uint64_t*)mem_calloc(((size_t)header.count + run_records - 1) / run_records + 1, sizeof(uint64_t));
+    int n_runs = 0;
+    int rc = 1;
+    bin_writer_t w;
+    int writer_open = 0;
+
+    if (!run || !runs || !run_sizes)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        goto cleanup;
+    }
+
+    // Phase 1: sorted runs
+    uint64_t remaining = header.count;
+    while (remaining > 0)
+    {
+        size_t want = remaining < run_records ? (size_t)remaining : run_records;
+        size_t got = fread(run, 1, want * RECORD_SIZE, fin) / RECORD_SIZE;
+        if (got == 0)
+        {
+            break;
+        }
+        if (!sort_packed_by(run, got, key_fn, key_ctx))
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            goto cleanup;
+        }
+
+        // Single run covering the whole file: no spill needed
+        if (n_runs == 0 && got == remaining)
+        {
+            if (!bin_writer_open(&w, output_file, &header))
+            {
+                goto cleanup;
+            }
+            writer_open = 1;
+            for (size_t i = 0; i < got; i++)
+            {
+                if (!bin_writer_write_packed(&w, run + i * RECORD_SIZE))
+                {
+                    break;  // Reported when the writer is closed
+                }
+            }
+            remaining = 0;
+            break;
+        }
+
+        FILE *tmp = tmpfile();
+        if (!tmp || fwrite(run, 1, got * RECORD_SIZE, tmp) != got * RECORD_SIZE)
+        {
+            fprintf(stderr, "ERROR: Failed to write sort run\n");
+            if (tmp) fclose(tmp);
+            goto cleanup;
+        }
+        runs[n_runs] = tmp;
+        run_sizes[n_runs] = got;
+        n_runs++;
+        remaining -= got;
+        if (got < want)
+        {
+            break;
+        }
+    }
+    if (remaining > 0)
+    {
+        fprintf(stderr, "WARNING: Input ended early, sorting the records that were read\n");
+    }
+    mem_free(run);
+    run = NULL;
+
+    if (!writer_open && n_runs > 0)
+    {
+        printf("Sort: merging %d runs of up to %zu records\n", n_runs, run_records);
+
+        // Phase 2: reduce the run count until one merge can take them all
+        while (n_runs > SORT_MAX_FANIN)
+        {
+            int merged = 0;
+            for (int i = 0; i < n_runs; i += SORT_MAX_FANIN)
+            {
+                int k = (n_runs - i < SORT_MAX_FANIN) ? n_runs - i : SORT_MAX_FANIN;
+                uint64_t size;
+                FILE *out = merge_runs_to_temp(&runs[i], &run_sizes[i], k, &size, key_fn, key_ctx);
+                for (int j = i; j < i + k; j++)
+                {
+                    runs[j] = NULL;
+                }
+                if (!out)
+                {
+                    fprintf(stderr, "ERROR: Intermediate merge failed\n");
+                    n_runs = 0;
+                    goto cleanup;
+                }
+                runs[merged] = out;
+                run_sizes[merged] = size;
+                merged++;
+            }
+            n_runs = merged;
+        }
+
+        // Phase 3: final merge into the output file
+        merge_source_t *src = sources_alloc(n_runs, key_fn, key_ctx);
+        if (!src || !bin_writer_open(&w, output_file, &header))
+        {
+            if (src) sources_free(src, n_runs);
+            goto cleanup;
+        }
+        writer_open = 1;
+        for (int i = 0; i < n_runs; i++)
+        {
+            src[i].f = runs[i];
+            src[i].remaining = run_sizes[i];
+            rewind(runs[i]);
+            runs[i] = NULL;
+        }
+        int ok = merge_sources(src, n_runs, &w);
+        sources_free(src, n_runs);
+        if (!ok)
+        {
+            goto cleanup;
+        }
+    }
+    else if (!writer_open)
+    {
+        // Empty input: write an empty output file
+        if (!bin_writer_open(&w, output_file, &header))
+        {
+            goto cleanup;
+        }
+        writer_open = 1;
+    }
+    rc = 0;
+
+cleanup:
+    if (writer_open && !bin_writer_close(&w))
+    {
+        fprintf(stderr, "ERROR: Failed to write '%s'\n", output_file);
+        rc = 1;
+    }
+    if (rc == 0 && sorted_count)
+    {
+        *sorted_count = w.header.count;
+    }
+    for (int i = 0; runs && i < n_runs; i++)
+    {
+        if (runs[i])
+        {
+            fclose(runs[i]);
+        }
+    }
+    mem_free(runs);
+    mem_free(run_sizes);
+    mem_free(run);
+    fclose(fin);
+    return rc;
+}
+
+int merge_weather_files(const char **input_files, int n_inputs, const char *output_file)
+{
+    if (n_inputs < 1 || n_inputs > SORT_MAX_FANIN)
+    {
+        fprintf(stderr, "ERROR: Can merge 1 to %d files, got %d\n", SORT_MAX_FANIN, n_inputs);
+        return 1;
+    }
+    printf("Merging %d files -> %s\n", n_inputs, output_file);
+
+    merge_source_t *src = sources_alloc(n_inputs, NULL, NULL);
+    if (!src)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+
+    file_header_t out_header;
+    for (int i = 0; i < n_inputs; i++)
+    {
+        file_header_t header;
+        src[i].name = input_files[i];
+        src[i].f = fopen(input_files[i], "rb");
+        if (!src[i].f || !read_header(&header, src[i].f))
+        {
+            fprintf(stderr, "ERROR: Cannot read input file '%s'\n", input_files[i]);
+            sources_free(src, n_inputs);
+            return 1;
+        }
+        validate_file_size(src[i].f, header.count);
+        src[i].remaining = header.count;
+        if (i == 0)
+        {
+            out_header = header;
+        }
+    }
+
+    bin_writer_t w;
+    if (!bin_writer_open(&w, output_file, &out_header))
+    {
+        sources_free(src, n_inputs);
+        return 1;
+    }
+    int ok = merge_sources(src, n_inputs, &w);
+    sources_free(src, n_inputs);
+    ok = bin_writer_close(&w) && ok;
+
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Failed to write '%s'\n", output_file);
+        return 1;
+    }
+    printf("SUCCESS: Merged %u records\n", w.header.count);
+    return 0;
+}
\ No newline at end of file
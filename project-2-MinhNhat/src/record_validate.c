@@ -0,0 +1,529 @@
+/**
+ * @file record_validate.c
+ * @brief Record validation implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "record_validate.h"
+#include "cpu_dispatch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if SIMD_X86
+  #include <immintrin.h>
+#endif
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    FIELD_U8 = 0,
+    FIELD_U16,
+    FIELD_F32,
+    FIELD_F64
+} field_kind_t;
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    const char *name;
+    size_t offset;
+    field_kind_t kind;
+    double min;
+    double max;
+} field_spec_t;
+
+/*********************
+ *      TYPEDEFS
+ *********************/
+typedef void (*validate_masks_fn)(uint16_t *masks, const uint8_t *base, size_t n,
+                                  const record_validator_t *v);
+
+/*********************
+ *  STATIC VARIABLES
+ *********************/
+
+// Indexed by validate_field_t. CO2 0xFFFF is the sensors' "no reading" value.
+static const field_spec_t field_specs[VALIDATE_FIELD_COUNT] = {
+    { "battery",     offsetof(weather_record_t, battery),     FIELD_U8,  0.0,     2.0 },
+    { "lat",         offsetof(weather_record_t, lat),         FIELD_F64, -90.0,   90.0 },
+    { "lon",         offsetof(weather_record_t, lon),         FIELD_F64, -180.0,  180.0 },
+    { "temperature", offsetof(weather_record_t, temperature), FIELD_F32, -90.0,   60.0 },
+    { "humidity",    offsetof(weather_record_t, humidity),    FIELD_F32, 0.0,     100.0 },
+    { "pressure",    offsetof(weather_record_t, pressure),    FIELD_F32, 300.0,   1100.0 },
+    { "co2",         offsetof(weather_record_t, co2),         FIELD_U16, 0.0,     40000.0 },
+    { "wind_speed",  offsetof(weather_record_t, wind_speed),  FIELD_F32, 0.0,     120.0 },
+    { "wind_dir",    offsetof(weather_record_t, wind_dir),    FIELD_U16, 0.0,     360.0 },
+    { "rain",        offsetof(weather_record_t, rain),        FIELD_F32, 0.0,     500.0 },
+    { "uv",          offsetof(weather_record_t, uv),          FIELD_F32, 0.0,     20.0 },
+    { "light",       offsetof(weather_record_t, light),       FIELD_F32, 0.0,     200000.0 },
+};
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+
+/*
+ * Narrow a double range to floats without changing which float values
+ * pass: round min up and max down when they are not representable.
+ */
+static void refresh_float_bounds(record_validator_t *v, int f)
+{
+    float lo = (float)v->min[f];
+    if ((double)lo < v->min[f])
+    {
+        lo = nextafterf(lo, INFINITY);
+    }
+    float hi = (float)v->max[f];
+    if ((double)hi > v->max[f])
+    {
+        hi = nextafterf(hi, -INFINITY);
+    }
+    v->min_f[f] = lo;
+    v->max_f[f] = hi;
+}
+
+static float load_field_f32(const uint8_t *rec, const field_spec_t *spec)
+{
+    switch (spec->kind)
+    {
+        case FIELD_U8:
+            return (float)rec[spec->offset];
+        case FIELD_U16:
+        {
+            uint16_t u;
+            memcpy(&u, rec + spec->offset, sizeof(u));
+            return (float)u;
+        }
+        default:
+        {
+            float x;
+            memcpy(&x, rec + spec->offset, sizeof(x));
+            return x;
+        }
+    }
+}
+
+/*
+ * Pull one bad field back into its range. Returns 0 if the value is NaN
+ * or the missing CO2 reading and cannot be repaired: clamping 0xFFFF would
+ * invent a maximum reading that alert rules and sketches then count.
+ */
+static int clamp_field(const record_validator_t *v, weather_record_t *record, int f)
+{
+    const field_spec_t *spec = &field_specs[f];
+    uint8_t *p = (uint8_t*)record + spec->offset;
+    if (spec->kind == FIELD_F64)
+    {
+        double x;
+        memcpy(&x, p, sizeof(x));
+        if (isnan(x))
+        {
+            return 0;
+        }
+        x = x < v->min[f] ? v->min[f] : v->max[f];
+        memcpy(p, &x, sizeof(x));
+        return 1;
+    }
+
+    float x = load_field_f32(p - spec->offset, spec);
+    if (isnan(x) || (f == VALIDATE_CO2 && x == (float)0xFFFF))
+    {
+        return 0;
+    }
+    if (spec->kind == FIELD_F32)
+    {
+        x = x < v->min_f[f] ? v->min_f[f] : v->max_f[f];
+        memcpy(p, &x, sizeof(x));
+    }
+    else
+    {
+        double bound = x < v->min_f[f] ? ceil(v->min[f]) : floor(v->max[f]);
+        if (spec->kind == FIELD_U8)
+        {
+            *p = (uint8_t)bound;
+        }
+        else
+        {
+            uint16_t u = (uint16_t)bound;
+            memcpy(p, &u, sizeof(u));
+        }
+    }
+    return 1;
+}
+
+/*********************
+ *  VALIDATE KERNELS
+ *********************/
+static void validate_masks_scalar(uint16_t *masks, const uint8_t *base, size_t n,
+                                  const record_validator_t *v)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        const uint8_t *rec = base + i * sizeof(weather_record_t);
+        uint16_t m = 0;
+        for (int f = 0; f < VALIDATE_FIELD_COUNT; f++)
+        {
+            const field_spec_t *spec = &field_specs[f];
+            int ok;
+            if (spec->kind == FIELD_F64)
+            {
+                double x;
+                memcpy(&x, rec + spec->offset, sizeof(x));
+                ok = x >= v->min[f] && x <= v->max[f];
+            }
+            else
+            {
+                float x = load_field_f32(rec, spec);
+                ok = x >= v->min_f[f] && x <= v->max_f[f];
+            }
+            m |= (uint16_t)(!ok << f);
+        }
+        masks[i] = m;
+    }
+}
+
+#if SIMD_X86
+/*
+ * The vector kernels gather each field across consecutive records by
+ * byte offset. Integer fields are read as 32-bit words (the bytes after
+ * battery/co2/wind_dir are padding or the next field, masked off) and
+ * compared as floats, which is exact for 8- and 16-bit values. NGE/NLE
+ * predicates are true for NaN, so a NaN reading always fails.
+ */
+__attribute__((target("sse4.2")))
+static void validate_masks_sse42(uint16_t *masks, const uint8_t *base, size_t n,
+                                 const record_validator_t *v)
+{
+    const size_t s = sizeof(weather_record_t);
+    const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const uint8_t *r = base + i * s;
+        __m128i acc = _mm_setzero_si128();
+        for (int f = 0; f < VALIDATE_FIELD_COUNT; f++)
+        {
+            const field_spec_t *spec = &field_specs[f];
+            const uint8_t *p = r + spec->offset;
+            __m128i bad;
+            if (spec->kind == FIELD_F64)
+            {
+                const __m128d lo = _mm_set1_pd(v->min[f]);
+                const __m128d hi = _mm_set1_pd(v->max[f]);
+                __m128d a = _mm_loadh_pd(_mm_load_sd((const double*)p), (const double*)(p + s));
+                __m128d b = _mm_loadh_pd(_mm_load_sd((const double*)(p + 2 * s)), (const double*)(p + 3 * s));
+                int bits = _mm_movemask_pd(_mm_or_pd(_mm_cmpnge_pd(a, lo), _mm_cmpnle_pd(a, hi))) |
+                           (_mm_movemask_pd(_mm_or_pd(_mm_cmpnge_pd(b, lo), _mm_cmpnle_pd(b, hi))) << 2);
+                bad = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), lane_bits), lane_bits);
+            }
+            else
+            {
+                __m128 x = _mm_setr_ps(load_field_f32(r, spec), load_field_f32(r + s, spec),
+                                       load_field_f32(r + 2 * s, spec), load_field_f32(r + 3 * s, spec));
+                bad = _mm_castps_si128(_mm_or_ps(_mm_cmpnge_ps(x, _mm_set1_ps(v->min_f[f])),
+                                                 _mm_cmpnle_ps(x, _mm_set1_ps(v->max_f[f]))));
+            }
+            acc = _mm_or_si128(acc, _mm_and_si128(bad, _mm_set1_epi32(1 << f)));
+        }
+        _mm_storel_epi64((__m128i*)(masks + i), _mm_packus_epi32(acc, acc));
+    }
+    validate_masks_scalar(masks + i, base + i * s, n - i, v);
+}
+
+__attribute__((target("avx2")))
+static void validate_masks_avx2(uint16_t *masks, const uint8_t *base, size_t n,
+                                const record_validator_t *v)
+{
+    const int s = (int)sizeof(weather_record_t);
+    const __m256i idx = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    const __m128i idx_lo = _mm256_castsi256_si128(idx);
+    const __m128i idx_hi = _mm256_extracti128_si256(idx, 1);
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const uint8_t *r = base + i * (size_t)s;
+        __m256i acc = _mm256_setzero_si256();
+        for (int f = 0; f < VALIDATE_FIELD_COUNT; f++)
+        {
+            const field_spec_t *spec = &field_specs[f];
+            const uint8_t *p = r + spec->offset;
+            __m256i bad;
+            if (spec->kind == FIELD_F64)
+            {
+                const __m256d lo = _mm256_set1_pd(v->min[f]);
+                const __m256d hi = _mm256_set1_pd(v->max[f]);
+                __m256d a = _mm256_i32gather_pd((const double*)p, idx_lo, 1);
+                __m256d b = _mm256_i32gather_pd((const double*)p, idx_hi, 1);
+                int bits = _mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(a, lo, _CMP_NGE_UQ),
+                                                           _mm256_cmp_pd(a, hi, _CMP_NLE_UQ))) |
+                           (_mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(b, lo, _CMP_NGE_UQ),
+                                                            _mm256_cmp_pd(b, hi, _CMP_NLE_UQ))) << 4);
+                bad = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), lane_bits), lane_bits);
+            }
+            else
+            {
+                __m256 x;
+                if (spec->kind == FIELD_F32)
+                {
+                    x = _mm256_i32gather_ps((const float*)p, idx, 1);
+                }
+                else
+                {
+                    __m256i w = _mm256_i32gather_epi32((const int*)p, idx, 1);
+                    w = _mm256_and_si256(w, _mm256_set1_epi32(spec->kind == FIELD_U8 ? 0xFF : 0xFFFF));
+                    x = _mm256_cvtepi32_ps(w);
+                }
+                bad = _mm256_castps_si256(_mm256_or_ps(_mm256_cmp_ps(x, _mm256_set1_ps(v->min_f[f]), _CMP_NGE_UQ),
+                                                       _mm256_cmp_ps(x, _mm256_set1_ps(v->max_f[f]), _CMP_NLE_UQ)));
+            }
+            acc = _mm256_or_si256(acc, _mm256_and_si256(bad, _mm256_set1_epi32(1 << f)));
+        }
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        _mm_storeu_si128((__m128i*)(masks + i), packed);
+    }
+    // The scalar tail is a tail call, so the compiler emits no vzeroupper on the way out
+    _mm256_zeroupper();
+    validate_masks_scalar(masks + i, base + i * (size_t)s, n - i, v);
+}
+
+__attribute__((target("avx512f")))
+static void validate_masks_avx512(uint16_t *masks, const uint8_t *base, size_t n,
+                                  const record_validator_t *v)
+{
+    const size_t s = sizeof(weather_record_t);
+    const __m512i idx = _mm512_mullo_epi32(
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm512_set1_epi32((int)s));
+    const __m256i idx_lo = _mm512_castsi512_si256(idx);
+    const __m256i idx_hi = _mm512_extracti64x4_epi64(idx, 1);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const uint8_t *r = base + i * s;
+        __m512i acc = _mm512_setzero_si512();
+        for (int f = 0; f < VALIDATE_FIELD_COUNT; f++)
+        {
+            const field_spec_t *spec = &field_specs[f];
+            const uint8_t *p = r + spec->offset;
+            __mmask16 bad;
+            if (spec->kind == FIELD_F64)
+            {
+                const __m512d lo = _mm512_set1_pd(v->min[f]);
+                const __m512d hi = _mm512_set1_pd(v->max[f]);
+                __m512d a = _mm512_i32gather_pd(idx_lo, (const void*)p, 1);
+                __m512d b = _mm512_i32gather_pd(idx_hi, (const void*)p, 1);
+                __mmask8 bad_a = _mm512_cmp_pd_mask(a, lo, _CMP_NGE_UQ) | _mm512_cmp_pd_mask(a, hi, _CMP_NLE_UQ);
+                __mmask8 bad_b = _mm512_cmp_pd_mask(b, lo, _CMP_NGE_UQ) | _mm512_cmp_pd_mask(b, hi, _CMP_NLE_UQ);
+                bad = (__mmask16)(bad_a | (bad_b << 8));
+            }
+            else
+            {
+                __m512 x;
+                if (spec->kind == FIELD_F32)
+                {
+                    x = _mm512_i32gather_ps(idx, (const void*)p, 1);
+                }
+                else
+                {
+                    __m512i w = _mm512_i32gather_epi32(idx, (const void*)p, 1);
+                    w = _mm512_and_si512(w, _mm512_set1_epi32(spec->kind == FIELD_U8 ? 0xFF : 0xFFFF));
+                    x = _mm512_cvtepi32_ps(w);
+                }
+                bad = _mm512_cmp_ps_mask(x, _mm512_set1_ps(v->min_f[f]), _CMP_NGE_UQ) |
+                      _mm512_cmp_ps_mask(x, _mm512_set1_ps(v->max_f[f]), _CMP_NLE_UQ);
+            }
+            acc = _mm512_mask_or_epi32(acc, bad, acc, _mm512_set1_epi32(1 << f));
+        }
+        _mm256_storeu_si256((__m256i*)(masks + i), _mm512_cvtepi32_epi16(acc));
+    }
+    // As above: clear the upper ZMM/YMM state before the tail call
+    _mm256_zeroupper();
+    validate_masks_scalar(masks + i, base + i * s, n - i, v);
+}
+#endif
+
+/*********************
+ *  DISPATCH TABLES
+ *********************/
+#if SIMD_X86
+static const validate_masks_fn validate_masks_impl[SIMD_LEVEL_COUNT] = {
+    validate_masks_scalar, validate_masks_sse42, validate_masks_avx2, validate_masks_avx512
+};
+#else
+static const validate_masks_fn validate_masks_impl[SIMD_LEVEL_COUNT] = {
+    validate_masks_scalar, validate_masks_scalar, validate_masks_scalar, validate_masks_scalar
+};
+#endif
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+void record_validator_init(record_validator_t *v, validate_action_t action)
+{
+    memset(v, 0, sizeof(*v));
+    v->action = action;
+    for (int f = 0; f < VALIDATE_FIELD_COUNT; f++)
+    {
+        v->min[f] = field_specs[f].min;
+        v->max[f] = field_specs[f].max;
+        refresh_float_bounds(v, f);
+    }
+}
+
+int record_validator_set_range(record_validator_t *v, const char *spec)
+{
+    const char *eq = strchr(spec, '=');
+    int field = -1;
+    for (int f = 0; eq && f < VALIDATE_FIELD_COUNT; f++)
+    {
+        size_t len = strlen(field_specs[f].name);
+        if ((size_t)(eq - spec) == len && strncmp(spec, field_specs[f].name, len) == 0)
+        {
+            field = f;
+        }
+    }
+    if (field < 0)
+    {
+        fprintf(stderr, "ERROR: Invalid range '%s' (expected FIELD=MIN:MAX with a known field)\n", spec);
+        return 0;
+    }
+
+    char *end = NULL;
+    double lo = strtod(eq + 1, &end);
+    if (end == eq + 1 || *end != ':')
+    {
+        fprintf(stderr, "ERROR: Invalid range '%s' (expected FIELD=MIN:MAX)\n", spec);
+        return 0;
+    }
+    const char *hi_text = end + 1;
+    double hi = strtod(hi_text, &end);
+    if (end == hi_text || *end != '\0' || !(lo <= hi))
+    {
+        fprintf(stderr, "ERROR: Invalid range '%s' (expected FIELD=MIN:MAX with MIN <= MAX)\n", spec);
+        return 0;
+    }
+
+    v->min[field] = lo;
+    v->max[field] = hi;
+    refresh_float_bounds(v, field);
+    return 1;
+}
+
+int validate_action_from_name(const char *name, validate_action_t *out)
+{
+    static const char *names[] = { "off", "count", "tag", "drop", "clamp" };
+    for (int a = 0; a < (int)(sizeof(names) / sizeof(names[0])); a++)
+    {
+        if (strcmp(name, names[a]) == 0)
+        {
+            *out = (validate_action_t)a;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char* validate_field_name(validate_field_t field)
+{
+    return (field >= 0 && field < VALIDATE_FIELD_COUNT) ? field_specs[field].name : "unknown";
+}
+
+void validate_weather_masks(uint16_t *masks, const weather_record_t *records, size_t n,
+                            const record_validator_t *v)
+{
+    validate_masks_impl[simd_level()](masks, (const uint8_t*)records, n, v);
+}
+
+size_t validate_weather_batch(record_validator_t *v, weather_record_t *records, uint16_t *masks, size_t n)
+{
+    validate_weather_masks(masks, records, n, v);
+    v->checked += n;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        uint16_t m = masks[i];
+        if (m)
+        {
+            v->invalid++;
+            int repaired = v->action == VALIDATE_CLAMP;
+            for (uint16_t bits = m; bits; bits &= (uint16_t)(bits - 1))
+            {
+                int f = __builtin_ctz(bits);
+                v->failures[f]++;
+                if (repaired && !clamp_field(v, &records[i], f))
+                {
+                    repaired = 0;
+                }
+            }
+            if (v->action == VALIDATE_DROP || (v->action == VALIDATE_CLAMP && !repaired))
+            {
+                v->dropped++;
+                continue;
+            }
+            if (repaired)
+            {
+                v->clamped++;
+            }
+        }
+        if (kept != i)
+        {
+            records[kept] = records[i];
+            masks[kept] = m;
+        }
+        kept++;
+    }
+    return kept;
+}
+
+const char* validate_tags_json(uint16_t mask, char *buf, size_t size)
+{
+    size_t len = 0;
+    buf[0] = '\0';
+    for (int f = 0; mask && f < VALIDATE_FIELD_COUNT && len < size; f++)
+    {
+        if (!(mask & (1u << f)))
+        {
+            continue;
+        }
+        int w = snprintf(buf + len, size - len, "%s\"%s\"",
+                         len == 0 ? ",\n      \"invalid\": [" : ", ", field_specs[f].name);
+        len += w > 0 ? (size_t)w : 0;
+    }
+    if (len > 0 && len < size)
+    {
+        snprintf(buf + len, size - len, "]");
+    }
+    return buf;
+}
+
+void record_validator_print_summary(const record_validator_t *v, FILE *f)
+{
+    fprintf(f, "Validation: %llu of %llu records invalid",
+            (unsigned long long)v->invalid, (unsigned long long)v->checked);
+    if (v->dropped)
+    {
+        fprintf(f, ", %llu dropped", (unsigned long long)v->dropped);
+    }
+    if (v->clamped)
+    {
+        fprintf(f, ", %llu clamped", (unsigned long long)v->clamped);
+    }
+    int first = 1;
+    for (int i = 0; i < VALIDATE_FIELD_COUNT; i++)
+    {
+        if (v->failures[i])
+        {
+            fprintf(f, "%s%s %llu", first ? ": " : ", ", field_specs[i].name,
+                    (unsigned long long)v->failures[i]);
+            first = 0;
+        }
+    }
+    fprintf(f, "\n");
+}
\ No newline at end of file
@@ -0,0 +1,237 @@
+/**
+ * @file rolling_stats.c
+ * @brief Rolling stats implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "rolling_stats.h"
+#include "mem_track.h"
+#include "util.h"
+#include <string.h>
+#include <math.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define INITIAL_CAPACITY 1024
+
+/*********************
+ *      CONSTANTS
+ *********************/
+// Smallest stddev a z-score is taken against, about one step of each reading's
+// resolution: after a constant signal the variance decays to 0, and any real
+// change must still be flagged while float noise is not
+static const double min_stddev[METRIC_COUNT] = { 0.01, 0.01, 0.01, 1.0 };
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static int grow(rolling_stats_t *rs)
+{
+    size_t capacity = rs->capacity * 2;
+    sensor_state_t *slots = (sensor_state_t*)mem_calloc(capacity, sizeof(sensor_state_t));
+    if (!slots)
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < rs->capacity; i++)
+    {
+        if (!rs->slots[i].used)
+        {
+            continue;
+        }
+        size_t j = util_hash_slot(rs->slots[i].sensor_id, capacity - 1);
+        while (slots[j].used)
+        {
+            j = util_probe_next(j, capacity - 1);
+        }
+        slots[j] = rs->slots[i];
+    }
+    mem_free(rs->slots);
+    rs->slots = slots;
+    rs->capacity = capacity;
+    return 1;
+}
+
+static sensor_state_t* find_or_insert(rolling_stats_t *rs, uint32_t sensor_id)
+{
+    size_t mask = rs->capacity - 1;
+    size_t i = util_hash_slot(sensor_id, mask);
+    while (rs->slots[i].used)
+    {
+        if (rs->slots[i].sensor_id == sensor_id)
+        {
+            return &rs->slots[i];
+        }
+        i = util_probe_next(i, mask);
+    }
+    if ((rs->sensors + 1) * 2 > rs->capacity)
+    {
+        if (!grow(rs))
+        {
+            return NULL;
+        }
+        return find_or_insert(rs, sensor_id);
+    }
+    rs->slots[i].used = 1;
+    rs->slots[i].sensor_id = sensor_id;
+    rs->sensors++;
+    return &rs->slots[i];
+}
+
+/* Returns the z-score of x before folding it in (0 while warming up) */
+static double ewma_update(ewma_state_t *s, double x, double alpha, uint32_t warmup, double min_sd)
+{
+    double z = 0.0;
+    if (s->samples == 0)
+    {
+        s->mean = x;
+        s->var = 0.0;
+        s->samples = 1;
+        return z;
+    }
+    double diff = x - s->mean;
+    if (s->samples >= warmup)
+    {
+        z = diff / fmax(sqrt(s->var), min_sd);
+    }
+    double incr = alpha * diff;
+    s->mean += incr;
+    s->var = (1.0 - alpha) * (s->var + diff * incr);
+    if (s->samples < UINT32_MAX)
+    {
+        s->samples++;
+    }
+    return z;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int rolling_stats_init(rolling_stats_t *rs, double alpha, double z_threshold, FILE *events)
+{
+    memset(rs, 0, sizeof(*rs));
+    rs->alpha = (alpha > 0.0 && alpha <= 1.0) ? alpha : ROLLING_DEFAULT_ALPHA;
+    rs->z_threshold = z_threshold > 0.0 ? z_threshold : ROLLING_DEFAULT_ZSCORE;
+    rs->warmup = ROLLING_DEFAULT_WARMUP;
+    rs->events = events;
+    rs->capacity = INITIAL_CAPACITY;
+    rs->slots = (sensor_state_t*)mem_calloc(rs->capacity, sizeof(sensor_state_t));
+    return rs->slots != NULL;
+}
+
+int rolling_stats_update(rolling_stats_t *rs, const weather_record_t *record, uint64_t ordinal)
+{
+    sensor_state_t *state = find_or_insert(rs, record->sensor_id);
+    if (!state)
+    {
+        return -1;
+    }
+    const double values[METRIC_COUNT] = {
+        record->temperature,
+        record->humidity,
+        record->pressure,
+        record->co2 == 0xFFFF ? NAN : (double)record->co2,
+    };
+
+    int flags = 0;
+    rs->readings++;
+    for (int m = 0; m < METRIC_COUNT; m++)
+    {
+        double x = values[m];
+        if (isnan(x))
+        {
+            continue;
+        }
+        ewma_state_t before = state->metric[m];
+        double z = ewma_update(&state->metric[m], x, rs->alpha, rs->warmup, min_stddev[m]);
+        if (fabs(z) <= rs->z_threshold)
+        {
+            continue;
+        }
+        flags |= 1 << m;
+        rs->anomalies[m]++;
+        if (rs->events)
+        {
+            fprintf(rs->events,
+                    "{\"record\":%llu,\"sensor_id\":%u,\"timestamp\":%u,\"metric\":\"%s\","
+                    "\"value\":%.2f,\"mean\":%.4f,\"stddev\":%.4f,\"z\":%.2f}\n",
+                    (unsigned long long)ordinal, record->sensor_id, record->timestamp,
+                    rolling_metric_name((rolling_metric_t)m), x, before.mean,
+                    fmax(sqrt(before.var), min_stddev[m]), z);
+        }
+    }
+    return flags;
+}
+
+int rolling_stats_update_batch(rolling_stats_t *rs, const weather_record_t *records,
+                               size_t n, uint64_t first_ordinal)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (rolling_stats_update(rs, &records[i], first_ordinal + i) < 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+const sensor_state_t* rolling_stats_find(const rolling_stats_t *rs, uint32_t sensor_id)
+{
+    size_t mask = rs->capacity - 1;
+    for (size_t i = util_hash_slot(sensor_id, mask); rs->slots[i].used; i = util_probe_next(i, mask))
+    {
+        if (rs->slots[i].sensor_id == sensor_id)
+        {
+            return &rs->slots[i];
+        }
+    }
+    return NULL;
+}
+
+uint64_t rolling_stats_flagged(const rolling_stats_t *rs)
+{
+    uint64_t total = 0;
+    for (int m = 0; m < METRIC_COUNT; m++)
+    {
+        total += rs->anomalies[m];
+    }
+    return total;
+}
+
+void rolling_stats_print_summary(const rolling_stats_t *rs, FILE *f)
+{
+    uint64_t total = rolling_stats_flagged(rs);
+    fprintf(f, "Anomalies: %llu flagged in %llu readings from %zu sensors (|z| > %.2f, alpha %.3f)",
+            (unsigned long long)total, (unsigned long long)rs->readings, rs->sensors,
+            rs->z_threshold, rs->alpha);
+    for (int m = 0; m < METRIC_COUNT; m++)
+    {
+        fprintf(f, "%s%s %llu", m == 0 ? ": " : ", ",
+                rolling_metric_name((rolling_metric_t)m), (unsigned long long)rs->anomalies[m]);
+    }
+    fprintf(f, "\n");
+}
+
+void rolling_stats_free(rolling_stats_t *rs)
+{
+    mem_free(rs->slots);
+    rs->slots = NULL;
+    rs->capacity = 0;
+    rs->sensors = 0;
+}
+
+const char* rolling_metric_name(rolling_metric_t metric)
+{
+    switch (metric)
+    {
+        case METRIC_TEMPERATURE: return "temperature";
+        case METRIC_HUMIDITY:    return "humidity";
+        case METRIC_PRESSURE:    return "pressure";
+        case METRIC_CO2:         return "co2";
+        default:                 return "unknown";
+    }
+}
\ No newline at end of file
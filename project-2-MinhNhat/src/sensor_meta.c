@@ -0,0 +1,286 @@
+/**
+ * @file sensor_meta.c
+ * @brief Sensor metadata loading and join
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "sensor_meta.h"
+#include "mem_track.h"
+#include "util.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define INITIAL_CAPACITY 256
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    int failed;
+} str_buf_t;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static void str_append(str_buf_t *b, const char *s)
+{
+    size_t n = strlen(s);
+    if (b->failed)
+    {
+        return;
+    }
+    if (b->len + n + 1 > b->cap)
+    {
+        size_t cap = b->cap ? b->cap * 2 : 128;
+        while (cap < b->len + n + 1)
+        {
+            cap *= 2;
+        }
+        char *data = (char*)mem_realloc(b->data, cap);
+        if (!data)
+        {
+            b->failed = 1;
+            return;
+        }
+        b->data = data;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, s, n + 1);
+    b->len += n;
+}
+
+/* cJSON renders (and escapes) keys and values so the fragment is valid JSON */
+static void append_json_value(str_buf_t *b, const cJSON *item)
+{
+    char *text = cJSON_PrintUnformatted(item);
+    if (!text)
+    {
+        b->failed = 1;
+        return;
+    }
+    str_append(b, text);
+    cJSON_free(text);
+}
+
+static char* render_station(const cJSON *sensor)
+{
+    str_buf_t b = { 0 };
+    int fields = 0;
+    for (const cJSON *child = sensor->child; child; child = child->next)
+    {
+        if (!child->string || strcmp(child->string, "sensor_id") == 0 ||
+            strcmp(child->string, "calibration") == 0)
+        {
+            continue;
+        }
+        str_append(&b, fields == 0 ? ",\n      \"station\": {\n        " : ",\n        ");
+        cJSON *key = cJSON_CreateString(child->string);
+        if (!key)
+        {
+            b.failed = 1;
+            break;
+        }
+        append_json_value(&b, key);
+        cJSON_Delete(key);
+        str_append(&b, ": ");
+        append_json_value(&b, child);
+        fields++;
+    }
+    str_append(&b, fields ? "\n      }" : "");
+    if (b.failed)
+    {
+        mem_free(b.data);
+        return NULL;
+    }
+    return b.data;
+}
+
+static sensor_meta_t* insert_slot(sensor_meta_table_t *t, uint32_t sensor_id)
+{
+    if ((t->sensors + 1) * 2 > t->capacity)
+    {
+        size_t capacity = t->capacity * 2;
+        sensor_meta_t *slots = (sensor_meta_t*)mem_calloc(capacity, sizeof(sensor_meta_t));
+        if (!slots)
+        {
+            return NULL;
+        }
+        for (size_t i = 0; i < t->capacity; i++)
+        {
+            if (!t->slots[i].used)
+            {
+                continue;
+            }
+            size_t j = util_hash_slot(t->slots[i].sensor_id, capacity - 1);
+            while (slots[j].used)
+            {
+                j = util_probe_next(j, capacity - 1);
+            }
+            slots[j] = t->slots[i];
+        }
+        mem_free(t->slots);
+        t->slots = slots;
+        t->capacity = capacity;
+    }
+    size_t mask = t->capacity - 1;
+    size_t i = util_hash_slot(sensor_id, mask);
+    while (t->slots[i].used)
+    {
+        if (t->slots[i].sensor_id == sensor_id)
+        {
+            // Later entries replace earlier ones
+            mem_free(t->slots[i].station_json);
+            memset(&t->slots[i], 0, sizeof(sensor_meta_t));
+            t->sensors--;
+            break;
+        }
+        i = util_probe_next(i, mask);
+    }
+    t->slots[i].used = 1;
+    t->slots[i].sensor_id = sensor_id;
+    t->sensors++;
+    return &t->slots[i];
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int sensor_meta_load(sensor_meta_table_t *t, const char *path, int emit_fields, int calibrate)
+{
+    memset(t, 0, sizeof(*t));
+    t->emit_fields = emit_fields;
+    t->calibrate = calibrate;
+    t->capacity = INITIAL_CAPACITY;
+    t->slots = (sensor_meta_t*)mem_calloc(t->capacity, sizeof(sensor_meta_t));
+    if (!t->slots)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 0;
+    }
+
+    char *text = util_read_file(path);
+    if (!text)
+    {
+        fprintf(stderr, "ERROR: Cannot read sensor metadata '%s': %s\n", path, strerror(errno));
+        sensor_meta_free(t);
+        return 0;
+    }
+    cJSON *root = cJSON_Parse(text);
+    mem_free(text);
+    const cJSON *list = cJSON_IsObject(root) ? cJSON_GetObjectItemCaseSensitive(root, "sensors") : root;
+    if (!cJSON_IsArray(list))
+    {
+        fprintf(stderr, "ERROR: Sensor metadata '%s' must be an array of sensors or {\"sensors\": [...]}\n", path);
+        cJSON_Delete(root);
+        sensor_meta_free(t);
+        return 0;
+    }
+
+    int ok = 1;
+    int index = 0;
+    const cJSON *sensor;
+    cJSON_ArrayForEach(sensor, list)
+    {
+        const cJSON *id = cJSON_GetObjectItemCaseSensitive(sensor, "sensor_id");
+        if (!cJSON_IsNumber(id) || id->valuedouble < 0 || id->valuedouble > (double)UINT32_MAX)
+        {
+            fprintf(stderr, "WARNING: Sensor metadata entry %d has no valid sensor_id, skipped\n", index);
+            index++;
+            continue;
+        }
+        index++;
+
+        sensor_meta_t *meta = insert_slot(t, (uint32_t)id->valuedouble);
+        char *station = meta ? render_station(sensor) : NULL;
+        if (!station)
+        {
+            ok = 0;
+            break;
+        }
+        meta->station_json = station;
+
+        const cJSON *cal = cJSON_GetObjectItemCaseSensitive(sensor, "calibration");
+        for (int m = 0; m < METRIC_COUNT; m++)
+        {
+            const cJSON *offset = cJSON_GetObjectItemCaseSensitive(cal, rolling_metric_name((rolling_metric_t)m));
+            meta->calibration[m] = cJSON_IsNumber(offset) ? (float)offset->valuedouble : 0.0f;
+        }
+    }
+    cJSON_Delete(root);
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        sensor_meta_free(t);
+        return 0;
+    }
+    return 1;
+}
+
+const sensor_meta_t* sensor_meta_find(const sensor_meta_table_t *t, uint32_t sensor_id)
+{
+    size_t mask = t->capacity - 1;
+    for (size_t i = util_hash_slot(sensor_id, mask); t->slots[i].used; i = util_probe_next(i, mask))
+    {
+        if (t->slots[i].sensor_id == sensor_id)
+        {
+            return &t->slots[i];
+        }
+    }
+    return NULL;
+}
+
+void sensor_meta_join(sensor_meta_table_t *t, weather_record_t *records, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        weather_record_t *r = &records[i];
+        const sensor_meta_t *meta = sensor_meta_find(t, r->sensor_id);
+        if (!meta)
+        {
+            t->unmatched++;
+            continue;
+        }
+        if (!t->calibrate)
+        {
+            continue;
+        }
+        // NaN stays NaN when an offset is added
+        r->temperature += meta->calibration[METRIC_TEMPERATURE];
+        r->humidity += meta->calibration[METRIC_HUMIDITY];
+        r->pressure += meta->calibration[METRIC_PRESSURE];
+        if (r->co2 != 0xFFFF)
+        {
+            float co2 = (float)r->co2 + meta->calibration[METRIC_CO2];
+            r->co2 = co2 <= 0.0f ? 0 : (co2 >= 65534.0f ? 65534 : (uint16_t)lrintf(co2));
+        }
+    }
+}
+
+const char* sensor_meta_station_json(const sensor_meta_table_t *t, uint32_t sensor_id)
+{
+    const sensor_meta_t *meta = t->emit_fields ? sensor_meta_find(t, sensor_id) : NULL;
+    return meta ? meta->station_json : "";
+}
+
+void sensor_meta_free(sensor_meta_table_t *t)
+{
+    for (size_t i = 0; t->slots && i < t->capacity; i++)
+    {
+        mem_free(t->slots[i].station_json);
+    }
+    mem_free(t->slots);
+    t->slots = NULL;
+    t->capacity = 0;
+    t->sensors = 0;
+}
\ No newline at end of file
@@ -0,0 +1,483 @@
+/**
+ * @file sensor_snapshot.c
+ * @brief Sensor snapshot implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "sensor_snapshot.h"
+
+#ifdef _WIN32
+
+int sensor_snapshot_open(sensor_snapshot_t *snap, const char *path, int writable)
+{
+    (void)snap;
+    (void)path;
+    (void)writable;
+    fprintf(stderr, "ERROR: Sensor snapshots are not supported on this platform\n");
+    return 0;
+}
+
+int sensor_snapshot_update_batch(sensor_snapshot_t *snap, const weather_record_t *records, size_t n)
+{
+    (void)snap;
+    (void)records;
+    (void)n;
+    return 0;
+}
+
+int sensor_snapshot_refresh(sensor_snapshot_t *snap)
+{
+    (void)snap;
+    return 0;
+}
+
+const snapshot_slot_t* sensor_snapshot_find(const sensor_snapshot_t *snap, uint32_t sensor_id)
+{
+    (void)snap;
+    (void)sensor_id;
+    return NULL;
+}
+
+void sensor_snapshot_export_json(const sensor_snapshot_t *snap, FILE *f)
+{
+    (void)snap;
+    (void)f;
+}
+
+void sensor_snapshot_close(sensor_snapshot_t *snap)
+{
+    (void)snap;
+}
+
+int export_sensor_snapshot(const char *snapshot_file, const char *output_file)
+{
+    (void)snapshot_file;
+    (void)output_file;
+    fprintf(stderr, "ERROR: Sensor snapshots are not supported on this platform\n");
+    return 1;
+}
+
+#else
+
+#include "mem_track.h"
+#include "util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SNAPSHOT_GROW_SUFFIX  ".grow"
+#define SNAPSHOT_OPEN_RETRIES 8
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static size_t file_size_for(uint32_t capacity)
+{
+    return sizeof(snapshot_header_t) + (size_t)capacity * sizeof(snapshot_slot_t);
+}
+
+static int map_file(sensor_snapshot_t *snap, size_t size, int writable)
+{
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *base = mmap(NULL, size, prot, MAP_SHARED, snap->fd, 0);
+    if (base == MAP_FAILED)
+    {
+        return 0;
+    }
+    snap->hdr = (snapshot_header_t*)base;
+    snap->slots = (snapshot_slot_t*)((uint8_t*)base + sizeof(snapshot_header_t));
+    snap->map_size = size;
+    snap->capacity = (uint32_t)((size - sizeof(snapshot_header_t)) / sizeof(snapshot_slot_t));
+    return 1;
+}
+
+static void unmap_file(sensor_snapshot_t *snap)
+{
+    if (snap->hdr)
+    {
+        munmap(snap->hdr, snap->map_size);
+    }
+    if (snap->fd >= 0)
+    {
+        close(snap->fd);
+    }
+    snap->hdr = NULL;
+    snap->slots = NULL;
+    snap->map_size = 0;
+    snap->capacity = 0;
+    snap->fd = -1;
+}
+
+/* The magic goes in last, so a half-initialized file is never taken for a table */
+static void init_header(snapshot_header_t *hdr, uint32_t capacity, uint32_t sensors, uint64_t updates)
+{
+    hdr->version = SNAPSHOT_VERSION;
+    hdr->slot_size = (uint16_t)sizeof(snapshot_slot_t);
+    hdr->capacity = capacity;
+    hdr->sensors = sensors;
+    hdr->updates = updates;
+    __atomic_store_n(&hdr->magic, SNAPSHOT_MAGIC, __ATOMIC_RELEASE);
+}
+
+/*
+ * Slot for sensor_id, or the empty slot where it would be inserted. The
+ * table size comes from the mapping, never from the shared header.
+ */
+static snapshot_slot_t* probe(const sensor_snapshot_t *snap, uint32_t sensor_id)
+{
+    size_t mask = snap->capacity - 1;
+    size_t i = util_hash_slot(sensor_id, mask);
+    while (snap->slots[i].used && snap->slots[i].sensor_id != sensor_id)
+    {
+        i = util_probe_next(i, mask);
+    }
+    return &snap->slots[i];
+}
+
+/* Seqlock write, so concurrent readers of the mapping never use a torn record */
+static void store_record(snapshot_slot_t *slot, const weather_record_t *record)
+{
+    uint32_t seq = slot->seq;
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->record = *record;
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+static void load_record(const snapshot_slot_t *slot, weather_record_t *out)
+{
+    for (;;)
+    {
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        *out = slot->record;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (!(seq & 1) && __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq)
+        {
+            return;
+        }
+    }
+}
+
+/* 1 if fd is still the file at path (a writer may have replaced it) */
+static int is_current(int fd, const char *path)
+{
+    struct stat a;
+    struct stat b;
+    return fstat(fd, &a) == 0 && stat(path, &b) == 0 && a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
+/*
+ * Double the table: build it in PATH.grow and rename() it over the snapshot.
+ * The old file is never modified, so a crash leaves one complete table, and
+ * readers that still map the old file see a consistent (stale) table until
+ * sensor_snapshot_refresh().
+ */
+static int grow(sensor_snapshot_t *snap)
+{
+    uint32_t capacity = snap->capacity * 2;
+    size_t size = file_size_for(capacity);
+    size_t path_len = strlen(snap->path);
+    char *temp = (char*)mem_malloc(path_len + sizeof(SNAPSHOT_GROW_SUFFIX));
+    if (!temp)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 0;
+    }
+    memcpy(temp, snap->path, path_len);
+    memcpy(temp + path_len, SNAPSHOT_GROW_SUFFIX, sizeof(SNAPSHOT_GROW_SUFFIX));
+
+    // Lock the new file before it becomes visible under the snapshot's name
+    sensor_snapshot_t next;
+    memset(&next, 0, sizeof(next));
+    next.fd = open(temp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    int ok = next.fd >= 0 && flock(next.fd, LOCK_EX) == 0 &&
+             ftruncate(next.fd, (off_t)size) == 0 && map_file(&next, size, 1);
+    if (ok)
+    {
+        for (uint32_t i = 0; i < snap->capacity; i++)
+        {
+            if (snap->slots[i].used)
+            {
+                *probe(&next, snap->slots[i].sensor_id) = snap->slots[i];
+            }
+        }
+        init_header(next.hdr, capacity, snap->hdr->sensors, snap->hdr->updates);
+        ok = msync(next.hdr, size, MS_SYNC) == 0 && rename(temp, snap->path) == 0;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Cannot grow snapshot '%s' to %u slots: %s\n", snap->path, capacity, strerror(errno));
+        if (next.fd >= 0)
+        {
+            unlink(temp);
+        }
+        unmap_file(&next);
+        mem_free(temp);
+        return 0;
+    }
+    mem_free(temp);
+
+    // Closing the old file releases its lock; writers waiting on it see it was replaced
+    unmap_file(snap);
+    snap->fd = next.fd;
+    snap->hdr = next.hdr;
+    snap->slots = next.slots;
+    snap->map_size = next.map_size;
+    snap->capacity = next.capacity;
+    return 1;
+}
+
+static int init_file(sensor_snapshot_t *snap)
+{
+    size_t size = file_size_for(SNAPSHOT_INITIAL_CAPACITY);
+    if (ftruncate(snap->fd, (off_t)size) != 0)
+    {
+        fprintf(stderr, "ERROR: Cannot size snapshot '%s': %s\n", snap->path, strerror(errno));
+        return 0;
+    }
+    if (!map_file(snap, size, 1))
+    {
+        fprintf(stderr, "ERROR: Cannot map snapshot '%s': %s\n", snap->path, strerror(errno));
+        return 0;
+    }
+    init_header(snap->hdr, SNAPSHOT_INITIAL_CAPACITY, 0, 0);
+    return 1;
+}
+
+/* Open the current file at snap->path; writers get it exclusively locked */
+static int open_locked(sensor_snapshot_t *snap, int writable)
+{
+    for (int attempt = 0; attempt < SNAPSHOT_OPEN_RETRIES; attempt++)
+    {
+        snap->fd = open(snap->path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+        if (snap->fd < 0)
+        {
+            fprintf(stderr, "ERROR: Cannot open snapshot '%s': %s\n", snap->path, strerror(errno));
+            return 0;
+        }
+        if (!writable)
+        {
+            return 1;
+        }
+        if (flock(snap->fd, LOCK_EX | LOCK_NB) != 0)
+        {
+            if (errno == EWOULDBLOCK)
+            {
+                fprintf(stderr, "ERROR: Snapshot '%s' is being updated by another process\n", snap->path);
+            }
+            else
+            {
+                fprintf(stderr, "ERROR: Cannot lock snapshot '%s': %s\n", snap->path, strerror(errno));
+            }
+            return 0;
+        }
+        // The lock holder may have grown (replaced) the file after we opened it
+        if (is_current(snap->fd, snap->path))
+        {
+            return 1;
+        }
+        close(snap->fd);
+        snap->fd = -1;
+    }
+    fprintf(stderr, "ERROR: Snapshot '%s' keeps being replaced\n", snap->path);
+    return 0;
+}
+
+static int map_existing(sensor_snapshot_t *snap, int writable)
+{
+    struct stat st;
+    if (fstat(snap->fd, &st) != 0)
+    {
+        fprintf(stderr, "ERROR: Cannot stat snapshot '%s': %s\n", snap->path, strerror(errno));
+        return 0;
+    }
+    if (st.st_size == 0 && writable)
+    {
+        return init_file(snap);
+    }
+    if ((size_t)st.st_size < file_size_for(1))
+    {
+        fprintf(stderr, "ERROR: '%s' is not a snapshot file\n", snap->path);
+        return 0;
+    }
+    if (!map_file(snap, (size_t)st.st_size, writable))
+    {
+        fprintf(stderr, "ERROR: Cannot map snapshot '%s': %s\n", snap->path, strerror(errno));
+        return 0;
+    }
+    const snapshot_header_t *h = snap->hdr;
+    if (h->magic != SNAPSHOT_MAGIC || h->version != SNAPSHOT_VERSION)
+    {
+        fprintf(stderr, "ERROR: '%s' is not a snapshot file\n", snap->path);
+        return 0;
+    }
+    if (h->slot_size != sizeof(snapshot_slot_t))
+    {
+        fprintf(stderr, "ERROR: Snapshot '%s' was written with a different record layout\n", snap->path);
+        return 0;
+    }
+    if (h->capacity == 0 || (h->capacity & (h->capacity - 1)) != 0 || h->capacity != snap->capacity ||
+        file_size_for(h->capacity) != snap->map_size)
+    {
+        fprintf(stderr, "ERROR: Snapshot '%s' is truncated or corrupt\n", snap->path);
+        return 0;
+    }
+    if (writable)
+    {
+        // A writer that died mid-update leaves an odd seq that readers would wait on forever
+        for (uint32_t i = 0; i < snap->capacity; i++)
+        {
+            if (snap->slots[i].seq & 1)
+            {
+                __atomic_store_n(&snap->slots[i].seq, snap->slots[i].seq + 1, __ATOMIC_RELEASE);
+            }
+        }
+    }
+    return 1;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int sensor_snapshot_open(sensor_snapshot_t *snap, const char *path, int writable)
+{
+    memset(snap, 0, sizeof(*snap));
+    snap->fd = -1;
+    size_t path_len = strlen(path);
+    snap->path = (char*)mem_malloc(path_len + 1);
+    if (!snap->path)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 0;
+    }
+    memcpy(snap->path, path, path_len + 1);
+
+    if (!open_locked(snap, writable) || !map_existing(snap, writable))
+    {
+        sensor_snapshot_close(snap);
+        return 0;
+    }
+    return 1;
+}
+
+int sensor_snapshot_refresh(sensor_snapshot_t *snap)
+{
+    if (is_current(snap->fd, snap->path))
+    {
+        return 1;
+    }
+    unmap_file(snap);
+    return open_locked(snap, 0) && map_existing(snap, 0);
+}
+
+int sensor_snapshot_update_batch(sensor_snapshot_t *snap, const weather_record_t *records, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        const weather_record_t *r = &records[i];
+        snapshot_slot_t *slot = probe(snap, r->sensor_id);
+        if (!slot->used)
+        {
+            if ((snap->hdr->sensors + 1) * 2 > snap->capacity)
+            {
+                if (!grow(snap))
+                {
+                    return 0;
+                }
+                slot = probe(snap, r->sensor_id);
+            }
+            slot->sensor_id = r->sensor_id;
+            store_record(slot, r);
+            __atomic_store_n(&slot->used, 1, __ATOMIC_RELEASE);
+            snap->hdr->sensors++;
+        }
+        else if (r->timestamp >= slot->record.timestamp)
+        {
+            store_record(slot, r);
+        }
+        else
+        {
+            continue;
+        }
+        snap->hdr->updates++;
+        snap->updated++;
+    }
+    return 1;
+}
+
+const snapshot_slot_t* sensor_snapshot_find(const sensor_snapshot_t *snap, uint32_t sensor_id)
+{
+    const snapshot_slot_t *slot = probe(snap, sensor_id);
+    return slot->used ? slot : NULL;
+}
+
+void sensor_snapshot_export_json(const sensor_snapshot_t *snap, FILE *f)
+{
+    fprintf(f, "{\"sensors\":%u,\"updates\":%llu,\"latest\":[", snap->hdr->sensors,
+            (unsigned long long)snap->hdr->updates);
+    const char *sep = "\n";
+    for (uint32_t i = 0; i < snap->capacity; i++)
+    {
+        if (!__atomic_load_n(&snap->slots[i].used, __ATOMIC_ACQUIRE))
+        {
+            continue;
+        }
+        weather_record_t r;
+        load_record(&snap->slots[i], &r);
+        fprintf(f, "%s{\"sensor_id\":%u,\"battery\":\"%s\",\"timestamp\":%u,\"lat\":%.8f,\"lon\":%.8f,"
+                "\"temperature\":%.2f,\"humidity\":%.2f,\"pressure\":%.2f,\"co2\":%u,"
+                "\"wind_speed\":%.2f,\"wind_direction\":%u,\"rain\":%.2f,\"uv\":%.2f,\"light\":%.2f}",
+                sep, r.sensor_id, battery_status_to_string(r.battery), r.timestamp, r.lat, r.lon,
+                r.temperature, r.humidity, r.pressure, r.co2, r.wind_speed, r.wind_dir,
+                r.rain, r.uv, r.light);
+        sep = ",\n";
+    }
+    fprintf(f, "\n]}\n");
+}
+
+void sensor_snapshot_close(sensor_snapshot_t *snap)
+{
+    unmap_file(snap);
+    mem_free(snap->path);
+    memset(snap, 0, sizeof(*snap));
+    snap->fd = -1;
+}
+
+int export_sensor_snapshot(const char *snapshot_file, const char *output_file)
+{
+    sensor_snapshot_t snap;
+    if (!sensor_snapshot_open(&snap, snapshot_file, 0))
+    {
+        return 1;
+    }
+    FILE *f = output_file ? fopen(output_file, "w") : stdout;
+    if (!f)
+    {
+        fprintf(stderr, "ERROR: Cannot create output file '%s'\n", output_file);
+        sensor_snapshot_close(&snap);
+        return 1;
+    }
+    sensor_snapshot_export_json(&snap, f);
+    int rc = ferror(f) ? 1 : 0;
+    if (output_file)
+    {
+        rc |= fclose(f) != 0;
+        if (rc == 0)
+        {
+            printf("SUCCESS: Exported %u sensors to %s\n", snap.hdr->sensors, output_file);
+        }
+    }
+    sensor_snapshot_close(&snap);
+    return rc;
+}
+
+#endif
\ No newline at end of file
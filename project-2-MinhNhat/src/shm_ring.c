@@ -0,0 +1,465 @@
+/**
+ * @file shm_ring.c
+ * @brief Shared-memory ring buffer implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "shm_ring.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+
+int ingest_shm_ring(const char *ring_name, const char *output_file,
+                    const parse_options_t *opts, conv_stats_t *stats)
+{
+    (void)ring_name;
+    (void)output_file;
+    (void)opts;
+    (void)stats;
+    fprintf(stderr, "ERROR: Shared-memory ingestion is not supported on this platform\n");
+    return 1;
+}
+
+#else
+
+#include "json_writer.h"
+#include "mem_track.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define IDLE_SPINS     256
+#define IDLE_SLEEP_NS  100000L
+#define LIVENESS_IDLES (IDLE_SPINS + SHM_RING_LIVENESS_MS * 1000000L / IDLE_SLEEP_NS)
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static void sleep_ns(long ns)
+{
+    struct timespec ts = { 0, ns };
+    nanosleep(&ts, NULL);
+}
+
+/* Yield for a while before sleeping, so a busy producer is picked up quickly */
+static void idle_wait(unsigned *idle)
+{
+    if (++*idle < IDLE_SPINS)
+    {
+        sched_yield();
+    }
+    else
+    {
+        sleep_ns(IDLE_SLEEP_NS);
+    }
+}
+
+static uint32_t round_up_pow2(uint32_t v)
+{
+    uint32_t p = 1;
+    while (p < v && p < 0x80000000u)
+    {
+        p <<= 1;
+    }
+    return p;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int shm_ring_create(shm_ring_t *ring, const char *name, uint32_t capacity,
+                    const file_header_t *header)
+{
+    memset(ring, 0, sizeof(*ring));
+    capacity = round_up_pow2(capacity ? capacity : SHM_RING_DEFAULT_CAPACITY);
+    size_t size = sizeof(shm_ring_header_t) + (size_t)capacity * RECORD_SIZE;
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        fprintf(stderr, "ERROR: shm_open '%s': %s\n", name, strerror(errno));
+        return 0;
+    }
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        fprintf(stderr, "ERROR: Cannot size ring '%s': %s\n", name, strerror(errno));
+        close(fd);
+        shm_unlink(name);
+        return 0;
+    }
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        fprintf(stderr, "ERROR: Cannot map ring '%s': %s\n", name, strerror(errno));
+        shm_unlink(name);
+        return 0;
+    }
+
+    ring->hdr = (shm_ring_header_t*)base;
+    ring->slots = (uint8_t*)base + sizeof(shm_ring_header_t);
+    ring->map_size = size;
+    ring->mask = capacity - 1;
+
+    ring->hdr->version = SHM_RING_VERSION;
+    ring->hdr->record_size = RECORD_SIZE;
+    ring->hdr->capacity = capacity;
+    memcpy(ring->hdr->file_id, header->file_id, FILE_ID_SIZE);
+    ring->hdr->file_version = header->version;
+    ring->hdr->producer_pid = (int32_t)getpid();
+    // Magic last: the consumer treats the header as valid once it sees it
+    __atomic_store_n(&ring->hdr->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    return 1;
+}
+
+int shm_ring_attach(shm_ring_t *ring, const char *name, int timeout_ms)
+{
+    memset(ring, 0, sizeof(*ring));
+    long waited_ms = 0;
+    for (;;)
+    {
+        int fd = shm_open(name, O_RDWR, 0);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && (size_t)st.st_size > sizeof(shm_ring_header_t))
+        {
+            void *base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (base == MAP_FAILED)
+            {
+                fprintf(stderr, "ERROR: Cannot map ring '%s': %s\n", name, strerror(errno));
+                return 0;
+            }
+            shm_ring_header_t *hdr = (shm_ring_header_t*)base;
+            if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) == SHM_RING_MAGIC)
+            {
+                size_t needed = sizeof(shm_ring_header_t) + (size_t)hdr->capacity * RECORD_SIZE;
+                if (hdr->version != SHM_RING_VERSION || hdr->record_size != RECORD_SIZE ||
+                    hdr->capacity == 0 || (hdr->capacity & (hdr->capacity - 1)) != 0 ||
+                    needed > (size_t)st.st_size)
+                {
+                    fprintf(stderr, "ERROR: Ring '%s' has an incompatible layout\n", name);
+                    munmap(base, (size_t)st.st_size);
+                    return 0;
+                }
+                ring->hdr = hdr;
+                ring->slots = (uint8_t*)base + sizeof(shm_ring_header_t);
+                ring->map_size = (size_t)st.st_size;
+                ring->mask = hdr->capacity - 1;
+                return 1;
+            }
+            munmap(base, (size_t)st.st_size);
+        }
+        else if (fd >= 0)
+        {
+            close(fd);
+        }
+
+        if (waited_ms >= timeout_ms)
+        {
+            fprintf(stderr, "ERROR: Ring '%s' did not appear within %d ms\n", name, timeout_ms);
+            return 0;
+        }
+        sleep_ns(10 * 1000000L);
+        waited_ms += 10;
+    }
+}
+
+void shm_ring_detach(shm_ring_t *ring)
+{
+    if (ring->hdr)
+    {
+        munmap(ring->hdr, ring->map_size);
+    }
+    memset(ring, 0, sizeof(*ring));
+}
+
+void shm_ring_unlink(const char *name)
+{
+    shm_unlink(name);
+}
+
+uint8_t* shm_ring_write_space(shm_ring_t *ring, uint32_t *count)
+{
+    uint64_t head = ring->hdr->head;
+    uint64_t tail = __atomic_load_n(&ring->hdr->tail, __ATOMIC_ACQUIRE);
+    uint32_t offset = (uint32_t)(head & ring->mask);
+    uint64_t free_slots = (uint64_t)ring->hdr->capacity - (head - tail);
+    uint32_t until_wrap = ring->hdr->capacity - offset;
+    *count = (uint32_t)(free_slots < until_wrap ? free_slots : until_wrap);
+    return ring->slots + (size_t)offset * RECORD_SIZE;
+}
+
+void shm_ring_publish(shm_ring_t *ring, uint32_t n)
+{
+    __atomic_store_n(&ring->hdr->head, ring->hdr->head + n, __ATOMIC_RELEASE);
+}
+
+void shm_ring_close(shm_ring_t *ring)
+{
+    __atomic_or_fetch(&ring->hdr->flags, SHM_RING_CLOSED, __ATOMIC_RELEASE);
+}
+
+const uint8_t* shm_ring_read_span(shm_ring_t *ring, uint32_t *count)
+{
+    uint64_t tail = ring->hdr->tail;
+    uint64_t head = __atomic_load_n(&ring->hdr->head, __ATOMIC_ACQUIRE);
+    uint32_t offset = (uint32_t)(tail & ring->mask);
+    uint64_t ready = head - tail;
+    uint32_t until_wrap = ring->hdr->capacity - offset;
+    *count = (uint32_t)(ready < until_wrap ? ready : until_wrap);
+    return ring->slots + (size_t)offset * RECORD_SIZE;
+}
+
+void shm_ring_release(shm_ring_t *ring, uint32_t n)
+{
+    __atomic_store_n(&ring->hdr->tail, ring->hdr->tail + n, __ATOMIC_RELEASE);
+}
+
+int shm_ring_drained(shm_ring_t *ring)
+{
+    // Flags before head: the final head is published before SHM_RING_CLOSED
+    if (!(__atomic_load_n(&ring->hdr->flags, __ATOMIC_ACQUIRE) & SHM_RING_CLOSED))
+    {
+        return 0;
+    }
+    return __atomic_load_n(&ring->hdr->head, __ATOMIC_ACQUIRE) == ring->hdr->tail;
+}
+
+int shm_ring_producer_alive(shm_ring_t *ring)
+{
+    if (__atomic_load_n(&ring->hdr->flags, __ATOMIC_ACQUIRE) & SHM_RING_CLOSED)
+    {
+        return 1;
+    }
+    pid_t pid = (pid_t)ring->hdr->producer_pid;
+    // EPERM: the process exists but belongs to another user
+    return pid <= 0 || kill(pid, 0) == 0 || errno == EPERM;
+}
+
+int ingest_shm_ring(const char *ring_name, const char *output_file,
+                    const parse_options_t *opts, conv_stats_t *stats)
+{
+    static const parse_options_t default_opts = { 0 };
+    if (!opts)
+    {
+        opts = &default_opts;
+    }
+    if (opts->dedup)
+    {
+        fprintf(stderr, "ERROR: --dedup is not supported for shared-memory ingestion\n");
+        return 1;
+    }
+
+    uint64_t t_start = 0;
+    uint64_t t_mark = 0;
+    uint64_t anomalies_before = opts->anomaly ? rolling_stats_flagged(opts->anomaly) : 0;
+    if (stats)
+    {
+        memset(stats, 0, sizeof(*stats));
+        t_start = stats_now_ns();
+        mem_window_reset();
+    }
+
+    shm_ring_t ring;
+    if (!shm_ring_attach(&ring, ring_name, SHM_RING_ATTACH_TIMEOUT_MS))
+    {
+        return 1;
+    }
+
+    file_header_t header;
+    memcpy(header.file_id, ring.hdr->file_id, FILE_ID_SIZE);
+    header.file_id[FILE_ID_SIZE] = '\0';
+    header.version = ring.hdr->file_version;
+    header.count = 0;
+    if (!opts->quiet)
+    {
+        printf("Ingesting: shm:%s -> %s (%u slots)\n", ring_name, output_file, ring.hdr->capacity);
+    }
+
+    create_output_directory("data");
+    FILE *fout = fopen(output_file, "w");
+    if (!fout)
+    {
+        fprintf(stderr, "ERROR: Cannot open output file '%s': %s\n", output_file, strerror(errno));
+        shm_ring_detach(&ring);
+        return 1;
+    }
+    weather_record_t *records = (weather_record_t*)mem_malloc(READ_BATCH_RECORDS * sizeof(weather_record_t));
+    derived_metrics_t *derived = (derived_metrics_t*)mem_malloc(READ_BATCH_RECORDS * sizeof(derived_metrics_t));
+    uint16_t *invalid = (uint16_t*)mem_malloc(READ_BATCH_RECORDS * sizeof(uint16_t));
+    if (!records || !derived || !invalid)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        fclose(fout);
+        mem_free(records);
+        mem_free(derived);
+        mem_free(invalid);
+        shm_ring_detach(&ring);
+        return 1;
+    }
+
+    long count_offset = write_json_header_patchable(&header, fout);
+
+    // Decode in place from the ring, hand slots back, then write.
+    // As in parse_weather_file_ex, the last record is held back to close the array.
+    uint32_t records_written = 0;
+    weather_record_t pending;
+    derived_metrics_t pending_derived;
+    uint16_t pending_invalid = 0;
+    iso_time_cache_t times = { 0 };
+    int has_pending = 0;
+    int aborted = 0;
+    unsigned idle = 0;
+    if (stats)
+    {
+        t_mark = stats_now_ns();
+    }
+    for (;;)
+    {
+        uint32_t n;
+        const uint8_t *span = shm_ring_read_span(&ring, &n);
+        if (n == 0)
+        {
+            if (shm_ring_drained(&ring))
+            {
+                break;
+            }
+            if (idle >= IDLE_SPINS && (idle - IDLE_SPINS) % LIVENESS_IDLES == 0 &&
+                !shm_ring_producer_alive(&ring))
+            {
+                fprintf(stderr, "ERROR: Producer (pid %d) exited without closing ring '%s'\n",
+                        (int)ring.hdr->producer_pid, ring_name);
+                aborted = 1;
+                break;
+            }
+            idle_wait(&idle);
+            continue;
+        }
+        idle = 0;
+        if (!mem_within_budget(opts->mem_budget))
+        {
+            fprintf(stderr, "ERROR: Memory budget of %zu bytes exceeded (heap %zu, peak RSS %zu)\n",
+                    opts->mem_budget, mem_live_bytes(), mem_peak_rss_bytes());
+            aborted = 1;
+            break;
+        }
+        if (n > READ_BATCH_RECORDS)
+        {
+            n = READ_BATCH_RECORDS;
+        }
+        if (stats)
+        {
+            // Read stage = time spent waiting for the producer
+            conv_stats_end_stage(stats, STAGE_READ, &t_mark);
+            stats->bytes_read += (uint64_t)n * RECORD_SIZE;
+        }
+
+        decode_weather_batch(records, span, n);
+        shm_ring_release(&ring, n);
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_DECODE, &t_mark);
+        }
+
+        if (opts->validate)
+        {
+            n = (uint32_t)validate_weather_records(opts, records, invalid, n, stats);
+            if (stats)
+            {
+                conv_stats_end_stage(stats, STAGE_VALIDATE, &t_mark);
+            }
+            if (n == 0)
+            {
+                continue;
+            }
+        }
+
+        if (analyze_enabled(opts))
+        {
+            if (!analyze_weather_batch(opts, records, derived, n, records_written))
+            {
+                aborted = 1;
+                break;
+            }
+            if (stats)
+            {
+                conv_stats_end_stage(stats, STAGE_ANALYZE, &t_mark);
+            }
+        }
+
+        if (has_pending)
+        {
+            write_weather_json(opts, &pending, &pending_derived, pending_invalid, &times, fout, 0);
+        }
+        for (uint32_t i = 0; i + 1 < n; i++)
+        {
+            write_weather_json(opts, &records[i], &derived[i], opts->validate ? invalid[i] : 0, &times, fout, 0);
+        }
+        pending = records[n - 1];
+        pending_derived = derived[n - 1];
+        pending_invalid = opts->validate ? invalid[n - 1] : 0;
+        has_pending = 1;
+        records_written += n;
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_WRITE, &t_mark);
+        }
+    }
+
+    if (has_pending)
+    {
+        write_weather_json(opts, &pending, &pending_derived, pending_invalid, &times, fout, 1);
+    }
+    write_json_footer(fout);
+    if (patch_json_record_count(fout, count_offset, records_written) != 0)
+    {
+        fprintf(stderr, "WARNING: Output is not seekable, record_count left at 0\n");
+    }
+
+    if (stats)
+    {
+        long out_size = ftell(fout);
+        stats->bytes_written = out_size > 0 ? (uint64_t)out_size : 0;
+        stats->records = records_written;
+        stats->heap_peak_bytes = mem_peak_bytes();
+        stats->anomalies = opts->anomaly ? rolling_stats_flagged(opts->anomaly) - anomalies_before : 0;
+    }
+
+    int write_failed = ferror(fout);
+    fclose(fout);
+    mem_free(records);
+    mem_free(derived);
+    mem_free(invalid);
+    shm_ring_detach(&ring);
+    shm_ring_unlink(ring_name);
+
+    if (stats)
+    {
+        stats->total_ns = stats_now_ns() - t_start;
+        stats->rss_peak_bytes = mem_peak_rss_bytes();
+    }
+
+    if (aborted || write_failed)
+    {
+        return 1;
+    }
+    if (!opts->quiet)
+    {
+        printf("SUCCESS: Ingested %u records to JSON format\n", records_written);
+    }
+    return 0;
+}
+
+#endif
\ No newline at end of file
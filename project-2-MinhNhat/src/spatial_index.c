@@ -0,0 +1,492 @@
+/**
+ * @file spatial_index.c
+ * @brief Grid index build and bounding-box query
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#ifndef _WIN32
+  #define _FILE_OFFSET_BITS 64
+  #define _POSIX_C_SOURCE 200809L
+#endif
+#include "spatial_index.h"
+#include "weather_parser.h"
+#include "binary_io.h"
+#include "record_sort.h"
+#include "json_writer.h"
+#include "mem_track.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+// 64-bit seek: plain fseek takes a long, which is 32 bits on Windows
+static int seek_record(FILE *f, uint32_t ordinal)
+{
+    int64_t offset = (int64_t)HEADER_SIZE + (int64_t)ordinal * RECORD_SIZE;
+#ifdef _WIN32
+    return _fseeki64(f, offset, SEEK_SET);
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static char* index_path_for(const char *bin_file)
+{
+    size_t len = strlen(bin_file);
+    char *path = (char*)mem_malloc(len + sizeof(SPATIAL_INDEX_SUFFIX));
+    if (path)
+    {
+        memcpy(path, bin_file, len);
+        memcpy(path + len, SPATIAL_INDEX_SUFFIX, sizeof(SPATIAL_INDEX_SUFFIX));
+    }
+    return path;
+}
+
+static int write_index_file(const char *path, double cell_deg, uint32_t record_count,
+                            const spatial_cell_t *cells, uint32_t n_cells)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        fprintf(stderr, "ERROR: Cannot open index file '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+    uint8_t buf[SPATIAL_INDEX_HEADER_SIZE];
+    memcpy(buf, SPATIAL_INDEX_MAGIC, 4);
+    store_u16_le(buf + 4, SPATIAL_INDEX_VERSION);
+    store_u16_le(buf + 6, 0);
+    store_f64_le(buf + 8, cell_deg);
+    store_u32_le(buf + 16, record_count);
+    store_u32_le(buf + 20, n_cells);
+    int ok = fwrite(buf, 1, sizeof(buf), f) == sizeof(buf);
+    for (uint32_t i = 0; ok && i < n_cells; i++)
+    {
+        uint8_t entry[SPATIAL_INDEX_ENTRY_SIZE];
+        store_u32_le(entry, (uint32_t)cells[i].cell);
+        store_u32_le(entry + 4, (uint32_t)(cells[i].cell >> 32));
+        store_u32_le(entry + 8, cells[i].first);
+        store_u32_le(entry + 12, cells[i].count);
+        ok = fwrite(entry, 1, sizeof(entry), f) == sizeof(entry);
+    }
+    if (fclose(f) != 0)
+    {
+        ok = 0;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Failed to write index file '%s'\n", path);
+    }
+    return ok;
+}
+
+/* First cell with key >= key */
+static uint32_t lower_bound_cell(const spatial_index_t *index, uint64_t key)
+{
+    uint32_t lo = 0;
+    uint32_t hi = index->n_cells;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index->cells[mid].cell < key)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static uint32_t clamp_grid(double v, double offset, double cell_deg)
+{
+    double g = floor((v + offset) / cell_deg);
+    if (g < 0)
+    {
+        return 0;
+    }
+    if (g > (double)UINT32_MAX - 1)
+    {
+        return UINT32_MAX - 1;
+    }
+    return (uint32_t)g;
+}
+
+static uint64_t cell_sort_key(const uint8_t *packed, const void *ctx)
+{
+    return spatial_cell_key(load_f64_le(packed + 9), load_f64_le(packed + 17), *(const double*)ctx);
+}
+
+/*
+ * Reads a cell-ordered file back and collects one range per cell.
+ * Only the cell table is held in memory.
+ */
+static spatial_cell_t* collect_cells(const char *path, double cell_deg, uint32_t *n_records,
+                                     uint32_t *n_cells, uint32_t *invalid)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "ERROR: Cannot open '%s': %s\n", path, strerror(errno));
+        return NULL;
+    }
+    file_header_t header;
+    uint8_t *batch = (uint8_t*)mem_malloc((size_t)READ_BATCH_RECORDS * RECORD_SIZE);
+    uint32_t capacity = 1024;
+    spatial_cell_t *cells = (spatial_cell_t*)mem_malloc(capacity * sizeof(spatial_cell_t));
+    int ok = batch && cells;
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+    }
+    else if (!read_header(&header, f))
+    {
+        fprintf(stderr, "ERROR: Failed to read '%s'\n", path);
+        ok = 0;
+    }
+
+    uint32_t n = 0;
+    uint32_t c = 0;
+    *invalid = 0;
+    while (ok && n < header.count)
+    {
+        uint32_t want = header.count - n < READ_BATCH_RECORDS ? header.count - n : READ_BATCH_RECORDS;
+        uint32_t got = (uint32_t)fread(batch, RECORD_SIZE, want, f);
+        if (got < want)
+        {
+            fprintf(stderr, "ERROR: Failed to read record %u of '%s'\n", n + got + 1, path);
+            ok = 0;
+            break;
+        }
+        for (uint32_t i = 0; i < got; i++, n++)
+        {
+            uint64_t key = cell_sort_key(batch + (size_t)i * RECORD_SIZE, &cell_deg);
+            if (c == 0 || cells[c - 1].cell != key)
+            {
+                if (c == capacity)
+                {
+                    spatial_cell_t *grown = (spatial_cell_t*)mem_realloc(cells, (size_t)capacity * 2 * sizeof(spatial_cell_t));
+                    if (!grown)
+                    {
+                        fprintf(stderr, "ERROR: Out of memory\n");
+                        ok = 0;
+                        break;
+                    }
+                    cells = grown;
+                    capacity *= 2;
+                }
+                cells[c].cell = key;
+                cells[c].first = n;
+                cells[c].count = 0;
+                c++;
+            }
+            cells[c - 1].count++;
+            if (key == SPATIAL_INVALID_CELL)
+            {
+                (*invalid)++;
+            }
+        }
+    }
+    mem_free(batch);
+    fclose(f);
+    if (!ok)
+    {
+        mem_free(cells);
+        return NULL;
+    }
+    *n_records = n;
+    *n_cells = c;
+    return cells;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+uint64_t spatial_cell_key(double lat, double lon, double cell_deg)
+{
+    if (!(lat >= -90.0 && lat <= 90.0 && lon >= -180.0 && lon <= 180.0))
+    {
+        return SPATIAL_INVALID_CELL;
+    }
+    // Clamped like the query side so a tiny cell size cannot carry into the row bits
+    uint64_t row = clamp_grid(lat, 90.0, cell_deg);
+    uint64_t col = clamp_grid(lon, 180.0, cell_deg);
+    return (row << 32) | col;
+}
+
+int build_spatial_index(const char *input_file, const char *output_file, double cell_deg, size_t mem_limit)
+{
+    if (cell_deg <= 0)
+    {
+        cell_deg = SPATIAL_DEFAULT_CELL_DEG;
+    }
+    if (!(cell_deg >= SPATIAL_MIN_CELL_DEG))
+    {
+        fprintf(stderr, "ERROR: Cell size must be at least %g degrees\n", SPATIAL_MIN_CELL_DEG);
+        return 1;
+    }
+    printf("Indexing: %s -> %s (cell %.6f deg)\n", input_file, output_file, cell_deg);
+
+    char *index_file = index_path_for(output_file);
+    if (!index_file)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+
+    // Records are put in cell order by the external sort, then the cell
+    // ranges are collected from the sorted file; neither step holds the input.
+    int rc = 1;
+    uint32_t n = 0;
+    uint32_t n_cells = 0;
+    uint32_t invalid = 0;
+    spatial_cell_t *cells = NULL;
+    if (sort_weather_file_by(input_file, output_file, mem_limit, cell_sort_key, &cell_deg, NULL) != 0)
+    {
+        goto cleanup;
+    }
+    cells = collect_cells(output_file, cell_deg, &n, &n_cells, &invalid);
+    if (!cells || !write_index_file(index_file, cell_deg, n, cells, n_cells))
+    {
+        goto cleanup;
+    }
+    if (invalid > 0)
+    {
+        printf("WARNING: %u records have invalid coordinates and are never matched\n", invalid);
+    }
+    printf("SUCCESS: Indexed %u records in %u cells (%s)\n", n, n_cells, index_file);
+    rc = 0;
+
+cleanup:
+    mem_free(cells);
+    mem_free(index_file);
+    return rc;
+}
+
+int spatial_index_load(spatial_index_t *index, const char *index_file)
+{
+    memset(index, 0, sizeof(*index));
+    FILE *f = fopen(index_file, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "ERROR: Cannot open index file '%s': %s\n", index_file, strerror(errno));
+        return 0;
+    }
+    uint8_t buf[SPATIAL_INDEX_HEADER_SIZE];
+    if (fread(buf, 1, sizeof(buf), f) != sizeof(buf) ||
+        memcmp(buf, SPATIAL_INDEX_MAGIC, 4) != 0 ||
+        load_u16_le(buf + 4) != SPATIAL_INDEX_VERSION)
+    {
+        fprintf(stderr, "ERROR: '%s' is not a spatial index\n", index_file);
+        fclose(f);
+        return 0;
+    }
+    index->cell_deg = load_f64_le(buf + 8);
+    if (!isfinite(index->cell_deg) || index->cell_deg <= 0)
+    {
+        fprintf(stderr, "ERROR: Index file '%s' has an invalid cell size\n", index_file);
+        fclose(f);
+        return 0;
+    }
+    index->record_count = load_u32_le(buf + 16);
+    index->n_cells = load_u32_le(buf + 20);
+    index->cells = (spatial_cell_t*)mem_malloc((size_t)index->n_cells * sizeof(spatial_cell_t) + 1);
+    if (!index->cells)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        fclose(f);
+        return 0;
+    }
+    for (uint32_t i = 0; i < index->n_cells; i++)
+    {
+        uint8_t entry[SPATIAL_INDEX_ENTRY_SIZE];
+        if (fread(entry, 1, sizeof(entry), f) != sizeof(entry))
+        {
+            fprintf(stderr, "ERROR: Index file '%s' is truncated\n", index_file);
+            spatial_index_free(index);
+            fclose(f);
+            return 0;
+        }
+        index->cells[i].cell = (uint64_t)load_u32_le(entry) | ((uint64_t)load_u32_le(entry + 4) << 32);
+        index->cells[i].first = load_u32_le(entry + 8);
+        index->cells[i].count = load_u32_le(entry + 12);
+    }
+    fclose(f);
+    return 1;
+}
+
+void spatial_index_free(spatial_index_t *index)
+{
+    mem_free(index->cells);
+    index->cells = NULL;
+    index->n_cells = 0;
+}
+
+int query_spatial_bbox(const char *input_file, const geo_bbox_t *box, const char *output_file, int derive)
+{
+    if (!(box->min_lat <= box->max_lat && box->min_lon <= box->max_lon))
+    {
+        fprintf(stderr, "ERROR: Bounding box needs min_lat <= max_lat and min_lon <= max_lon\n");
+        return 1;
+    }
+    printf("Querying: %s [%.6f,%.6f .. %.6f,%.6f] -> %s\n", input_file,
+           box->min_lat, box->min_lon, box->max_lat, box->max_lon, output_file);
+
+    char *index_file = index_path_for(input_file);
+    spatial_index_t index;
+    if (!index_file || !spatial_index_load(&index, index_file))
+    {
+        mem_free(index_file);
+        return 1;
+    }
+    mem_free(index_file);
+
+    FILE *fin = fopen(input_file, "rb");
+    if (!fin)
+    {
+        fprintf(stderr, "ERROR: Cannot open input file '%s': %s\n", input_file, strerror(errno));
+        spatial_index_free(&index);
+        return 1;
+    }
+    file_header_t header;
+    if (!read_header(&header, fin) || header.count != index.record_count)
+    {
+        fprintf(stderr, "ERROR: Index does not match '%s' (rebuild it with --build-index)\n", input_file);
+        spatial_index_free(&index);
+        fclose(fin);
+        return 1;
+    }
+
+    create_output_directory("data");
+    FILE *fout = fopen(output_file, "w");
+    uint8_t *batch = (uint8_t*)mem_malloc((size_t)READ_BATCH_RECORDS * RECORD_SIZE);
+    weather_record_t *records = (weather_record_t*)mem_malloc(READ_BATCH_RECORDS * sizeof(weather_record_t));
+    derived_metrics_t *derived = (derived_metrics_t*)mem_malloc(READ_BATCH_RECORDS * sizeof(derived_metrics_t));
+    if (!fout || !batch || !records || !derived)
+    {
+        fprintf(stderr, "ERROR: Cannot open output file '%s': %s\n", output_file, strerror(errno));
+        if (fout)
+        {
+            fclose(fout);
+        }
+        mem_free(batch);
+        mem_free(records);
+        mem_free(derived);
+        spatial_index_free(&index);
+        fclose(fin);
+        return 1;
+    }
+    long count_offset = write_json_header_patchable(&header, fout);
+
+    // Overlapping rows are scanned with one binary search each; neighbouring
+    // cells of a row are contiguous in the file, so they are read as one range.
+    double lat0 = box->min_lat < -90.0 ? -90.0 : box->min_lat;
+    double lat1 = box->max_lat > 90.0 ? 90.0 : box->max_lat;
+    double lon0 = box->min_lon < -180.0 ? -180.0 : box->min_lon;
+    double lon1 = box->max_lon > 180.0 ? 180.0 : box->max_lon;
+    uint32_t row0 = clamp_grid(lat0, 90.0, index.cell_deg);
+    uint32_t row1 = clamp_grid(lat1, 90.0, index.cell_deg);
+    uint32_t col0 = clamp_grid(lon0, 180.0, index.cell_deg);
+    uint32_t col1 = clamp_grid(lon1, 180.0, index.cell_deg);
+
+    uint32_t cells_visited = 0;
+    uint64_t records_read = 0;
+    uint32_t matched = 0;
+    weather_record_t pending;
+    derived_metrics_t pending_derived;
+    int has_pending = 0;
+    int failed = 0;
+    for (uint64_t row = row0; row <= row1 && !failed && lat0 <= lat1 && lon0 <= lon1; row++)
+    {
+        uint64_t key_end = (row << 32) | col1;
+        uint32_t i = lower_bound_cell(&index, (row << 32) | col0);
+        while (i < index.n_cells && index.cells[i].cell <= key_end && !failed)
+        {
+            uint32_t first = index.cells[i].first;
+            uint32_t count = 0;
+            while (i < index.n_cells && index.cells[i].cell <= key_end &&
+                   index.cells[i].first == first + count)
+            {
+                count += index.cells[i].count;
+                cells_visited++;
+                i++;
+            }
+
+            if (seek_record(fin, first) != 0)
+            {
+                fprintf(stderr, "ERROR: Cannot seek to record %u: %s\n", first + 1, strerror(errno));
+                failed = 1;
+                break;
+            }
+            while (count > 0)
+            {
+                uint32_t want = count < READ_BATCH_RECORDS ? count : READ_BATCH_RECORDS;
+                uint32_t got = (uint32_t)fread(batch, RECORD_SIZE, want, fin);
+                if (got < want)
+                {
+                    fprintf(stderr, "ERROR: Failed to read record %u\n", first + got + 1);
+                    failed = 1;
+                    break;
+                }
+                decode_weather_batch(records, batch, got);
+                if (derive)
+                {
+                    derive_weather_batch(derived, records, got);
+                }
+                records_read += got;
+                for (uint32_t r = 0; r < got; r++)
+                {
+                    const weather_record_t *rec = &records[r];
+                    if (rec->lat < box->min_lat || rec->lat > box->max_lat ||
+                        rec->lon < box->min_lon || rec->lon > box->max_lon)
+                    {
+                        continue;
+                    }
+                    if (has_pending)
+                    {
+                        write_json_record_extra(&pending, derive ? &pending_derived : NULL, NULL, "", "", fout, 0);
+                    }
+                    pending = *rec;
+                    pending_derived = derived[r];
+                    has_pending = 1;
+                    matched++;
+                }
+                first += got;
+                count -= got;
+            }
+        }
+    }
+
+    if (has_pending)
+    {
+        write_json_record_extra(&pending, derive ? &pending_derived : NULL, NULL, "", "", fout, 1);
+    }
+    write_json_footer(fout);
+    patch_json_record_count(fout, count_offset, matched);
+    if (ferror(fout))
+    {
+        fprintf(stderr, "ERROR: Failed to write '%s'\n", output_file);
+        failed = 1;
+    }
+    fclose(fout);
+    fclose(fin);
+    mem_free(batch);
+    mem_free(records);
+    mem_free(derived);
+    spatial_index_free(&index);
+
+    if (failed)
+    {
+        return 1;
+    }
+    printf("SUCCESS: Matched %u records (read %llu of %u in %u cells)\n", matched,
+           (unsigned long long)records_read, header.count, cells_visited);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,384 @@
+/**
+ * @file spool_watch.c
+ * @brief Spool directory watcher implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "spool_watch.h"
+#include <stdio.h>
+
+#ifndef __linux__
+
+int spool_watch_run(const char *spool_dir, const char *output_dir, const char *archive_dir,
+                    const parse_options_t *opts, int n_workers)
+{
+    (void)spool_dir;
+    (void)output_dir;
+    (void)archive_dir;
+    (void)opts;
+    (void)n_workers;
+    fprintf(stderr, "ERROR: Watch mode needs inotify and is only supported on Linux\n");
+    return 1;
+}
+
+#else
+
+#include "conv_stats.h"
+#include "worker_pool.h"
+#include "mem_track.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SPOOL_EVENT_BUFFER_SIZE (64 * (sizeof(struct inotify_event) + NAME_MAX + 1))
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    char name[NAME_MAX + 1];
+    uint64_t id;
+    uint64_t t_queued;
+} spool_job_t;
+
+typedef struct {
+    const char *spool_dir;
+    const char *output_dir;
+    const char *archive_dir;
+    const parse_options_t *opts;
+} spool_config_t;
+
+typedef struct {
+    parse_workspace_t ws;
+    const spool_config_t *config;
+} spool_worker_t;
+
+/*********************
+ *  STATIC VARIABLES
+ *********************/
+static volatile sig_atomic_t stop_requested = 0;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static void on_stop_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+/**
+ * @brief Completed spool entries are visible "*.bin" files
+ */
+static int is_spool_input(const char *name)
+{
+    size_t len = strlen(name);
+    return name[0] != '.' && len > 4 && strcmp(name + len - 4, ".bin") == 0;
+}
+
+static int join_path(char *out, size_t size, const char *dir, const char *prefix,
+                     const char *name, size_t name_len, const char *suffix)
+{
+    int n = snprintf(out, size, "%s/%s%.*s%s", dir, prefix, (int)name_len, name, suffix);
+    return n > 0 && (size_t)n < size;
+}
+
+static void run_job(void *arg, void *worker_ctx)
+{
+    spool_job_t *job = (spool_job_t*)arg;
+    spool_worker_t *worker = (spool_worker_t*)worker_ctx;
+    const spool_config_t *cfg = worker->config;
+    size_t name_len = strlen(job->name);
+    size_t stem_len = name_len - 4;
+    char spooled[PATH_MAX];
+    char claimed[PATH_MAX];
+    char temp_out[PATH_MAX];
+    char output[PATH_MAX];
+    char archived[PATH_MAX];
+    char failed[PATH_MAX];
+
+    if (!join_path(spooled, sizeof(spooled), cfg->spool_dir, "", job->name, name_len, "") ||
+        !join_path(claimed, sizeof(claimed), cfg->spool_dir, ".", job->name, name_len, ".work") ||
+        !join_path(failed, sizeof(failed), cfg->spool_dir, ".", job->name, name_len, ".failed") ||
+        !join_path(temp_out, sizeof(temp_out), cfg->output_dir, ".", job->name, stem_len, ".json.tmp") ||
+        !join_path(output, sizeof(output), cfg->output_dir, "", job->name, stem_len, ".json") ||
+        !join_path(archived, sizeof(archived), cfg->archive_dir, "", job->name, name_len, ""))
+    {
+        fprintf(stderr, "ERROR: Path too long for spooled file '%s'\n", job->name);
+        mem_free(job);
+        return;
+    }
+
+    // Claim the file; ENOENT means another event already queued and took it
+    if (rename(spooled, claimed) != 0)
+    {
+        if (errno != ENOENT)
+        {
+            fprintf(stderr, "ERROR: Cannot claim '%s': %s\n", spooled, strerror(errno));
+        }
+        mem_free(job);
+        return;
+    }
+
+    // Jobs run concurrently, so each one counts into its own copy of the validator
+    parse_options_t opts = { 0 };
+    record_validator_t validator;
+    opts.quiet = 1;
+    opts.workspace = &worker->ws;
+    opts.dedup = cfg->opts->dedup;
+    opts.dedup_mem_limit = cfg->opts->dedup_mem_limit;
+    opts.derive = cfg->opts->derive;
+    opts.iso_time = cfg->opts->iso_time;
+    if (cfg->opts->validate)
+    {
+        validator = *cfg->opts->validate;
+        opts.validate = &validator;
+    }
+
+    conv_stats_t stats;
+    int rc = parse_weather_file_ex(claimed, temp_out, &opts, &stats);
+    if (rc == 0 && rename(temp_out, output) != 0)
+    {
+        fprintf(stderr, "ERROR: Cannot publish '%s': %s\n", output, strerror(errno));
+        rc = 1;
+    }
+    if (rc != 0)
+    {
+        // Park the input under a hidden name; moving it back would retrigger the watch
+        unlink(temp_out);
+        if (rename(claimed, failed) != 0)
+        {
+            fprintf(stderr, "ERROR: Cannot park failed input '%s': %s\n", claimed, strerror(errno));
+        }
+    }
+    else if (rename(claimed, archived) != 0)
+    {
+        fprintf(stderr, "ERROR: Cannot archive '%s' to '%s': %s\n", job->name, archived, strerror(errno));
+        rc = 1;
+    }
+    uint64_t latency_ns = stats_now_ns() - job->t_queued;
+
+    flockfile(stdout);
+    printf("job %llu rc=%d latency_ns=%llu ", (unsigned long long)job->id, rc,
+           (unsigned long long)latency_ns);
+    conv_stats_print_json(&stats, spooled, output, stdout);
+    fflush(stdout);
+    funlockfile(stdout);
+
+    mem_free(job);
+}
+
+static int submit_file(worker_pool_t *pool, const char *name, uint64_t *next_id)
+{
+    spool_job_t *job = (spool_job_t*)mem_malloc(sizeof(spool_job_t));
+    if (!job)
+    {
+        fprintf(stderr, "ERROR: Out of memory, skipping '%s'\n", name);
+        return 0;
+    }
+    strncpy(job->name, name, sizeof(job->name) - 1);
+    job->name[sizeof(job->name) - 1] = '\0';
+    job->id = (*next_id)++;
+    job->t_queued = stats_now_ns();
+    if (!worker_pool_submit(pool, job))
+    {
+        mem_free(job);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Queue every completed file currently in the spool
+ * 
+ * Used at startup and after an event queue overflow. Files that also get
+ * an event are claimed only once, so double submission is harmless.
+ */
+static void submit_existing(worker_pool_t *pool, const char *spool_dir, uint64_t *next_id)
+{
+    DIR *dir = opendir(spool_dir);
+    if (!dir)
+    {
+        fprintf(stderr, "ERROR: Cannot read spool directory '%s': %s\n", spool_dir, strerror(errno));
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (is_spool_input(entry->d_name))
+        {
+            submit_file(pool, entry->d_name, next_id);
+        }
+    }
+    closedir(dir);
+}
+
+static int is_directory(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int spool_watch_run(const char *spool_dir, const char *output_dir, const char *archive_dir,
+                    const parse_options_t *opts, int n_workers)
+{
+    const char *dirs[3] = { spool_dir, output_dir, archive_dir };
+    for (int i = 0; i < 3; i++)
+    {
+        if (!is_directory(dirs[i]))
+        {
+            fprintf(stderr, "ERROR: '%s' is not a directory\n", dirs[i]);
+            return 1;
+        }
+    }
+    if (n_workers <= 0)
+    {
+        n_workers = worker_pool_default_threads();
+    }
+
+    int in_fd = inotify_init1(IN_CLOEXEC);
+    if (in_fd < 0)
+    {
+        fprintf(stderr, "ERROR: inotify_init1: %s\n", strerror(errno));
+        return 1;
+    }
+    if (inotify_add_watch(in_fd, spool_dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) < 0)
+    {
+        fprintf(stderr, "ERROR: Cannot watch '%s': %s\n", spool_dir, strerror(errno));
+        close(in_fd);
+        return 1;
+    }
+
+    // One warm workspace per worker thread
+    spool_config_t config = { spool_dir, output_dir, archive_dir, opts };
+    spool_worker_t *workers = (spool_worker_t*)mem_calloc((size_t)n_workers, sizeof(spool_worker_t));
+    void **ctx = (void**)mem_calloc((size_t)n_workers, sizeof(void*));
+    int ok = workers && ctx;
+    for (int i = 0; ok && i < n_workers; i++)
+    {
+        ok = parse_workspace_init(&workers[i].ws);
+        workers[i].config = &config;
+        ctx[i] = &workers[i];
+    }
+
+    // Block the shutdown signals before the workers start so they inherit the
+    // mask; only pselect() in the event loop below lets them through
+    sigset_t stop_signals;
+    sigset_t old_mask;
+    sigset_t wait_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+    wait_mask = old_mask;
+    sigdelset(&wait_mask, SIGINT);
+    sigdelset(&wait_mask, SIGTERM);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    worker_pool_t pool;
+    if (!ok || !worker_pool_start(&pool, n_workers, SPOOL_WATCH_QUEUE_DEPTH, run_job, ctx))
+    {
+        fprintf(stderr, "ERROR: Cannot start %d workers\n", n_workers);
+        ok = 0;
+    }
+    int started = ok;
+
+    uint64_t next_id = 1;
+    char *events = (char*)mem_malloc(SPOOL_EVENT_BUFFER_SIZE);
+    ok = ok && events;
+    if (ok)
+    {
+        // The watch is already active, so nothing written from here on is missed
+        submit_existing(&pool, spool_dir, &next_id);
+        printf("Watching %s with %d workers (output %s, archive %s)\n",
+               spool_dir, n_workers, output_dir, archive_dir);
+        fflush(stdout);
+    }
+    while (ok && !stop_requested)
+    {
+        // A signal arriving before pselect() is still pending, so it interrupts it
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(in_fd, &readable);
+        if (pselect(in_fd + 1, &readable, NULL, NULL, NULL, &wait_mask) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "ERROR: pselect: %s\n", strerror(errno));
+            ok = 0;
+            break;
+        }
+        ssize_t len = read(in_fd, events, SPOOL_EVENT_BUFFER_SIZE);
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "ERROR: Reading inotify events: %s\n", strerror(errno));
+            ok = 0;
+        }
+        for (ssize_t pos = 0; pos < len; )
+        {
+            const struct inotify_event *ev = (const struct inotify_event*)(events + pos);
+            pos += (ssize_t)(sizeof(struct inotify_event) + ev->len);
+            if (ev->mask & IN_Q_OVERFLOW)
+            {
+                fprintf(stderr, "WARNING: inotify queue overflow, rescanning '%s'\n", spool_dir);
+                submit_existing(&pool, spool_dir, &next_id);
+            }
+            else if (ev->mask & IN_IGNORED)
+            {
+                fprintf(stderr, "ERROR: Spool directory '%s' is gone\n", spool_dir);
+                ok = 0;
+            }
+            else if (ev->len > 0 && !(ev->mask & IN_ISDIR) && is_spool_input(ev->name))
+            {
+                submit_file(&pool, ev->name, &next_id);
+            }
+        }
+    }
+
+    close(in_fd);
+    mem_free(events);
+    if (started)
+    {
+        // Finish the files already queued before exiting
+        worker_pool_stop(&pool);
+        printf("Watch stopped after %llu jobs\n", (unsigned long long)(next_id - 1));
+    }
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    for (int i = 0; workers && i < n_workers; i++)
+    {
+        parse_workspace_free(&workers[i].ws);
+    }
+    mem_free(workers);
+    mem_free(ctx);
+    return ok ? 0 : 1;
+}
+
+#endif
\ No newline at end of file
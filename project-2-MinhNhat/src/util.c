@@ -0,0 +1,46 @@
+/**
+ * @file util.c
+ * @brief Shared helper implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "util.h"
+#include "mem_track.h"
+#include <errno.h>
+#include <stdio.h>
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+char* util_read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        return NULL;
+    }
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0)
+    {
+        size = ftell(f);
+    }
+    char *text = NULL;
+    if (size >= 0 && fseek(f, 0, SEEK_SET) == 0)
+    {
+        text = (char*)mem_malloc((size_t)size + 1);
+    }
+    if (text && fread(text, 1, (size_t)size, f) != (size_t)size)
+    {
+        mem_free(text);
+        text = NULL;
+        errno = EIO;
+    }
+    if (text)
+    {
+        text[size] = '\0';
+    }
+    fclose(f);
+    return text;
+}
\ No newline at end of file
@@ -9,10 +9,18 @@
 #include "weather_parser.h"
 #include "binary_io.h"
 #include "json_writer.h"
+#include "mem_track.h"
+#include "dedup.h"
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
 
+/*********************
+ *      DEFINES
+ *********************/
+#define DECODE_CHUNK 64
+#define PROGRESS(...) do { if (!opts->quiet) printf(__VA_ARGS__); } while (0)
+
 /*********************
  *    FUNCTIONS
  *********************/
@@ -69,6 +77,171 @@ int read_weather_record(weather_record_t *record, FILE *f)
            read_f32_le(&record->light, f);
 }
 
+void decode_weather_record(weather_record_t *record, const uint8_t *buf)
+{
+    record->sensor_id   = load_u32_le(buf + 0);
+    record->battery     = buf[4];
+    record->timestamp   = load_u32_le(buf + 5);
+    record->lat         = load_f64_le(buf + 9);
+    record->lon         = load_f64_le(buf + 17);
+    record->temperature = load_f32_le(buf + 25);
+    record->humidity    = load_f32_le(buf + 29);
+    record->pressure    = load_f32_le(buf + 33);
+    record->co2         = load_u16_le(buf + 37);
+    record->wind_speed  = load_f32_le(buf + 39);
+    record->wind_dir    = load_u16_le(buf + 43);
+    record->rain        = load_f32_le(buf + 45);
+    record->uv          = load_f32_le(buf + 49);
+    record->light       = load_f32_le(buf + 53);
+}
+
+void decode_weather_batch(weather_record_t *records, const uint8_t *buf, size_t n)
+{
+    uint64_t u64[DECODE_CHUNK];
+    uint32_t u32[DECODE_CHUNK];
+    uint16_t u16[DECODE_CHUNK];
+
+    for (size_t base = 0; base < n; base += DECODE_CHUNK)
+    {
+        size_t m = (n - base < DECODE_CHUNK) ? n - base : DECODE_CHUNK;
+        const uint8_t *p = buf + base * RECORD_SIZE;
+        weather_record_t *r = records + base;
+
+        #define GATHER_U32(offset, field)                                \
+            load_u32_le_strided(u32, p + (offset), RECORD_SIZE, m);      \
+            for (size_t i = 0; i < m; i++) { r[i].field = u32[i]; }
+        #define GATHER_F32(offset, field)                                \
+            load_u32_le_strided(u32, p + (offset), RECORD_SIZE, m);      \
+            for (size_t i = 0; i < m; i++) { memcpy(&r[i].field, &u32[i], 4); }
+        #define GATHER_F64(offset, field)                                \
+            load_u64_le_strided(u64, p + (offset), RECORD_SIZE, m);      \
+            for (size_t i = 0; i < m; i++) { memcpy(&r[i].field, &u64[i], 8); }
+        #define GATHER_U16(offset, field)                                \
+            load_u16_le_strided(u16, p + (offset), RECORD_SIZE, m);      \
+            for (size_t i = 0; i < m; i++) { r[i].field = u16[i]; }
+
+        GATHER_U32(0, sensor_id)
+        for (size_t i = 0; i < m; i++) { r[i].battery = p[i * RECORD_SIZE + 4]; }
+        GATHER_U32(5, timestamp)
+        GATHER_F64(9, lat)
+        GATHER_F64(17, lon)
+        GATHER_F32(25, temperature)
+        GATHER_F32(29, humidity)
+        GATHER_F32(33, pressure)
+        GATHER_U16(37, co2)
+        GATHER_F32(39, wind_speed)
+        GATHER_U16(43, wind_dir)
+        GATHER_F32(45, rain)
+        GATHER_F32(49, uv)
+        GATHER_F32(53, light)
+
+        #undef GATHER_U32
+        #undef GATHER_F32
+        #undef GATHER_F64
+        #undef GATHER_U16
+    }
+}
+
+uint64_t record_key(uint32_t sensor_id, uint32_t timestamp)
+{
+    return ((uint64_t)sensor_id << 32) | timestamp;
+}
+
+uint64_t record_key_packed(const uint8_t *packed)
+{
+    return record_key(load_u32_le(packed), load_u32_le(packed + 5));
+}
+
+void encode_weather_record(uint8_t *buf, const weather_record_t *record)
+{
+    store_u32_le(buf + 0, record->sensor_id);
+    buf[4] = record->battery;
+    store_u32_le(buf + 5, record->timestamp);
+    store_f64_le(buf + 9, record->lat);
+    store_f64_le(buf + 17, record->lon);
+    store_f32_le(buf + 25, record->temperature);
+    store_f32_le(buf + 29, record->humidity);
+    store_f32_le(buf + 33, record->pressure);
+    store_u16_le(buf + 37, record->co2);
+    store_f32_le(buf + 39, record->wind_speed);
+    store_u16_le(buf + 43, record->wind_dir);
+    store_f32_le(buf + 45, record->rain);
+    store_f32_le(buf + 49, record->uv);
+    store_f32_le(buf + 53, record->light);
+}
+
+int analyze_enabled(const parse_options_t *opts)
+{
+    return opts->enrich || opts->derive || opts->anomaly || opts->sketches || opts->snapshot || opts->alerts;
+}
+
+int analyze_weather_batch(const parse_options_t *opts, weather_record_t *records,
+                          derived_metrics_t *derived, size_t n, uint64_t first_ordinal)
+{
+    if (opts->enrich)
+    {
+        sensor_meta_join(opts->enrich, records, n);
+    }
+    if (opts->derive)
+    {
+        derive_weather_batch(derived, records, n);
+    }
+    if (opts->anomaly && !rolling_stats_update_batch(opts->anomaly, records, n, first_ordinal))
+    {
+        fprintf(stderr, "ERROR: Out of memory in rolling stats\n");
+        return 0;
+    }
+    if (opts->alerts && !alert_rules_eval_batch(opts->alerts, records, n, first_ordinal))
+    {
+        fprintf(stderr, "ERROR: Out of memory in alert rules\n");
+        return 0;
+    }
+    for (size_t i = 0; opts->sketches && i < n; i++)
+    {
+        if (!sketch_table_add_record(opts->sketches, &records[i]))
+        {
+            fprintf(stderr, "ERROR: Out of memory in quantile sketches\n");
+            return 0;
+        }
+    }
+    if (opts->snapshot && !sensor_snapshot_update_batch(opts->snapshot, records, n))
+    {
+        return 0;
+    }
+    return 1;
+}
+
+size_t validate_weather_records(const parse_options_t *opts, weather_record_t *records,
+                                uint16_t *invalid, size_t n, conv_stats_t *stats)
+{
+    uint64_t invalid_before = opts->validate->invalid;
+    size_t kept = validate_weather_batch(opts->validate, records, invalid, n);
+    if (stats)
+    {
+        stats->invalid += opts->validate->invalid - invalid_before;
+    }
+    return kept;
+}
+
+void write_weather_json(const parse_options_t *opts, const weather_record_t *record,
+                        const derived_metrics_t *derived, uint16_t invalid,
+                        iso_time_cache_t *times, FILE *f, int is_last)
+{
+    int tag = invalid && opts->validate && opts->validate->action == VALIDATE_TAG;
+    if (opts->enrich || opts->derive || opts->iso_time || tag)
+    {
+        char tags[VALIDATE_TAGS_JSON_SIZE];
+        write_json_record_extra(record, opts->derive ? derived : NULL, opts->iso_time ? times : NULL,
+                                tag ? validate_tags_json(invalid, tags, sizeof(tags)) : "",
+                                opts->enrich ? sensor_meta_station_json(opts->enrich, record->sensor_id) : "",
+                                f, is_last);
+    }
+    else
+    {
+        write_json_record(record, f, is_last);
+    }
+}
+
 int validate_file_size(FILE *f, uint32_t record_count)
 {
     long current_pos = ftell(f);
@@ -98,9 +271,110 @@ int validate_file_size(FILE *f, uint32_t record_count)
     return 1;
 }
 
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+
+/*
+ * Drops duplicate records from a packed batch in place. Either the
+ * in-memory set or the dup bitmap from the partitioned pass is used.
+ */
+static uint32_t filter_duplicates(uint8_t *batch, uint32_t n, uint32_t first_ordinal,
+                                  dedup_set_t *seen, const uint8_t *dup_bitmap,
+                                  uint64_t *dups, int *oom)
+{
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const uint8_t *rec = batch + (size_t)i * RECORD_SIZE;
+        int keep;
+        if (dup_bitmap)
+        {
+            uint32_t ord = first_ordinal + i;
+            keep = !(dup_bitmap[ord >> 3] & (1u << (ord & 7)));
+        }
+        else
+        {
+            int r = dedup_set_insert(seen, record_key_packed(rec));
+            if (r < 0)
+            {
+                *oom = 1;
+                return kept;
+            }
+            keep = r;
+        }
+
+        if (!keep)
+        {
+            (*dups)++;
+            continue;
+        }
+        if (kept != i)
+        {
+            memcpy(batch + (size_t)kept * RECORD_SIZE, rec, RECORD_SIZE);
+        }
+        kept++;
+    }
+    return kept;
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int parse_workspace_init(parse_workspace_t *ws)
+{
+    ws->batch = (uint8_t*)mem_malloc((size_t)READ_BATCH_RECORDS * RECORD_SIZE);
+    ws->records = (weather_record_t*)mem_malloc(READ_BATCH_RECORDS * sizeof(weather_record_t));
+    ws->derived = (derived_metrics_t*)mem_malloc(READ_BATCH_RECORDS * sizeof(derived_metrics_t));
+    ws->invalid = (uint16_t*)mem_malloc(READ_BATCH_RECORDS * sizeof(uint16_t));
+    ws->out_buf = (char*)mem_malloc(PARSE_OUTPUT_BUFFER_SIZE);
+    if (!ws->batch || !ws->records || !ws->derived || !ws->invalid || !ws->out_buf)
+    {
+        parse_workspace_free(ws);
+        return 0;
+    }
+    return 1;
+}
+
+void parse_workspace_free(parse_workspace_t *ws)
+{
+    mem_free(ws->batch);
+    mem_free(ws->records);
+    mem_free(ws->derived);
+    mem_free(ws->invalid);
+    mem_free(ws->out_buf);
+    ws->batch = NULL;
+    ws->records = NULL;
+    ws->derived = NULL;
+    ws->invalid = NULL;
+    ws->out_buf = NULL;
+}
+
 int parse_weather_file(const char *input_file, const char *output_file)
 {
-    printf("Converting: %s -> %s\n", input_file, output_file);
+    return parse_weather_file_ex(input_file, output_file, NULL, NULL);
+}
+
+int parse_weather_file_ex(const char *input_file, const char *output_file,
+                          const parse_options_t *opts, conv_stats_t *stats)
+{
+    static const parse_options_t default_opts = { 0 };
+    if (!opts)
+    {
+        opts = &default_opts;
+    }
+
+    uint64_t t_start = 0;
+    uint64_t t_mark = 0;
+    uint64_t anomalies_before = opts->anomaly ? rolling_stats_flagged(opts->anomaly) : 0;
+    if (stats)
+    {
+        memset(stats, 0, sizeof(*stats));
+        t_start = stats_now_ns();
+        mem_window_reset();
+    }
+
+    PROGRESS("Converting: %s -> %s\n", input_file, output_file);
     
     // Open input file
     FILE *fin = fopen(input_file, "rb");
@@ -120,9 +394,9 @@ int parse_weather_file(const char *input_file, const char *output_file)
         return 1;
     }
     
-    printf("File ID: %s\n", header.file_id);
-    printf("Version: %u\n", header.version);
-    printf("Record count: %u\n", header.count);
+    PROGRESS("File ID: %s\n", header.file_id);
+    PROGRESS("Version: %u\n", header.version);
+    PROGRESS("Record count: %u\n", header.count);
     
     // Validate file size (optional but recommended)
     validate_file_size(fin, header.count);
@@ -139,41 +413,244 @@ int parse_weather_file(const char *input_file, const char *output_file)
         fclose(fin);
         return 1;
     }
+
+    // Borrow the caller's warm buffers when given, else allocate for this call
+    parse_workspace_t local_ws = { 0 };
+    parse_workspace_t *ws = opts->workspace;
+    if (!ws)
+    {
+        ws = &local_ws;
+        if (!parse_workspace_init(ws))
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            fclose(fin);
+            fclose(fout);
+            return 1;
+        }
+    }
+    uint8_t *batch = ws->batch;
+    weather_record_t *records = ws->records;
+    derived_metrics_t *derived = ws->derived;
+    uint16_t *invalid = ws->invalid;
+    setvbuf(fout, ws->out_buf, _IOFBF, PARSE_OUTPUT_BUFFER_SIZE);
+
+    // Dedup: in-memory key set if it fits the limit, else spill to partitions first
+    dedup_set_t seen = { 0 };
+    uint8_t *dup_bitmap = NULL;
+    uint64_t duplicates = 0;
+    int dedup_failed = 0;
+    if (opts->dedup)
+    {
+        size_t limit = opts->dedup_mem_limit ? opts->dedup_mem_limit : DEDUP_DEFAULT_MEM_LIMIT;
+        size_t needed = dedup_set_bytes(header.count);
+        if (needed <= limit)
+        {
+            dedup_failed = !dedup_set_init(&seen, header.count < 65536 ? header.count : 65536);
+        }
+        else
+        {
+            unsigned partitions = (unsigned)(needed / limit) + 1;
+            PROGRESS("Dedup: spilling keys to %u partitions\n", partitions);
+            dup_bitmap = (uint8_t*)mem_calloc(((size_t)header.count + 7) / 8, 1);
+            dedup_failed = !dup_bitmap ||
+                           !dedup_mark_partitioned(fin, HEADER_SIZE, header.count, partitions,
+                                                   dup_bitmap, &duplicates);
+            duplicates = 0; // counted again as records are skipped
+        }
+        if (dedup_failed)
+        {
+            fprintf(stderr, "ERROR: Dedup setup failed\n");
+            dedup_set_free(&seen);
+            mem_free(dup_bitmap);
+            fclose(fin);
+            fclose(fout);
+            parse_workspace_free(&local_ws);
+            return 1;
+        }
+    }
     
-    // Write JSON header
-    write_json_header(&header, fout);
+    // Write JSON header. When records can be filtered out, the count is
+    // patched to the number actually written once the loop is done.
+    int filtering = opts->dedup || (opts->validate && (opts->validate->action == VALIDATE_DROP ||
+                                                       opts->validate->action == VALIDATE_CLAMP));
+    long count_offset = -1;
+    if (filtering)
+    {
+        count_offset = write_json_header_patchable(&header, fout);
+    }
+    else
+    {
+        write_json_header(&header, fout);
+    }
     
-    // Process records
+    // Process records batch by batch: read -> decode -> write.
+    // The last written record is held back so it can close the array
+    // without a trailing comma, even when records are filtered out.
     uint32_t records_processed = 0;
-    for (uint32_t i = 0; i < header.count; i++)
+    uint32_t records_written = 0;
+    weather_record_t pending;
+    derived_metrics_t pending_derived;
+    uint16_t pending_invalid = 0;
+    iso_time_cache_t times = { 0 };
+    int has_pending = 0;
+    int aborted = 0;
+    while (records_processed < header.count)
     {
-        weather_record_t record;
-        
-        if (!read_weather_record(&record, fin))
+        if (!mem_within_budget(opts->mem_budget))
         {
-            fprintf(stderr, "ERROR: Failed to read record %u\n", i + 1);
+            fprintf(stderr, "ERROR: Memory budget of %zu bytes exceeded (heap %zu, peak RSS %zu)\n",
+                    opts->mem_budget, mem_live_bytes(), mem_peak_rss_bytes());
+            aborted = 1;
+            break;
+        }
+
+        uint32_t want = header.count - records_processed;
+        if (want > READ_BATCH_RECORDS)
+        {
+            want = READ_BATCH_RECORDS;
+        }
+
+        if (stats)
+        {
+            t_mark = stats_now_ns();
+        }
+        size_t bytes = fread(batch, 1, (size_t)want * RECORD_SIZE, fin);
+        uint32_t got = (uint32_t)(bytes / RECORD_SIZE);
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_READ, &t_mark);
+            stats->bytes_read += bytes;
+            if (got < want)
+            {
+                stats->short_reads++;
+            }
+        }
+
+        uint32_t kept = got;
+        if (opts->dedup)
+        {
+            kept = filter_duplicates(batch, got, records_processed, &seen, dup_bitmap,
+                                     &duplicates, &dedup_failed);
+            if (dedup_failed)
+            {
+                fprintf(stderr, "ERROR: Out of memory in dedup set\n");
+                aborted = 1;
+                break;
+            }
+        }
+
+        decode_weather_batch(records, batch, kept);
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_DECODE, &t_mark);
+        }
+
+        if (opts->validate)
+        {
+            kept = (uint32_t)validate_weather_records(opts, records, invalid, kept, stats);
+            if (stats)
+            {
+                conv_stats_end_stage(stats, STAGE_VALIDATE, &t_mark);
+            }
+        }
+
+        if (analyze_enabled(opts))
+        {
+            if (!analyze_weather_batch(opts, records, derived, kept, records_written))
+            {
+                aborted = 1;
+                break;
+            }
+            if (stats)
+            {
+                conv_stats_end_stage(stats, STAGE_ANALYZE, &t_mark);
+            }
+        }
+
+        if (kept > 0)
+        {
+            if (has_pending)
+            {
+                write_weather_json(opts, &pending, &pending_derived, pending_invalid, &times, fout, 0);
+            }
+            for (uint32_t i = 0; i + 1 < kept; i++)
+            {
+                write_weather_json(opts, &records[i], &derived[i], opts->validate ? invalid[i] : 0, &times, fout, 0);
+            }
+            pending = records[kept - 1];
+            pending_derived = derived[kept - 1];
+            pending_invalid = opts->validate ? invalid[kept - 1] : 0;
+            has_pending = 1;
+            records_written += kept;
+        }
+        if (stats)
+        {
+            conv_stats_end_stage(stats, STAGE_WRITE, &t_mark);
+        }
+        records_processed += got;
+
+        if (got < want)
+        {
+            fprintf(stderr, "ERROR: Failed to read record %u\n", records_processed + 1);
             break;
         }
-        
-        write_json_record(&record, fout, (i == header.count - 1));
-        records_processed++;
     }
     
+    if (has_pending)
+    {
+        write_weather_json(opts, &pending, &pending_derived, pending_invalid, &times, fout, 1);
+    }
+
     // Write JSON footer
     write_json_footer(fout);
+    if (filtering && patch_json_record_count(fout, count_offset, records_written) != 0)
+    {
+        fprintf(stderr, "WARNING: Output is not seekable, record_count left at %u\n", header.count);
+    }
     
+    if (stats)
+    {
+        long out_size = ftell(fout);
+        stats->bytes_read += HEADER_SIZE;
+        stats->bytes_written = out_size > 0 ? (uint64_t)out_size : 0;
+        stats->records = records_processed;
+        stats->duplicates = duplicates;
+        stats->heap_peak_bytes = mem_peak_bytes();
+        stats->anomalies = opts->anomaly ? rolling_stats_flagged(opts->anomaly) - anomalies_before : 0;
+    }
+
+    if (opts->dedup)
+    {
+        PROGRESS("Dedup: dropped %llu duplicate records, wrote %u\n",
+               (unsigned long long)duplicates, records_written);
+    }
+
     // Cleanup
+    dedup_set_free(&seen);
+    mem_free(dup_bitmap);
     fclose(fin);
     fclose(fout);
+    parse_workspace_free(&local_ws);
+
+    if (stats)
+    {
+        stats->total_ns = stats_now_ns() - t_start;
+        stats->rss_peak_bytes = mem_peak_rss_bytes();
+    }
+
+    if (aborted)
+    {
+        return 1;
+    }
     
     if (records_processed == header.count)
     {
-        printf("SUCCESS: Converted %u records to JSON format\n", records_processed);
+        PROGRESS("SUCCESS: Converted %u records to JSON format\n", records_processed);
         return 0;
     } 
     else
     {
-        printf("WARNING: Only processed %u out of %u records\n", 
+        PROGRESS("WARNING: Only processed %u out of %u records\n", 
                records_processed, header.count);
         return 1;
     }
@@ -0,0 +1,165 @@
+/**
+ * @file worker_pool.c
+ * @brief Thread pool implementation
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "worker_pool.h"
+#include "mem_track.h"
+#include <string.h>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    worker_pool_t *pool;
+    int index;
+} worker_arg_t;
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static void* worker_main(void *arg)
+{
+    worker_arg_t *wa = (worker_arg_t*)arg;
+    worker_pool_t *pool = wa->pool;
+    void *ctx = pool->worker_ctx ? pool->worker_ctx[wa->index] : NULL;
+    mem_free(wa);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->count == 0 && !pool->stopping)
+        {
+            pthread_cond_wait(&pool->not_empty, &pool->lock);
+        }
+        if (pool->count == 0 && pool->stopping)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        void *job = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+        pthread_cond_signal(&pool->not_full);
+        pthread_mutex_unlock(&pool->lock);
+
+        pool->fn(job, ctx);
+    }
+}
+
+/*********************
+ *    FUNCTIONS
+ *********************/
+int worker_pool_start(worker_pool_t *pool, int n_threads, size_t capacity,
+                      worker_job_fn fn, void **worker_ctx)
+{
+    memset(pool, 0, sizeof(*pool));
+    if (n_threads < 1)
+    {
+        n_threads = 1;
+    }
+    if (capacity < 1)
+    {
+        capacity = 1;
+    }
+    pool->fn = fn;
+    pool->worker_ctx = worker_ctx;
+    pool->capacity = capacity;
+    pool->queue = (void**)mem_calloc(capacity, sizeof(void*));
+    pool->threads = (pthread_t*)mem_calloc((size_t)n_threads, sizeof(pthread_t));
+    if (!pool->queue || !pool->threads)
+    {
+        mem_free(pool->queue);
+        mem_free(pool->threads);
+        return 0;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->not_empty, NULL);
+    pthread_cond_init(&pool->not_full, NULL);
+
+    for (int i = 0; i < n_threads; i++)
+    {
+        worker_arg_t *wa = (worker_arg_t*)mem_malloc(sizeof(worker_arg_t));
+        if (!wa)
+        {
+            break;
+        }
+        wa->pool = pool;
+        wa->index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, wa) != 0)
+        {
+            mem_free(wa);
+            break;
+        }
+        pool->n_threads++;
+    }
+    if (pool->n_threads == 0)
+    {
+        worker_pool_stop(pool);
+        return 0;
+    }
+    return 1;
+}
+
+int worker_pool_submit(worker_pool_t *pool, void *job)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->count == pool->capacity && !pool->stopping)
+    {
+        pthread_cond_wait(&pool->not_full, &pool->lock);
+    }
+    if (pool->stopping)
+    {
+        pthread_mutex_unlock(&pool->lock);
+        return 0;
+    }
+    pool->queue[(pool->head + pool->count) % pool->capacity] = job;
+    pool->count++;
+    pthread_cond_signal(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+    return 1;
+}
+
+void worker_pool_stop(worker_pool_t *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->not_empty);
+    pthread_cond_broadcast(&pool->not_full);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->n_threads; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->not_empty);
+    pthread_cond_destroy(&pool->not_full);
+    mem_free(pool->queue);
+    mem_free(pool->threads);
+    pool->queue = NULL;
+    pool->threads = NULL;
+    pool->n_threads = 0;
+}
+
+int worker_pool_default_threads(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+/**
+ * @file shm_producer.c
+ * @brief Reference producer for weather_parser --shm
+ *
+ * Creates a shared-memory ring and streams the records of a .bin file
+ * into it, standing in for the gateway receiver during testing.
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "shm_ring.h"
+#include "weather_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static void print_usage(const char *program_name)
+{
+    printf("Usage: %s [options] ring_name input.bin\n", program_name);
+    printf("\n");
+    printf("Options:\n");
+    printf("  -h, --help      Show this help\n");
+    printf("  --capacity N    Ring slots in records (default %u)\n", SHM_RING_DEFAULT_CAPACITY);
+    printf("  --batch N       Records published at a time (default %u)\n", READ_BATCH_RECORDS);
+    printf("\n");
+    printf("Start weather_parser --shm ring_name output.json to consume the stream.\n");
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+int main(int argc, char **argv)
+{
+    uint32_t capacity = SHM_RING_DEFAULT_CAPACITY;
+    uint32_t batch = READ_BATCH_RECORDS;
+    const char *positionals[2];
+    int n_positionals = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--capacity") == 0 && i + 1 < argc)
+        {
+            capacity = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+        {
+            batch = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (argv[i][0] == '-' && argv[i][1] == '-')
+        {
+            fprintf(stderr, "ERROR: Unknown option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+        else if (n_positionals < 2)
+        {
+            positionals[n_positionals++] = argv[i];
+        }
+    }
+    if (n_positionals != 2 || batch == 0)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    FILE *fin = fopen(positionals[1], "rb");
+    if (!fin)
+    {
+        fprintf(stderr, "ERROR: Cannot open input file '%s'\n", positionals[1]);
+        return 1;
+    }
+    file_header_t header;
+    if (!read_header(&header, fin))
+    {
+        fprintf(stderr, "ERROR: Failed to read file header\n");
+        fclose(fin);
+        return 1;
+    }
+
+    shm_ring_t ring;
+    if (!shm_ring_create(&ring, positionals[0], capacity, &header))
+    {
+        fclose(fin);
+        return 1;
+    }
+
+    uint32_t sent = 0;
+    while (sent < header.count)
+    {
+        uint32_t space;
+        uint8_t *slots = shm_ring_write_space(&ring, &space);
+        if (space == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        uint32_t want = header.count - sent;
+        want = want < batch ? want : batch;
+        want = want < space ? want : space;
+        uint32_t got = (uint32_t)(fread(slots, RECORD_SIZE, want, fin));
+        shm_ring_publish(&ring, got);
+        sent += got;
+        if (got < want)
+        {
+            fprintf(stderr, "WARNING: Input ended after %u of %u records\n", sent, header.count);
+            break;
+        }
+    }
+    shm_ring_close(&ring);
+    shm_ring_detach(&ring);
+    fclose(fin);
+
+    printf("Published %u records to %s\n", sent, positionals[0]);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,408 @@
+/**
+ * @file weather_bench.c
+ * @brief Benchmark harness for the decode/encode kernels
+ *
+ * Measures read_weather_record, decode_weather_batch, derive_weather_batch, write_json_record,
+ * cJSON_Parse and cJSON_Print over the same set of records, optionally with hardware
+ * performance counters around each stage.
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "weather_parser.h"
+#include "binary_io.h"
+#include "json_writer.h"
+#include "conv_stats.h"
+#include "perf_counters.h"
+#include "cpu_dispatch.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define DEFAULT_RECORDS    100000u
+#define DEFAULT_ITERATIONS 3
+
+/*********************
+ *      ENUMS
+ *********************/
+typedef enum {
+    BENCH_READ_RECORD = 0,
+    BENCH_DECODE_BATCH,
+    BENCH_DERIVE_BATCH,
+    BENCH_WRITE_JSON,
+    BENCH_CJSON_PARSE,
+    BENCH_CJSON_PRINT,
+    BENCH_STAGE_COUNT
+} bench_stage_t;
+
+/*********************
+ *      STRUCTS
+ *********************/
+typedef struct {
+    uint64_t ns;
+    uint64_t bytes;
+    uint64_t counters[PERF_EVENT_COUNT];
+} bench_result_t;
+
+/*********************
+ *  STATIC VARIABLES
+ *********************/
+static const char *stage_names[BENCH_STAGE_COUNT] = {
+    "read_weather_record",
+    "decode_weather_batch",
+    "derive_weather_batch",
+    "write_json_record",
+    "cJSON_Parse",
+    "cJSON_Print",
+};
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+static void print_usage(const char *program_name)
+{
+    printf("Usage: %s [options] [input_file]\n", program_name);
+    printf("\n");
+    printf("Arguments:\n");
+    printf("  input_file        Binary weather file to benchmark (default: synthetic records)\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  --records N       Number of synthetic records (default: %u)\n", DEFAULT_RECORDS);
+    printf("  --iterations N    Repetitions per stage, results are averaged (default: %d)\n", DEFAULT_ITERATIONS);
+    printf("  --perf            Read hardware counters (cycles, instructions, misses)\n");
+    printf("  --simd LEVEL      Cap SIMD kernels at scalar, sse4.2, avx2 or avx512\n");
+    printf("\n");
+}
+
+static uint32_t lcg_next(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state;
+}
+
+static float lcg_range(uint32_t *state, float lo, float hi)
+{
+    return lo + (hi - lo) * (float)(lcg_next(state) >> 8) / (float)(1u << 24);
+}
+
+static FILE* make_synthetic_file(uint32_t count)
+{
+    FILE *f = tmpfile();
+    if (!f)
+    {
+        return NULL;
+    }
+
+    uint8_t header[HEADER_SIZE];
+    memcpy(header, "WTHR", FILE_ID_SIZE);
+    store_u16_le(header + 4, 1);
+    store_u32_le(header + 6, count);
+    fwrite(header, 1, HEADER_SIZE, f);
+
+    uint32_t seed = 12345u;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        weather_record_t r;
+        uint8_t buf[RECORD_SIZE];
+        r.sensor_id = 1 + lcg_next(&seed) % 500;
+        r.battery = (uint8_t)(lcg_next(&seed) % 3);
+        r.timestamp = 1704067200u + i * 10u;
+        r.lat = 10.0 + lcg_range(&seed, 0.0f, 1.0f);
+        r.lon = 106.0 + lcg_range(&seed, 0.0f, 1.0f);
+        r.temperature = lcg_range(&seed, 20.0f, 35.0f);
+        r.humidity = lcg_range(&seed, 40.0f, 95.0f);
+        r.pressure = lcg_range(&seed, 1000.0f, 1020.0f);
+        r.co2 = (uint16_t)(350 + lcg_next(&seed) % 2000);
+        r.wind_speed = lcg_range(&seed, 0.0f, 15.0f);
+        r.wind_dir = (uint16_t)(lcg_next(&seed) % 360);
+        r.rain = lcg_range(&seed, 0.0f, 5.0f);
+        r.uv = lcg_range(&seed, 0.0f, 12.0f);
+        r.light = lcg_range(&seed, 0.0f, 60000.0f);
+        encode_weather_record(buf, &r);
+        fwrite(buf, 1, RECORD_SIZE, f);
+    }
+    return f;
+}
+
+static void stage_begin(perf_counters_t *pc, uint64_t *t0)
+{
+    if (pc)
+    {
+        perf_counters_start(pc);
+    }
+    *t0 = stats_now_ns();
+}
+
+static void stage_end(perf_counters_t *pc, uint64_t t0, uint64_t bytes, bench_result_t *res)
+{
+    res->ns += stats_now_ns() - t0;
+    res->bytes += bytes;
+    if (pc)
+    {
+        perf_counters_stop(pc);
+        for (int e = 0; e < PERF_EVENT_COUNT; e++)
+        {
+            res->counters[e] += pc->values[e];
+        }
+    }
+}
+
+static void print_results(const bench_result_t *res, uint32_t count, int iterations,
+                          const perf_counters_t *pc)
+{
+    double recs = (double)count * iterations;
+
+    printf("\n%-20s %10s %10s %10s", "stage", "ns/rec", "ns/byte", "MB/s");
+    if (pc)
+    {
+        printf(" %11s %11s %6s %10s %10s %10s",
+               "cycles/rec", "instr/rec", "IPC", "brmiss/rec", "L1dmiss/KB", "LLCmiss/KB");
+    }
+    printf("\n");
+
+    for (int s = 0; s < BENCH_STAGE_COUNT; s++)
+    {
+        const bench_result_t *r = &res[s];
+        double ns_per_byte = r->bytes ? (double)r->ns / (double)r->bytes : 0.0;
+        double mbps = r->ns ? (double)r->bytes * 1e3 / (double)r->ns : 0.0;
+        printf("%-20s %10.1f %10.3f %10.1f", stage_names[s], (double)r->ns / recs, ns_per_byte, mbps);
+        if (pc)
+        {
+            double kb = (double)r->bytes / 1024.0;
+            const uint64_t *c = r->counters;
+            char ipc[16] = "n/a";
+            if (pc->available[PERF_CYCLES] && pc->available[PERF_INSTRUCTIONS] && c[PERF_CYCLES])
+            {
+                snprintf(ipc, sizeof(ipc), "%.2f", (double)c[PERF_INSTRUCTIONS] / (double)c[PERF_CYCLES]);
+            }
+            printf(" %11.1f %11.1f %6s %10.3f %10.2f %10.2f",
+                   (double)c[PERF_CYCLES] / recs,
+                   (double)c[PERF_INSTRUCTIONS] / recs,
+                   ipc,
+                   (double)c[PERF_BRANCH_MISSES] / recs,
+                   kb > 0 ? (double)c[PERF_L1D_MISSES] / kb : 0.0,
+                   kb > 0 ? (double)c[PERF_LLC_MISSES] / kb : 0.0);
+        }
+        printf("\n");
+    }
+
+    if (pc)
+    {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++)
+        {
+            if (!pc->available[e])
+            {
+                printf("NOTE: counter '%s' unavailable, reported as 0\n",
+                       perf_event_name((perf_event_id_t)e));
+            }
+        }
+    }
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+int main(int argc, char **argv)
+{
+    const char *input_file = NULL;
+    uint32_t synthetic_count = DEFAULT_RECORDS;
+    int iterations = DEFAULT_ITERATIONS;
+    int use_perf = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--perf") == 0)
+        {
+            use_perf = 1;
+        }
+        else if (strcmp(argv[i], "--records") == 0 && i + 1 < argc)
+        {
+            synthetic_count = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc)
+        {
+            simd_level_t level;
+            if (!simd_level_from_name(argv[++i], &level))
+            {
+                fprintf(stderr, "ERROR: Unknown SIMD level '%s'\n", argv[i]);
+                return 1;
+            }
+            simd_set_level(level);
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = atoi(argv[++i]);
+        }
+        else if (argv[i][0] == '-' && argv[i][1] == '-')
+        {
+            fprintf(stderr, "ERROR: Unknown option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+        else
+        {
+            input_file = argv[i];
+        }
+    }
+    if (iterations < 1)
+    {
+        iterations = 1;
+    }
+
+    FILE *fin = input_file ? fopen(input_file, "rb") : make_synthetic_file(synthetic_count);
+    if (!fin)
+    {
+        fprintf(stderr, "ERROR: Cannot open benchmark input\n");
+        return 1;
+    }
+    rewind(fin);
+
+    file_header_t header;
+    if (!read_header(&header, fin) || header.count == 0)
+    {
+        fprintf(stderr, "ERROR: Failed to read file header\n");
+        fclose(fin);
+        return 1;
+    }
+    // The buffers are sized from the count, so it must fit in the file
+    long file_size = fseek(fin, 0, SEEK_END) == 0 ? ftell(fin) : -1;
+    if (file_size < HEADER_SIZE ||
+        header.count > (uint64_t)(file_size - HEADER_SIZE) / RECORD_SIZE)
+    {
+        fprintf(stderr, "ERROR: Header claims %u records, the file holds %ld bytes\n",
+                header.count, file_size);
+        fclose(fin);
+        return 1;
+    }
+
+    weather_record_t *records = (weather_record_t*)malloc((size_t)header.count * sizeof(weather_record_t));
+    derived_metrics_t *derived = (derived_metrics_t*)malloc((size_t)header.count * sizeof(derived_metrics_t));
+    uint8_t *packed = (uint8_t*)malloc((size_t)header.count * RECORD_SIZE);
+    FILE *fjson = tmpfile();
+    if (!records || !derived || !packed || !fjson)
+    {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        free(records);
+        free(derived);
+        free(packed);
+        fclose(fin);
+        if (fjson)
+        {
+            fclose(fjson);
+        }
+        return 1;
+    }
+
+    perf_counters_t counters;
+    perf_counters_t *pc = NULL;
+    if (use_perf)
+    {
+        if (perf_counters_open(&counters) > 0)
+        {
+            pc = &counters;
+        }
+        else
+        {
+            fprintf(stderr, "WARNING: perf_event_open unavailable, reporting wall-clock only\n");
+        }
+    }
+
+    printf("Benchmark: %u records, %d iterations, simd %s%s\n", header.count, iterations,
+           simd_level_name(simd_level()), pc ? ", perf counters on" : "");
+
+    bench_result_t res[BENCH_STAGE_COUNT];
+    memset(res, 0, sizeof(res));
+    uint64_t t0;
+    uint32_t count = header.count;
+
+    for (int it = 0; it < iterations; it++)
+    {
+        // Stage: read_weather_record
+        fseek(fin, HEADER_SIZE, SEEK_SET);
+        stage_begin(pc, &t0);
+        uint32_t n = 0;
+        while (n < header.count && read_weather_record(&records[n], fin))
+        {
+            n++;
+        }
+        stage_end(pc, t0, (uint64_t)n * RECORD_SIZE, &res[BENCH_READ_RECORD]);
+        count = n;
+
+        // Stage: decode_weather_batch (from an in-memory copy of the file)
+        fseek(fin, HEADER_SIZE, SEEK_SET);
+        count = (uint32_t)(fread(packed, 1, (size_t)count * RECORD_SIZE, fin) / RECORD_SIZE);
+        stage_begin(pc, &t0);
+        decode_weather_batch(records, packed, count);
+        stage_end(pc, t0, (uint64_t)count * RECORD_SIZE, &res[BENCH_DECODE_BATCH]);
+
+        // Stage: derive_weather_batch (over the decoded records)
+        stage_begin(pc, &t0);
+        derive_weather_batch(derived, records, count);
+        stage_end(pc, t0, (uint64_t)count * RECORD_SIZE, &res[BENCH_DERIVE_BATCH]);
+
+        // Stage: write_json_record
+        rewind(fjson);
+        stage_begin(pc, &t0);
+        write_json_header(&header, fjson);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            write_json_record(&records[i], fjson, i == count - 1);
+        }
+        write_json_footer(fjson);
+        fflush(fjson);
+        long json_len = ftell(fjson);
+        stage_end(pc, t0, (uint64_t)json_len, &res[BENCH_WRITE_JSON]);
+
+        char *json_text = (char*)malloc((size_t)json_len + 1);
+        if (!json_text)
+        {
+            fprintf(stderr, "ERROR: Out of memory\n");
+            break;
+        }
+        rewind(fjson);
+        json_text[fread(json_text, 1, (size_t)json_len, fjson)] = '\0';
+
+        // Stage: cJSON_Parse
+        stage_begin(pc, &t0);
+        cJSON *root = cJSON_Parse(json_text);
+        stage_end(pc, t0, (uint64_t)json_len, &res[BENCH_CJSON_PARSE]);
+        free(json_text);
+        if (!root)
+        {
+            fprintf(stderr, "ERROR: cJSON_Parse failed on writer output (NaN/Inf values in input?)\n");
+            break;
+        }
+
+        // Stage: cJSON_Print
+        stage_begin(pc, &t0);
+        char *printed = cJSON_Print(root);
+        stage_end(pc, t0, 0, &res[BENCH_CJSON_PRINT]);
+        res[BENCH_CJSON_PRINT].bytes += printed ? strlen(printed) : 0;
+
+        free(printed);
+        cJSON_Delete(root);
+    }
+
+    print_results(res, count, iterations, pc);
+
+    if (pc)
+    {
+        perf_counters_close(pc);
+    }
+    free(records);
+    free(derived);
+    free(packed);
+    fclose(fjson);
+    fclose(fin);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+/**
+ * @file weather_client.c
+ * @brief Submit a conversion job to a running weather_parser --serve instance
+ *
+ * Prints the service response line and exits 0 when the job succeeded,
+ * so shell scripts can use it in place of a weather_parser invocation.
+ */
+
+/*********************
+ *    INCLUDES
+ *********************/
+#include "conv_service.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*********************
+ *  STATIC FUNCTIONS
+ *********************/
+static void print_usage(const char *program_name)
+{
+    printf("Usage: %s [options] input_file output_file\n", program_name);
+    printf("\n");
+    printf("Options:\n");
+    printf("  -h, --help       Show this help\n");
+    printf("  --socket PATH    Service socket (default: %s)\n", CONV_SERVICE_DEFAULT_SOCKET);
+    printf("  --format FORMAT  json (binary -> JSON, default) or bin (JSON -> binary)\n");
+    printf("  --dedup          Drop records repeating an earlier (sensor_id, timestamp)\n");
+    printf("  --derived        Add dew point, heat index and wind u/v to every record\n");
+    printf("  --iso-time       Write timestamps as ISO-8601 UTC strings\n");
+    printf("\n");
+}
+
+/* The service has its own working directory, so send absolute paths */
+static int absolute_path(const char *path, char *out, size_t size)
+{
+    if (path[0] == '/')
+    {
+        return snprintf(out, size, "%s", path) < (int)size;
+    }
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd)))
+    {
+        return 0;
+    }
+    return snprintf(out, size, "%s/%s", cwd, path) < (int)size;
+}
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+int main(int argc, char **argv)
+{
+    const char *socket_path = CONV_SERVICE_DEFAULT_SOCKET;
+    const char *format = "json";
+    int dedup = 0;
+    int derived = 0;
+    int iso_time = 0;
+    const char *positionals[2];
+    int n_positionals = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+        {
+            socket_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            format = argv[++i];
+        }
+        else if (strcmp(argv[i], "--dedup") == 0)
+        {
+            dedup = 1;
+        }
+        else if (strcmp(argv[i], "--derived") == 0)
+        {
+            derived = 1;
+        }
+        else if (strcmp(argv[i], "--iso-time") == 0)
+        {
+            iso_time = 1;
+        }
+        else if (argv[i][0] == '-' && argv[i][1] == '-')
+        {
+            fprintf(stderr, "ERROR: Unknown option '%s'\n", argv[i]);
+            print_usage(argv[0]);
+            return 1;
+        }
+        else if (n_positionals < 2)
+        {
+            positionals[n_positionals++] = argv[i];
+        }
+    }
+    if (n_positionals != 2)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    char input_path[PATH_MAX];
+    char output_path[PATH_MAX];
+    if (!absolute_path(positionals[0], input_path, sizeof(input_path)) ||
+        !absolute_path(positionals[1], output_path, sizeof(output_path)))
+    {
+        fprintf(stderr, "ERROR: Path too long\n");
+        return 1;
+    }
+
+    char filters[64] = "-";
+    size_t flen = 0;
+    const char *names[3] = { dedup ? "dedup" : NULL, derived ? "derived" : NULL, iso_time ? "iso-time" : NULL };
+    for (int i = 0; i < 3; i++)
+    {
+        if (names[i])
+        {
+            flen += (size_t)snprintf(filters + flen, sizeof(filters) - flen, "%s%s", flen ? "," : "", names[i]);
+        }
+    }
+    char request[CONV_SERVICE_MAX_LINE];
+    int len = snprintf(request, sizeof(request), "CONVERT\t%s\t%s\t%s\t%s\n",
+                       format, filters, input_path, output_path);
+    if (len < 0 || len >= (int)sizeof(request))
+    {
+        fprintf(stderr, "ERROR: Request too long\n");
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "ERROR: Socket path too long: %s\n", socket_path);
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        fprintf(stderr, "ERROR: Cannot connect to '%s': %s\n", socket_path, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return 1;
+    }
+    if (write(fd, request, (size_t)len) != len)
+    {
+        fprintf(stderr, "ERROR: Failed to send request: %s\n", strerror(errno));
+        close(fd);
+        return 1;
+    }
+
+    // The service answers with one line and closes the connection
+    char response[CONV_SERVICE_MAX_LINE];
+    size_t got = 0;
+    ssize_t n;
+    while (got + 1 < sizeof(response) &&
+           (n = read(fd, response + got, sizeof(response) - 1 - got)) > 0)
+    {
+        got += (size_t)n;
+    }
+    response[got] = '\0';
+    close(fd);
+
+    if (got == 0)
+    {
+        fprintf(stderr, "ERROR: No response from service\n");
+        return 1;
+    }
+    fputs(response, stdout);
+    return strncmp(response, "OK", 2) == 0 ? 0 : 1;
+}
\ No newline at end of file